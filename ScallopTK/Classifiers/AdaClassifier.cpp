@@ -103,9 +103,111 @@ bool AdaClassifier::loadClassifiers(
     return false;
   }
 
+  return loadCascade( clsParams );
+}
+
+// Loads early rejection stages, and calibrates thresholds if required
+bool AdaClassifier::loadCascade( const ClassifierParameters& clsParams )
+{
+  cascadeStages.clear();
+
+  for( int i = 0; i < clsParams.CascadeFiles.size(); i++ )
+  {
+    CascadeStage Stage;
+    Stage.threshold = 0.0;
+    string path_to_clfr = clsParams.CascadeFiles[i];
+    FILE *file_rdr = fopen(path_to_clfr.c_str(),"r");
+
+    // Check to make sure file is open
+    if( !file_rdr )
+    {
+      std::cout << "CRITICAL ERROR: Could not load cascade stage " << path_to_clfr << std::endl;
+      return false;
+    }
+
+    // Actually load classifier
+    bool loaded = Stage.adaTree.LoadFromFile(file_rdr);
+    fclose(file_rdr);
+
+    if( !loaded )
+    {
+      std::cout << "CRITICAL ERROR: Could not parse cascade stage " << path_to_clfr << std::endl;
+      return false;
+    }
+
+    // Stages only see the size and color features, see rejectCandidates
+    if( Stage.adaTree.MaxDimension() >= SIZE_FEATURES + COLOR_FEATURES )
+    {
+      std::cout << "CRITICAL ERROR: Cascade stage " << path_to_clfr
+                << " uses features other than size and color features" << std::endl;
+      return false;
+    }
+
+    if( i < clsParams.CascadeThresholds.size() )
+      Stage.threshold = clsParams.CascadeThresholds[i];
+
+    cascadeStages.push_back( Stage );
+  }
+
+  // Explicit thresholds take priority over calibration
+  if( cascadeStages.empty() || clsParams.CascadeThresholds.size() == cascadeStages.size() )
+    return true;
+
+  vector< vector< double > > positives;
+  if( !loadCheapFeatureSamples( clsParams.CascadeTrainingData,
+        clsParams.CascadeNegativeLabels, positives ) || positives.empty() )
+  {
+    std::cout << "CRITICAL ERROR: Could not load cascade training data "
+              << clsParams.CascadeTrainingData << std::endl;
+    return false;
+  }
+
+  calibrateCascade( positives, clsParams.CascadeRecall );
   return true;
 }
 
+// Sets every stage threshold to keep recall^(1/stages) of the positives
+// which survive all previous stages, so the whole cascade keeps recall
+void AdaClassifier::calibrateCascade(
+  const vector< vector< double > >& positives,
+  double recall )
+{
+  const double stageRecall = pow( max( min( recall, 1.0 ), 0.0 ), 1.0 / cascadeStages.size() );
+
+  // Size features which depend on the edge search are not yet known when
+  // the cascade runs, so calibrate with the same placeholder values
+  vector< vector< double > > samples( positives );
+  for( int i = 0; i < samples.size(); i++ )
+  {
+    samples[i][7] = 1;
+    samples[i][8] = 1;
+  }
+
+  for( int s = 0; s < cascadeStages.size(); s++ )
+  {
+    if( samples.empty() )
+      break;
+
+    vector< double > scores( samples.size() );
+    for( int i = 0; i < samples.size(); i++ )
+      scores[i] = cascadeStages[s].adaTree.Predict( &samples[i][0] );
+
+    vector< double > sorted( scores );
+    int rank = (int)( ( 1.0 - stageRecall ) * sorted.size() );
+    rank = min( rank, (int)sorted.size() - 1 );
+    nth_element( sorted.begin(), sorted.begin() + rank, sorted.end() );
+    cascadeStages[s].threshold = sorted[rank];
+
+    vector< vector< double > > survivors;
+    for( int i = 0; i < samples.size(); i++ )
+    {
+      if( scores[i] >= cascadeStages[s].threshold )
+        survivors.push_back( samples[i] );
+    }
+    samples.swap( survivors );
+  }
+}
+
 
 // td; Use a binary file next time
 int AdaClassifier::classifyCandidate( cv::Mat image, Candidate* cd )
@@ -201,6 +303,42 @@ void AdaClassifier::classifyCandidates(
   }
 }
 
+void AdaClassifier::rejectCandidates(
+  CandidatePtrVector& candidates,
+  CandidatePtrVector& survivors )
+{
+  survivors.clear();
+
+  double input[SIZE_FEATURES+COLOR_FEATURES];
+
+  for( unsigned int i=0; i<candidates.size(); i++ ) {
+
+    Candidate* cd = candidates[i];
+
+    if( !cd->isActive )
+      continue;
+
+    // Stages share the leading layout of the full feature vector
+    int pos = 0;
+    for( int j=0; j<SIZE_FEATURES; j++ )
+      input[pos++] = cd->sizeFeatures[j];
+    for( int j=0; j<COLOR_FEATURES; j++ )
+      input[pos++] = cd->colorFeatures[j];
+
+    bool rejected = false;
+    for( unsigned int s=0; s<cascadeStages.size() && !rejected; s++ ) {
+      rejected = ( cascadeStages[s].adaTree.Predict( input ) < cascadeStages[s].threshold );
+    }
+
+    if( rejected ) {
+      cd->isActive = false;
+      cd->classification = UNCLASSIFIED;
+    } else {
+      survivors.push_back( cd );
+    }
+  }
+}
+
 void AdaClassifier::extractSamples(
   cv::Mat /*image*/,
   CandidatePtrVector& candidates,
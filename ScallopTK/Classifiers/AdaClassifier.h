@@ -57,6 +57,16 @@ public:
   // Does this classifier have anything to do with scallop detection?
   bool detectsScallops() { return isScallopDirected; }
 
+  // Does this classifier have an early rejection cascade?
+  bool hasCascade() { return !cascadeStages.empty(); }
+
+  // Reject candidates using only their size and color features
+  //
+  // Candidates the input candidates, with size and color features computed
+  // Survivors will contain any candidates which need full feature extraction
+  void rejectCandidates( CandidatePtrVector& candidates,
+    CandidatePtrVector& survivors );
+
   // Extract training samples
   //
   // Image should contain the input image
@@ -89,8 +99,28 @@ private:
 
   typedef std::vector< SingleAdaClassifier > AdaVector;
 
-  // Helper function
+  // A committee trained on size and color features, and its reject threshold
+  class CascadeStage
+  {
+  public:
+
+    // Stage committee
+    SingleAdaTree adaTree;
+
+    // Candidates scoring below this are rejected
+    double threshold;
+  };
+
+  typedef std::vector< CascadeStage > CascadeVector;
+
+  // Helper functions
   int classifyCandidate( cv::Mat image, Candidate* candidate );
+  bool loadCascade( const ClassifierParameters& clsParams );
+  void calibrateCascade( const std::vector< std::vector< double > >& positives,
+    double recall );
+
+  // Early rejection stages, empty if no cascade is used
+  CascadeVector cascadeStages;
 
   // Tier 1 classifeirs
   AdaVector mainClassifiers;
@@ -20,6 +20,7 @@ CNNClassifier::CNNClassifier()
   suppressionClfr = NULL;
   isScallopDirected = false;
   preClass = NULL;
+  batchTimeout = 0.0;
 }
 
 CNNClassifier::~CNNClassifier()
@@ -63,6 +64,7 @@ bool CNNClassifier::loadClassifiers(
   isTrainingMode = sysParams.IsTrainingMode;
   outputFolder = sysParams.OutputDirectory;
   trainingPercentKeep = sysParams.TrainingPercentKeep;
+  batchTimeout = sysParams.CNNBatchTimeout;
 
   // Auto-detect which GPU to use based on highest memory count
   deviceMode = Caffe::CPU;
@@ -175,6 +177,10 @@ bool CNNClassifier::loadClassifiers(
     }
   }
 
+  // Chips from concurrent frames are batched per network
+  resetQueue( initialQueue, initialClfr );
+  resetQueue( suppressionQueue, suppressionClfr );
+
   // Load Labels Vectors
   if( clsParams.L1Keys.size() != clsParams.L1SpecTypes.size() )
   {
@@ -239,134 +245,265 @@ bool CNNClassifier::loadClassifiers(
   return true;
 }
 
-unsigned CNNClassifier::classifyCandidates(
-  cv::Mat image,
-  CandidatePtrVector& candidates,
-  CandidatePtrVector& positive,
-  CNN& classifier, double threshold )
+void CNNClassifier::resetQueue( BatchQueue& queue, CNN* net )
 {
-  unsigned good_count = 0;
+  queue.net = net;
+  queue.pending.clear();
+  queue.pendingChips = 0;
+  queue.extracting = 0;
+  queue.running = false;
 
-  // Perform initial classification
-  if( image.cols > 0 && image.rows > 0 )
+  if( net )
   {
-    // Create pointer to input blob
-    Blob< float >* inputBlob = classifier.input_blobs()[0];
+    Blob< float >* inputBlob = net->input_blobs()[0];
+
+    queue.capacity = inputBlob->num();
+    queue.channels = inputBlob->channels();
+    queue.chipHeight = inputBlob->height();
+    queue.chipWidth = inputBlob->width();
+    queue.categories = net->output_blobs()[0]->channels();
+  }
+}
 
-    // Get batch size and input parameters from model
-    const unsigned totalCandidates = candidates.size();
-    const unsigned batchSize = inputBlob->num();
-    const unsigned channels = inputBlob->channels();
-    const unsigned chipHeight = inputBlob->height();
-    const unsigned chipWidth = inputBlob->width();
+void CNNClassifier::runBatch( BatchQueue& queue )
+{
+  // Take up to a full batch of queued chips, oldest first (must hold lock)
+  std::vector< BatchSegment > segments;
+  unsigned batchSize = 0;
+
+  while( batchSize < queue.capacity && !queue.pending.empty() )
+  {
+    BatchRequest* request = queue.pending.front();
 
-    // Iterate over all candidates, extracting chips and computing propabilities
-    int entry = 0;
+    BatchSegment segment;
+    segment.request = request;
+    segment.first = request->next;
+    segment.count = (std::min)( (unsigned)request->chips.size() - request->next,
+      queue.capacity - batchSize );
 
-    while( entry < totalCandidates )
+    request->next += segment.count;
+    batchSize += segment.count;
+    segments.push_back( segment );
+
+    if( request->next == request->chips.size() )
     {
-      // Formate input data
-      int batchPosition = 0;
-      std::vector< int > batchIndices;
+      queue.pending.pop_front();
+    }
+  }
 
-      for( ; entry < totalCandidates && batchPosition < batchSize;
-           entry++, batchPosition++ )
-      {
-        // Extract image chip for candidate, if possible
-        cv::Mat chip = getCandidateChip( image, candidates[entry], chipWidth, chipHeight );
+  queue.pendingChips -= batchSize;
+  queue.running = true;
+  queue.monitor.unlock();
 
-        if( chip.rows == 0 || chip.cols == 0 )
-        {
-          candidates[entry]->classification = UNCLASSIFIED;
-          batchPosition--;
-        }
-        else
-        {
-          // Add chip to batch
-          batchIndices.push_back( entry );
+  // Only run the network over as many chips as were batched
+  CNN& classifier = *queue.net;
+  Blob< float >* inputBlob = classifier.input_blobs()[0];
 
-          for( int p = 0; p < channels; p++ )
-          {
-            float *rowStart = inputBlob->mutable_cpu_data() + inputBlob->offset( batchPosition, p );
+  if( inputBlob->num() != batchSize )
+  {
+    inputBlob->Reshape( batchSize, queue.channels, queue.chipHeight, queue.chipWidth );
+    classifier.Reshape();
+  }
+
+  // Formate input data
+  const ptrdiff_t rowOffset = inputBlob->offset( 0, 0, 1, 0 );
+  const ptrdiff_t colOffset = inputBlob->offset( 0, 0, 0, 1 );
+
+  int batchPosition = 0;
+
+  for( unsigned s = 0; s < segments.size(); s++ )
+  {
+    for( unsigned k = 0; k < segments[s].count; k++, batchPosition++ )
+    {
+      const cv::Mat& chip = segments[s].request->chips[ segments[s].first + k ];
 
-            const ptrdiff_t rowOffset = inputBlob->offset( 0, 0, 1, 0 );
-            const ptrdiff_t colOffset = inputBlob->offset( 0, 0, 0, 1 );
+      for( int p = 0; p < queue.channels; p++ )
+      {
+        float *rowStart = inputBlob->mutable_cpu_data() + inputBlob->offset( batchPosition, p );
 
-            for( int r = 0; r < chipHeight; r++, rowStart += rowOffset )
-            {
-              float* colPos = rowStart;
+        for( int r = 0; r < queue.chipHeight; r++, rowStart += rowOffset )
+        {
+          float* colPos = rowStart;
 
-              for( int c = 0; c < chipWidth; c++, colPos += colOffset )
-              {
-                *colPos = float( chip.at< cv::Vec3b >( r, c ).val[ p ] ) - 128.0f;
-              }
-            }
+          for( int c = 0; c < queue.chipWidth; c++, colPos += colOffset )
+          {
+            *colPos = float( chip.at< cv::Vec3b >( r, c ).val[ p ] ) - 128.0f;
           }
         }
       }
+    }
+  }
+
+  // Process batch, starting with resetting operating mode for this thread
+  Caffe::set_mode( deviceMode );
+
+  if( deviceMode == Caffe::GPU && deviceID >= 0 )
+  {
+    Caffe::SetDevice( deviceID );
+  }
 
-      // Process latest compiled batch, starting with resetting operating mode
-      Caffe::set_mode( deviceMode );
+  classifier.ForwardPrefilled();
 
-      if( deviceMode == Caffe::GPU && deviceID >= 0 )
+  // Route outputs back to the requests they came from
+  Blob< float >* outputBlob = classifier.output_blobs()[0];
+
+  batchPosition = 0;
+
+  for( unsigned s = 0; s < segments.size(); s++ )
+  {
+    float* scores = &segments[s].request->scores[ segments[s].first * queue.categories ];
+
+    for( unsigned k = 0; k < segments[s].count; k++, batchPosition++ )
+    {
+      for( int j = 0; j < queue.categories; j++ )
       {
-        Caffe::SetDevice( deviceID );
+        *(scores++) = outputBlob->data_at( batchPosition, j, 0, 0 );
       }
+    }
+  }
+
+  queue.monitor.lock();
+  queue.running = false;
+
+  for( unsigned s = 0; s < segments.size(); s++ )
+  {
+    segments[s].request->finished += segments[s].count;
+  }
+
+  queue.monitor.notifyAll();
+}
 
-      // Process CNN
-      classifier.ForwardPrefilled();
+unsigned CNNClassifier::classifyCandidates(
+  cv::Mat image,
+  CandidatePtrVector& candidates,
+  CandidatePtrVector& positive,
+  BatchQueue& queue, double threshold )
+{
+  unsigned good_count = 0;
+
+  // Perform initial classification
+  if( image.cols > 0 && image.rows > 0 )
+  {
+    // Extract chips for all candidates, batches wait on callers doing so
+    {
+      MonitorLock lock( queue.monitor );
+      queue.extracting++;
+    }
+
+    BatchRequest request;
+    std::vector< unsigned > requestIndices;
 
-      // Receive output from CNN, inject back in candidate and threshold
-      Blob< float >* outputBlob = classifier.output_blobs()[0];
+    for( unsigned entry = 0; entry < candidates.size(); entry++ )
+    {
+      // Extract image chip for candidate, if possible
+      cv::Mat chip = getCandidateChip( image, candidates[entry],
+        queue.chipWidth, queue.chipHeight );
 
-      for( int i = 0; i < batchPosition; i++ )
+      if( chip.rows == 0 || chip.cols == 0 )
       {
-        unsigned categories = outputBlob->channels();
-        unsigned cid = batchIndices[i];
+        candidates[entry]->classification = UNCLASSIFIED;
+      }
+      else
+      {
+        request.chips.push_back( chip );
+        requestIndices.push_back( entry );
+      }
+    }
 
-#ifdef max
-  #undef max
-#endif
-        double maxValue = -1 * std::numeric_limits< double >::max();
-        int maxInd = 0;
+    request.scores.resize( request.chips.size() * queue.categories );
+    request.next = 0;
+    request.finished = 0;
+
+    // Queue chips alongside those of other frames, then run or wait on
+    // batches until all of ours are scored
+    {
+      MonitorLock lock( queue.monitor );
+
+      queue.extracting--;
+
+      if( !request.chips.empty() )
+      {
+        request.queuedTick = cv::getTickCount();
+        queue.pending.push_back( &request );
+        queue.pendingChips += request.chips.size();
+      }
 
-        bool criteria1 = false; // Exceeds threshold requirement
-        bool criteria2 = false; // Non-background category is top
+      queue.monitor.notifyAll();
 
-        for( int j = 0; j < categories; j++ )
+      while( request.finished < request.chips.size() )
+      {
+        if( !queue.running && queue.pendingChips > 0 )
         {
-          double prop = outputBlob->data_at( i, j, 0, 0 );
-          candidates[cid]->classMagnitudes[j] = ( j == 0 ? -1.0 : prop );
+          double waited = ( cv::getTickCount() - queue.pending.front()->queuedTick ) /
+            cv::getTickFrequency();
 
-          if( prop > maxValue )
+          if( queue.pendingChips >= queue.capacity ||
+              ( queue.extracting == 0 && waited >= batchTimeout ) )
           {
-            maxValue = prop;
-            maxInd = j;
+            runBatch( queue );
+            continue;
           }
-
-          if( prop >= threshold && j != 0 )
+          else if( queue.extracting == 0 )
           {
-            criteria1 = true;
+            queue.monitor.wait( batchTimeout - waited );
+            continue;
           }
         }
 
-        criteria2 = ( maxInd != 0 );
+        queue.monitor.wait();
+      }
+    }
 
-        if( criteria2 )
-        {
-          good_count++;
-        }
+    // Inject outputs back in candidates and threshold
+    const unsigned categories = queue.categories;
+
+    for( unsigned i = 0; i < requestIndices.size(); i++ )
+    {
+      unsigned cid = requestIndices[i];
+      const float* scores = &request.scores[ i * categories ];
+
+#ifdef max
+  #undef max
+#endif
+      double maxValue = -1 * std::numeric_limits< double >::max();
+      int maxInd = 0;
+
+      bool criteria1 = false; // Exceeds threshold requirement
+      bool criteria2 = false; // Non-background category is top
 
-        if( criteria1 || criteria2 )
+      for( int j = 0; j < categories; j++ )
+      {
+        double prop = scores[j];
+        candidates[cid]->classMagnitudes[j] = ( j == 0 ? -1.0 : prop );
+
+        if( prop > maxValue )
         {
-          candidates[cid]->classification = maxInd;
-          positive.push_back( candidates[cid] );
+          maxValue = prop;
+          maxInd = j;
         }
-        else
+
+        if( prop >= threshold && j != 0 )
         {
-          candidates[cid]->classification = UNCLASSIFIED;
+          criteria1 = true;
         }
       }
+
+      criteria2 = ( maxInd != 0 );
+
+      if( criteria2 )
+      {
+        good_count++;
+      }
+
+      if( criteria1 || criteria2 )
+      {
+        candidates[cid]->classification = maxInd;
+        positive.push_back( candidates[cid] );
+      }
+      else
+      {
+        candidates[cid]->classification = UNCLASSIFIED;
+      }
     }
   }
   else
@@ -393,7 +530,7 @@ void CNNClassifier::classifyCandidates(
   }
   else
   {
-    this->classifyCandidates( image, candidates, positive, *initialClfr, initialThreshold );
+    this->classifyCandidates( image, candidates, positive, initialQueue, initialThreshold );
   }
 
   if( suppressionClfr )
@@ -402,7 +539,7 @@ void CNNClassifier::classifyCandidates(
 
     resetClassificationValues( candidates );
     
-    if( this->classifyCandidates( image, positive, newPositives, *suppressionClfr, secondThreshold ) > 20 )
+    if( this->classifyCandidates( image, positive, newPositives, suppressionQueue, secondThreshold ) > 20 )
     {
       newPositives.clear();
       thresholdClassificationMag( positive, newPositives, 10e-8 );
@@ -490,7 +627,7 @@ void CNNClassifier::extractSamples(
   }
   else if( suppressionClfr )
   {
-    this->classifyCandidates( image, candidates, candidatesToUse, *initialClfr, initialThreshold );
+    this->classifyCandidates( image, candidates, candidatesToUse, initialQueue, initialThreshold );
     classifier = suppressionClfr;
   }
   else
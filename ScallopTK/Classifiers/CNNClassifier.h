@@ -7,6 +7,7 @@
 
 //Standard C/C++
 #include <vector>
+#include <deque>
 
 //OpenCV
 #include <cv.h>
@@ -16,6 +17,7 @@
 
 //Scallop Includes
 #include "ScallopTK/Utilities/Definitions.h"
+#include "ScallopTK/Utilities/Threads.h"
 #include "ScallopTK/Classifiers/Classifier.h"
 #include "ScallopTK/Classifiers/AdaClassifier.h"
 
@@ -43,6 +45,9 @@ public:
   // Image should contain the input image
   // Candidates the input candidates to score
   // Positive will contain any candidates with positive classifications
+  //
+  // Safe to call concurrently, each network is only run by one caller at a
+  // time through its batch queue
   virtual void classifyCandidates( cv::Mat image,
     CandidatePtrVector& candidates,
     CandidatePtrVector& positive );
@@ -76,13 +81,61 @@ private:
   typedef caffe::Net< float > CNN;
   typedef caffe::Caffe::Brew DeviceMode;
 
+  // Chips from one classifyCandidates call, and their network outputs
+  struct BatchRequest
+  {
+    std::vector< cv::Mat > chips;
+    std::vector< float > scores;
+    int64 queuedTick;
+    unsigned next;
+    unsigned finished;
+  };
+
+  // Part of a request placed in a batch
+  struct BatchSegment
+  {
+    BatchRequest* request;
+    unsigned first;
+    unsigned count;
+  };
+
+  // Chips waiting on one network, shared by all concurrent callers
+  //
+  // Callers queue their chips then wait, and whichever caller finds a batch
+  // ready runs it for everyone. A batch is ready once full, or once no
+  // caller is still extracting chips and the oldest queued chip has waited
+  // the batch timeout. The monitor also keeps calls into the net serial.
+  struct BatchQueue
+  {
+    CNN* net;
+    unsigned capacity;
+    unsigned channels;
+    unsigned chipHeight;
+    unsigned chipWidth;
+    unsigned categories;
+    Monitor monitor;
+    std::deque< BatchRequest* > pending;
+    unsigned pendingChips;
+    unsigned extracting;
+    bool running;
+
+    BatchQueue() : net( NULL ), capacity( 0 ), channels( 0 ), chipHeight( 0 ),
+      chipWidth( 0 ), categories( 0 ), pendingChips( 0 ), extracting( 0 ),
+      running( false ) {}
+  };
+
   // Main (initial) classifier applied to all candidates
   CNN* initialClfr;
   IDVector initialClfrLabels;
+  BatchQueue initialQueue;
 
   // Optional suppression classifiers
   CNN* suppressionClfr;
   IDVector suppressionClfrLabels;
+  BatchQueue suppressionQueue;
+
+  // Seconds a partly filled batch waits for chips from other callers
+  double batchTimeout;
 
   // Is this system aimed at scallops or something entirely different?
   bool isScallopDirected;
@@ -112,7 +165,10 @@ private:
   unsigned classifyCandidates( cv::Mat image,
     CandidatePtrVector& candidates,
     CandidatePtrVector& positive,
-    CNN& classifier, double threshold );
+    BatchQueue& queue, double threshold );
+
+  void resetQueue( BatchQueue& queue, CNN* net );
+  void runBatch( BatchQueue& queue );
 
 };
 
@@ -90,6 +90,8 @@ int ellipseIntersectStatus( Candidate* cd1, Candidate *cd2 ) {
   return 0;
 }
 
+float circleOverlap( float r1, float c1, float rad1, float r2, float c2, float rad2 );
+
 float ellipseIntersectStatus2( Candidate* cd1, Candidate *cd2 ) {
 
   // Calculate area of overlap (assumes circles)
@@ -126,10 +128,16 @@ float ellipseIntersectStatus2( Candidate* cd1, Candidate *cd2 ) {
   }
   return area / ( PI * Rsq );*/
 
-  float r = cd1->major;
-  float R = cd2->major;
-  float xdif = (cd1->r - cd2->r);
-  float ydif = (cd1->c - cd2->c);
+  return circleOverlap( cd1->r, cd1->c, cd1->major, cd2->r, cd2->c, cd2->major );
+}
+
+// Approximate fraction of the smaller circle covered by the larger one
+float circleOverlap( float r1, float c1, float rad1, float r2, float c2, float rad2 ) {
+
+  float r = rad1;
+  float R = rad2;
+  float xdif = (r1 - r2);
+  float ydif = (c1 - c2);
   float distsq = xdif*xdif + ydif*ydif;
   float d = sqrt( distsq );
 
@@ -298,6 +306,42 @@ void removeInsidePoints( CandidatePtrVector& input, CandidatePtrVector& output )
   }
 }
 
+// Best classification value of a detection
+double bestClassProbability( const Detection& obj ) {
+  double best = -std::numeric_limits<double>::max();
+  for( unsigned int i=0; i<obj.classProbabilities.size(); i++ ) {
+    best = max( best, obj.classProbabilities[i] );
+  }
+  return best;
+}
+
+// Sorting function 3 - sort detections by best classification value
+bool sortDetectionsByMag( const Detection& obj1, const Detection& obj2 ) {
+  return bestClassProbability( obj1 ) > bestClassProbability( obj2 );
+}
+
+void removeInsideDetections( DetectionVector& input, DetectionVector& output ) {
+
+  // Sort input vector by classification magnitude
+  stable_sort( input.begin(), input.end(), sortDetectionsByMag );
+
+  // Take local max non-overlapping detections, as in removeInsidePoints
+  for( unsigned int i=0; i<input.size(); i++ ) {
+
+    bool add_entry = true;
+    for( unsigned int j=0; j<output.size(); j++ ) {
+      float perc_overlap = circleOverlap( output[j].r, output[j].c, output[j].major,
+        input[i].r, input[i].c, input[i].major );
+      if( perc_overlap > 0.25 ) {
+        add_entry = false;
+        break;
+      }
+    }
+    if( add_entry )
+      output.push_back( input[i] );
+  }
+}
+
 void takeTopCandidates( CandidatePtrVector& input,
   CandidatePtrVector& output, unsigned count )
 {
@@ -494,6 +538,8 @@ DetectionPtrVector interpolateResults( CandidatePtrVector& input,
     obj->angle = input[i]->angle;
     obj->major = input[i]->major;
     obj->minor = input[i]->minor;
+    if( !input[i]->fullContour.empty() )
+      obj->cntr = *input[i]->fullContour;
 
     ClassifierIDLabel* labelInfo;
     int best_class = input[i]->classification;
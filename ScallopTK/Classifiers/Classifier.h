@@ -66,6 +66,9 @@ public:
   // Image should contain the input image
   // Candidates the input candidates to score
   // Positive will contain any candidates with positive classifications
+  //
+  // Tile workers and asynchronous frames share one classifier, so this may
+  // be called from several threads at once
   virtual void classifyCandidates( cv::Mat image,
     CandidatePtrVector& candidates,
     CandidatePtrVector& positive ) = 0;
@@ -76,6 +79,16 @@ public:
   // Does this classifier have anything to do with scallop detection?
   virtual bool detectsScallops() = 0;
 
+  // Does this classifier have an early rejection cascade?
+  virtual bool hasCascade() { return false; }
+
+  // Reject candidates using only their size and color features
+  //
+  // Candidates the input candidates, with size and color features computed
+  // Survivors will contain any candidates which need full feature extraction
+  virtual void rejectCandidates( CandidatePtrVector& candidates,
+    CandidatePtrVector& survivors ) { survivors = candidates; }
+
   // Extract training samples
   //
   // Image should contain the input image
@@ -106,6 +119,11 @@ void removeInsidePoints( CandidatePtrVector& input,
 void removeInsidePoints( CandidatePtrVector& input,
   CandidatePtrVector& output );
 
+// Suppress overlapping final detections, such as the same object found in
+// two neighbouring tiles, keeping the strongest
+void removeInsideDetections( DetectionVector& input,
+  DetectionVector& output );
+
 // Take the top candidates by magnitude
 void takeTopCandidates( CandidatePtrVector& input,
   CandidatePtrVector& output, unsigned count );
@@ -500,5 +500,39 @@ void dumpCandidateFeatures( string file_name, CandidatePtrVector& cd )
   
   ip_out.close();
 }
+bool loadCheapFeatureSamples( const string& file_name,
+  const vector< string >& negativeLabels,
+  vector< vector< double > >& positives )
+{
+  ifstream ip_in( file_name.c_str() );
+
+  if( !ip_in )
+    return false;
+
+  const int cheapFeatures = SIZE_FEATURES + COLOR_FEATURES;
+  string line, label;
+
+  while( getline( ip_in, line ) )
+  {
+    istringstream strm( line );
+
+    if( !( strm >> label ) )
+      continue;
+
+    if( find( negativeLabels.begin(), negativeLabels.end(), label ) != negativeLabels.end() )
+      continue;
+
+    // Only the leading features are needed, leave the rest of the line unparsed
+    vector< double > sample( cheapFeatures );
+    int read = 0;
+    while( read < cheapFeatures && strm >> sample[read] )
+      read++;
+
+    if( read == cheapFeatures )
+      positives.push_back( sample );
+  }
+
+  return true;
+}
 
 }
@@ -13,6 +13,7 @@
 #include <map>
 #include <vector>
 #include <cmath>
+#include <algorithm>
 
 //Opencv
 #include <cv.h>
@@ -61,6 +62,12 @@ bool getDesignationsFromUser( CandidateQueue& OrderedCandidates,
 // Print out features to given file in GT mode
 void dumpCandidateFeatures( string file_name, CandidatePtrVector& cd );
 
+// Read the size and color features of every non-negative sample in a file
+// written by dumpCandidateFeatures, all later features are skipped
+bool loadCheapFeatureSamples( const string& file_name,
+  const vector< string >& negativeLabels,
+  vector< vector< double > >& positives );
+
 }
 
 #endif
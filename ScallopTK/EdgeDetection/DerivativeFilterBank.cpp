@@ -0,0 +1,142 @@
+
+#include "DerivativeFilterBank.h"
+
+namespace ScallopTK
+{
+
+//------------------------------------------------------------------------------
+//                              Kernel Cache
+//------------------------------------------------------------------------------
+
+static cv::Mutex derivBankLock;
+static map< float, cv::Ptr<DerivativeFilterBank> > derivBankCache;
+
+//Returns the shared bank for a sigma, building its kernel on first use
+cv::Ptr<DerivativeFilterBank> DerivativeFilterBank::get( double sigma ) {
+
+  cv::AutoLock lock( derivBankLock );
+
+  map< float, cv::Ptr<DerivativeFilterBank> >::iterator itr = derivBankCache.find( (float)sigma );
+  if( itr != derivBankCache.end() ) {
+    return itr->second;
+  }
+
+  //Sigmas scale with image metadata, so bound the cache (held banks stay valid)
+  if( derivBankCache.size() >= MAX_CACHED_DERIV_KERNELS ) {
+    derivBankCache.clear();
+  }
+
+  cv::Ptr<DerivativeFilterBank> bank = new DerivativeFilterBank( sigma );
+  derivBankCache[ (float)sigma ] = bank;
+  return bank;
+}
+
+//Builds the anti-symmetric half of the 1-D gaussian derivative kernel
+DerivativeFilterBank::DerivativeFilterBank( double sigma ) {
+  int filter_size = sigma * KERNEL_SIZE_PER_SIGMA;
+  filter_size = filter_size + (filter_size+1)%2;
+  int center = filter_size / 2;
+  float sig2 = sigma * sigma;
+  float sig3 = sigma * sig2;
+  taps.resize( center );
+  for( int p=1; p<=center; p++ ) {
+    float pos = p;
+    taps[p-1] = (pos/sig3)*exp(-pos*pos/(2*sig2));
+  }
+}
+
+//------------------------------------------------------------------------------
+//                                Filtering
+//------------------------------------------------------------------------------
+
+//out[i] = sum_p taps[p-1] * ( lo[p-1][i] - hi[p-1][i] ) for i in [0,n)
+static void accumulateTaps( const float *taps, int radius, const float **lo,
+  const float **hi, int n, float *out ) {
+
+  int i = 0;
+#if SCALLOP_TK_SSE2
+  for( ; i <= n-4; i+=4 ) {
+    __m128 acc = _mm_setzero_ps();
+    for( int p=0; p<radius; p++ ) {
+      __m128 diff = _mm_sub_ps( _mm_loadu_ps( lo[p]+i ), _mm_loadu_ps( hi[p]+i ) );
+      acc = _mm_add_ps( acc, _mm_mul_ps( _mm_set1_ps( taps[p] ), diff ) );
+    }
+    _mm_storeu_ps( out+i, acc );
+  }
+#endif
+  for( ; i < n; i++ ) {
+    float acc = 0.0f;
+    for( int p=0; p<radius; p++ ) {
+      acc += taps[p] * ( lo[p][i] - hi[p][i] );
+    }
+    out[i] = acc;
+  }
+}
+
+//Computes horizontal and vertical derivatives in a single pass over rows
+void DerivativeFilterBank::filter( IplImage *input, IplImage *dx, IplImage *dy ) const {
+
+  assert( input->depth == IPL_DEPTH_32F );
+  assert( !dx || ( dx->depth == IPL_DEPTH_32F && dx->nChannels == input->nChannels ) );
+  assert( !dy || ( dy->depth == IPL_DEPTH_32F && dy->nChannels == input->nChannels ) );
+
+  const int radius = this->radius();
+  if( radius == 0 ) {
+    if( dx ) cvZero( dx );
+    if( dy ) cvZero( dy );
+    return;
+  }
+
+  const int cn = input->nChannels;
+  const int width = input->width;
+  const int height = input->height;
+  const int n = width * cn;
+  const int pad = radius * cn;
+
+  //Row buffer with replicated borders, and per-tap neighbour pointers
+  vector<float> padded( n + 2*pad );
+  vector<const float*> lo( radius );
+  vector<const float*> hi( radius );
+
+  for( int r=0; r<height; r++ ) {
+
+    const float *src = (float*)(input->imageData + input->widthStep*r);
+
+    //Horizontal pass on the current row
+    if( dx ) {
+      float *row = &padded[0] + pad;
+      memcpy( row, src, n * sizeof(float) );
+      for( int b=1; b<=radius; b++ ) {
+        for( int c=0; c<cn; c++ ) {
+          row[-b*cn+c] = src[c];
+          row[n-cn+b*cn+c] = src[n-cn+c];
+        }
+      }
+      for( int p=1; p<=radius; p++ ) {
+        lo[p-1] = row - p*cn;
+        hi[p-1] = row + p*cn;
+      }
+      float *out = (float*)(dx->imageData + dx->widthStep*r);
+      accumulateTaps( &taps[0], radius, &lo[0], &hi[0], n, out );
+    }
+
+    //Vertical pass using clamped rows of the input
+    if( dy ) {
+      for( int p=1; p<=radius; p++ ) {
+        int above = max( r-p, 0 );
+        int below = min( r+p, height-1 );
+        lo[p-1] = (float*)(input->imageData + input->widthStep*above);
+        hi[p-1] = (float*)(input->imageData + input->widthStep*below);
+      }
+      float *out = (float*)(dy->imageData + dy->widthStep*r);
+      accumulateTaps( &taps[0], radius, &lo[0], &hi[0], n, out );
+    }
+  }
+}
+
+//Directional derivative from the two axis derivatives
+void DerivativeFilterBank::steer( IplImage *dx, IplImage *dy, float angle, IplImage *output ) {
+  cvAddWeighted( dx, cos( angle ), dy, sin( angle ), 0.0, output );
+}
+
+}
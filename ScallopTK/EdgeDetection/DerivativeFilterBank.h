@@ -0,0 +1,82 @@
+#ifndef SCALLOP_TK_DERIVATIVE_FILTER_BANK_H_
+#define SCALLOP_TK_DERIVATIVE_FILTER_BANK_H_
+
+//------------------------------------------------------------------------------
+//                               Include Files
+//------------------------------------------------------------------------------
+
+//Standard C/C++
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <iostream>
+#include <map>
+#include <vector>
+#include <cmath>
+
+//Opencv
+#include <cv.h>
+#include <cxcore.h>
+
+//Scallop Includes
+#include "ScallopTK/Utilities/Definitions.h"
+#include "ScallopTK/Utilities/SIMD.h"
+#include "ScallopTK/Utilities/Threads.h"
+
+namespace ScallopTK
+{
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+//                                 Constants
+//------------------------------------------------------------------------------
+
+//Gaussian derivative kernel width, in multiples of sigma
+const float KERNEL_SIZE_PER_SIGMA = 6;
+
+//Maximum number of distinct sigmas kept in the shared kernel cache
+const unsigned int MAX_CACHED_DERIV_KERNELS = 32;
+
+//------------------------------------------------------------------------------
+//                           Filter Bank Prototype
+//------------------------------------------------------------------------------
+
+// 1-D Gaussian derivative filters for a single sigma
+//
+// Kernels are built once per sigma and shared by all threads. Filtering
+// computes the horizontal and vertical derivative together in one pass
+// over the input, and matches a cvFilter2D of the equivalent 1-D kernel
+// with replicated borders. Diagonal derivatives are steered from dx/dy.
+class DerivativeFilterBank {
+public:
+  ~DerivativeFilterBank() {}
+
+  // Returns the shared bank for the given sigma, building it on first use
+  static cv::Ptr<DerivativeFilterBank> get( double sigma );
+
+  // Computes derivatives of a 32f image of any channel count, dx and dy
+  // must be 32f images matching input and not aliasing it. Either output
+  // may be NULL.
+  void filter( IplImage *input, IplImage *dx, IplImage *dy ) const;
+
+  // Computes the derivative along angle (radians, x towards y) into output
+  static void steer( IplImage *dx, IplImage *dy, float angle, IplImage *output );
+
+  // Kernel radius (taps either side of the center)
+  int radius() const { return (int)taps.size(); }
+
+private:
+
+  // Only created through get
+  explicit DerivativeFilterBank( double sigma );
+
+  // Kernel is anti-symmetric, only weights for offsets 1..radius are kept
+  // so that out(x) = sum_p taps[p-1] * ( in(x-p) - in(x+p) )
+  vector<float> taps;
+};
+
+}
+
+#endif
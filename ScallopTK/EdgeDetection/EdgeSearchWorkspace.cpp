@@ -0,0 +1,77 @@
+
+#include "EdgeSearchWorkspace.h"
+
+namespace ScallopTK
+{
+
+//------------------------------------------------------------------------------
+//                              Contour Arena
+//------------------------------------------------------------------------------
+
+Contour& ContourArena::add() {
+  if( used == pool.size() ) {
+    pool.push_back( Contour() );
+  }
+  Contour& ctr = pool[used++];
+  ctr.pts.clear();
+  return ctr;
+}
+
+//------------------------------------------------------------------------------
+//                          Edge Search Workspace
+//------------------------------------------------------------------------------
+
+int EdgeSearchWorkspace::angleSector( float ang ) {
+  if( ang <= 22.5 || ang > 337.5 )
+    return 0;
+  else if( ang <= 67.5 )
+    return 1;
+  else if( ang <= 112.5 )
+    return 2;
+  else if( ang <= 157.5 )
+    return 3;
+  else if( ang <= 202.5 )
+    return 4;
+  else if( ang <= 247.5 )
+    return 5;
+  else if( ang <= 292.5 )
+    return 6;
+  return 7;
+}
+
+void EdgeSearchWorkspace::prepare( int rel_r, int rel_c, int r_range, int c_range ) {
+
+  assert( r_range > 0 && c_range > 0 );
+
+  // Grow tables geometrically so a stream of larger candidates rebuilds rarely
+  int need = max( max( abs( rel_r ), abs( rel_r + r_range - 1 ) ),
+                  max( abs( rel_c ), abs( rel_c + c_range - 1 ) ) );
+  if( need > half ) {
+    build( max( need, half + half / 2 ) );
+  }
+
+  const unsigned entries = r_range * c_range;
+  if( cost.size() < entries ) {
+    cost.resize( entries );
+    color.resize( entries );
+    bin.resize( entries );
+  }
+}
+
+void EdgeSearchWorkspace::build( int newHalf ) {
+  half = newHalf;
+  const int side = 2*half + 1;
+  dist.resize( side * side );
+  ang.resize( side * side );
+  sect.resize( side * side );
+  for( int r = -half; r <= half; r++ ) {
+    for( int c = -half; c <= half; c++ ) {
+      const int ind = index( r, c );
+      dist[ind] = sqrt( (float)r*r + (float)c*c );
+      ang[ind] = cvFastArctan( r, c );
+      sect[ind] = angleSector( ang[ind] );
+    }
+  }
+}
+
+}
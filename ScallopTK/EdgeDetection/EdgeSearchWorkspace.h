@@ -0,0 +1,113 @@
+#ifndef SCALLOP_TK_EDGE_SEARCH_WORKSPACE_H_
+#define SCALLOP_TK_EDGE_SEARCH_WORKSPACE_H_
+
+//------------------------------------------------------------------------------
+//                               Include Files
+//------------------------------------------------------------------------------
+
+//Standard C/C++
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <cmath>
+
+//Opencv
+#include <cv.h>
+#include <cxcore.h>
+
+//Scallop Includes
+#include "ScallopTK/Utilities/Definitions.h"
+
+namespace ScallopTK
+{
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+//                              Contour Arena
+//------------------------------------------------------------------------------
+
+// Reusable contour storage
+//
+// Contours handed out by add() stay valid until clear(), and keep their
+// point capacity when reused so steady state searches do not allocate.
+class ContourArena {
+public:
+
+  ContourArena() : used( 0 ) {}
+
+  // Returns an empty contour
+  Contour& add();
+
+  // Releases all contours for reuse
+  void clear() { used = 0; }
+
+  unsigned size() const { return used; }
+  Contour& operator[]( unsigned i ) { return pool[i]; }
+  const Contour& operator[]( unsigned i ) const { return pool[i]; }
+
+private:
+
+  deque<Contour> pool;
+  unsigned used;
+};
+
+//------------------------------------------------------------------------------
+//                          Edge Search Workspace
+//------------------------------------------------------------------------------
+
+// Scratch state for searching edges around candidates, one per thread
+//
+// Besides the window buffers, holds tables of the radial distance, angle
+// (as cvFastArctan) and non-max suppression sector of every integer offset
+// from a candidate center. These only depend on the offset, so are built
+// once for the largest window seen instead of per pixel per candidate.
+class EdgeSearchWorkspace {
+public:
+
+  EdgeSearchWorkspace() : half( -1 ) {}
+
+  // Sizes tables and buffers for a r_range x c_range window whose top-left
+  // pixel is at offset (rel_r, rel_c) from the candidate center
+  void prepare( int rel_r, int rel_c, int r_range, int c_range );
+
+  // Offset table lookups
+  float distance( int r, int c ) const { return dist[ index( r, c ) ]; }
+  float angle( int r, int c ) const { return ang[ index( r, c ) ]; }
+  int sector( int r, int c ) const { return sect[ index( r, c ) ]; }
+
+  // Non max suppression sector of an angle (8 sectors of 45 degrees,
+  // sector 0 centered on 0 degrees)
+  static int angleSector( float ang );
+
+  // Window buffers, rows are c_range entries apart
+  vector<float> cost;
+  vector<float> color;
+  vector<char> bin;
+
+  // Flood fill stack and linked contours
+  vector<Point2D> fill;
+  ContourArena contours;
+
+  // Ellipse fitting points and contour shift steps
+  vector<CvPoint2D32f> points;
+  vector<float> stepsr;
+  vector<float> stepsc;
+
+private:
+
+  int index( int r, int c ) const { return ( r + half ) * ( 2*half + 1 ) + c + half; }
+  void build( int newHalf );
+
+  int half;
+  vector<float> dist;
+  vector<float> ang;
+  vector<unsigned char> sect;
+};
+
+}
+
+#endif
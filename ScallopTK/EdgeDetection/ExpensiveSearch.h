@@ -8,6 +8,7 @@
 //Standard C/C++
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -21,6 +22,7 @@
 #include "ScallopTK/Utilities/Definitions.h"
 #include "ScallopTK/Utilities/HelperFunctions.h"
 #include "ScallopTK/EdgeDetection/GaussianEdges.h"
+#include "ScallopTK/EdgeDetection/EdgeSearchWorkspace.h"
 #include "ScallopTK/ObjectProposals/HistogramFiltering.h"
 
 //------------------------------------------------------------------------------
@@ -31,7 +33,7 @@ namespace ScallopTK
 {
 
 void expensiveEdgeSearch( GradientChain& Gradients, hfResults* color, 
-  IplImage *ImgLab32f, IplImage *img_rgb_32f, CandidatePtrVector cds );
+  IplImage *ImgLab32f, IplImage *img_rgb_32f, CandidatePtrVector& cds );
 
 }
 
@@ -11,42 +11,17 @@ namespace ScallopTK
 // Takes a verticle gaussian derivative
 IplImage *gaussDerivVerticle( IplImage *input, double sigma ) {
   IplImage *output = cvCreateImage( cvGetSize( input ), IPL_DEPTH_32F, input->nChannels );
-  int filter_size = sigma * KERNEL_SIZE_PER_SIGMA;
-  filter_size = filter_size + (filter_size+1)%2;
-  CvMat* M = cvCreateMat(filter_size,1,CV_32FC1);
-  int center = filter_size / 2;
-  float sig2 = sigma * sigma;
-  float sig3 = sigma * sig2;
-  for( int i=0; i<filter_size; i++ ) {
-    float pos = i - center;
-    float value = -(pos/sig3)*exp(-pos*pos/(2*sig2));
-    cvmSet(M, i, 0, value );
-  }
-  cvFilter2D(input,output,M);
-  cvReleaseMat(&M);
+  DerivativeFilterBank::get( sigma )->filter( input, NULL, output );
   return output;
 }
 
 // Takes a horizontal gaussian derivative
 IplImage *gaussDerivHorizontal( IplImage *input, double sigma ) {
   IplImage *output = cvCreateImage( cvGetSize( input ), IPL_DEPTH_32F, input->nChannels );
-  int filter_size = sigma * KERNEL_SIZE_PER_SIGMA;
-  filter_size = filter_size + (filter_size+1)%2;
-  CvMat* M = cvCreateMat(1,filter_size,CV_32FC1);
-  int center = filter_size / 2;
-  float sig2 = sigma * sigma;
-  float sig3 = sigma * sig2;
-  for( int i=0; i<filter_size; i++ ) {
-    float pos = i - center;
-    float value = -(pos/sig3)*exp(-pos*pos/(2*sig2));
-    cvmSet(M, 0, i, value );
-  }
-  cvFilter2D(input,output,M);
-  cvReleaseMat(&M);
+  DerivativeFilterBank::get( sigma )->filter( input, output, NULL );
   return output;
 }
 
-
 // Takes a verticle box derivative
 IplImage *boxDerivVerticle( IplImage *input ) {
   IplImage *output = cvCreateImage( cvGetSize( input ), IPL_DEPTH_32F, input->nChannels );
@@ -83,80 +58,27 @@ IplImage *boxDerivHorizontal( IplImage *input ) {
   return output;
 }
 
-// Takes a diagonal gaussian derivative
+// Takes a diagonal gaussian derivative (down-right), steered from dx/dy
 IplImage *gaussDerivAngle2( IplImage *input, double sigma ) {
   IplImage *output = cvCreateImage( cvGetSize( input ), IPL_DEPTH_32F, input->nChannels );
-  int filter_size = sigma * KERNEL_SIZE_PER_SIGMA / sqrt((float)2);
-  filter_size = filter_size + (filter_size+1)%2 + 2;
-  CvMat* M = cvCreateMat(filter_size,filter_size,CV_32FC1);
-  cvSetZero(M);
-  int center = filter_size / 2;
-  float sig2 = sigma * sigma;
-  float sig3 = sigma * sig2;
-  for( int i=0; i<filter_size; i++ ) {
-
-    //Calculate Value
-    float pos = i - center;
-    float value = -(pos/sig3)*exp(-pos*pos/(2*sig2));
-
-    //Bilinear Interpolate into bins
-    float subpix = pos / sqrt(2.0f);
-    float top = ceil( subpix );
-    float bot = floor( subpix );
-    float botdif = subpix - bot; 
-    float topdif = 1 - botdif;
-    top = top + center;
-    bot = bot + center;
-    float v1 = cvmGet(M, bot, bot);
-    float v2 = cvmGet(M, bot, top);
-    float v3 = cvmGet(M, top, bot);
-    float v4 = cvmGet(M, top, top);
-    cvmSet(M, bot, bot, value * topdif * topdif + v1);
-    cvmSet(M, bot, top, value * topdif * botdif + v2);
-    cvmSet(M, top, bot, value * botdif * topdif + v3);
-    cvmSet(M, top, top, value * botdif * botdif + v4);
-  }
-  cvFilter2D(input,output,M);
-  cvReleaseMat(&M);
+  IplImage *dx = cvCreateImage( cvGetSize( input ), IPL_DEPTH_32F, input->nChannels );
+  IplImage *dy = cvCreateImage( cvGetSize( input ), IPL_DEPTH_32F, input->nChannels );
+  DerivativeFilterBank::get( sigma )->filter( input, dx, dy );
+  DerivativeFilterBank::steer( dx, dy, PI/4, output );
+  cvReleaseImage(&dx);
+  cvReleaseImage(&dy);
   return output;
 }
 
-
-// Takes a diagonal gaussian derivative
+// Takes a diagonal gaussian derivative (up-right), steered from dx/dy
 IplImage *gaussDerivAngle4( IplImage *input, double sigma ) {
   IplImage *output = cvCreateImage( cvGetSize( input ), IPL_DEPTH_32F, input->nChannels );
-  int filter_size = sigma * KERNEL_SIZE_PER_SIGMA / sqrt((float)2);
-  filter_size = filter_size + (filter_size+1)%2 + 2;
-  CvMat* M = cvCreateMat(filter_size,filter_size,CV_32FC1);
-  cvSetZero(M);
-  int center = filter_size / 2;
-  float sig2 = sigma * sigma;
-  float sig3 = sigma * sig2;
-  for( int i=0; i<filter_size; i++ ) {
-
-    //Calculate Value
-    float pos = i - center;
-    float value = -(pos/sig3)*exp(-pos*pos/(2*sig2));
-
-    //Bilinear Interpolate into bins
-    float subpix = pos / sqrt(2.0f);
-    float top = ceil( subpix );
-    float bot = floor( subpix );
-    float botdif = subpix - bot; 
-    float topdif = 1 - botdif;
-    top = top + center;
-    bot = bot + center;
-    float v1 = cvmGet(M, filter_size-bot-1, bot);
-    float v2 = cvmGet(M, filter_size-bot-1, top);
-    float v3 = cvmGet(M, filter_size-top-1, bot);
-    float v4 = cvmGet(M, filter_size-top-1, top);
-    cvmSet(M, filter_size-bot-1, bot, value * topdif * topdif + v1);
-    cvmSet(M, filter_size-bot-1, top, value * topdif * botdif + v2);
-    cvmSet(M, filter_size-top-1, bot, value * botdif * topdif + v3);
-    cvmSet(M, filter_size-top-1, top, value * botdif * botdif + v4);
-  }
-  cvFilter2D(input,output,M);
-  cvReleaseMat(&M);
+  IplImage *dx = cvCreateImage( cvGetSize( input ), IPL_DEPTH_32F, input->nChannels );
+  IplImage *dy = cvCreateImage( cvGetSize( input ), IPL_DEPTH_32F, input->nChannels );
+  DerivativeFilterBank::get( sigma )->filter( input, dx, dy );
+  DerivativeFilterBank::steer( dx, dy, -PI/4, output );
+  cvReleaseImage(&dx);
+  cvReleaseImage(&dy);
   return output;
 }
 
@@ -256,6 +178,183 @@ IplImage *mergeAbs3Chan( IplImage *input ) {
   cvReleaseImage(&ch3);
 }*/
 
+// Polynomial atan2 approximation in degrees [0,360), max error ~0.3 degrees,
+// the same approximation cvFastArctan uses
+const float ATAN2_P1 = 0.9997878412794807f * 57.29577951308232f;
+const float ATAN2_P3 = -0.3258083974640975f * 57.29577951308232f;
+const float ATAN2_P5 = 0.1555786518463281f * 57.29577951308232f;
+const float ATAN2_P7 = -0.04432655554792128f * 57.29577951308232f;
+const float ATAN2_EPS = 1.1920929e-07f;
+
+inline float fastAtan2Deg( float y, float x ) {
+  float ax = fabs( x ), ay = fabs( y );
+  float a, c, c2;
+  if( ax >= ay ) {
+    c = ay / ( ax + ATAN2_EPS );
+    c2 = c * c;
+    a = ( ( ( ATAN2_P7 * c2 + ATAN2_P5 ) * c2 + ATAN2_P3 ) * c2 + ATAN2_P1 ) * c;
+  } else {
+    c = ax / ( ay + ATAN2_EPS );
+    c2 = c * c;
+    a = 90.0f - ( ( ( ATAN2_P7 * c2 + ATAN2_P5 ) * c2 + ATAN2_P3 ) * c2 + ATAN2_P1 ) * c;
+  }
+  if( x < 0 )
+    a = 180.0f - a;
+  if( y < 0 )
+    a = 360.0f - a;
+  return a;
+}
+
+#if SCALLOP_TK_SSE2
+inline __m128 fastAtan2Deg( __m128 y, __m128 x ) {
+  const __m128 zero = _mm_setzero_ps();
+  __m128 ax = absPS( x ), ay = absPS( y );
+  __m128 xMajor = _mm_cmpge_ps( ax, ay );
+  __m128 num = selectPS( xMajor, ay, ax );
+  __m128 den = _mm_add_ps( selectPS( xMajor, ax, ay ), _mm_set1_ps( ATAN2_EPS ) );
+  __m128 c = _mm_div_ps( num, den );
+  __m128 c2 = _mm_mul_ps( c, c );
+  __m128 a = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( ATAN2_P7 ), c2 ), _mm_set1_ps( ATAN2_P5 ) );
+  a = _mm_add_ps( _mm_mul_ps( a, c2 ), _mm_set1_ps( ATAN2_P3 ) );
+  a = _mm_add_ps( _mm_mul_ps( a, c2 ), _mm_set1_ps( ATAN2_P1 ) );
+  a = _mm_mul_ps( a, c );
+  a = selectPS( xMajor, a, _mm_sub_ps( _mm_set1_ps( 90.0f ), a ) );
+  a = selectPS( _mm_cmplt_ps( x, zero ), _mm_sub_ps( _mm_set1_ps( 180.0f ), a ), a );
+  a = selectPS( _mm_cmplt_ps( y, zero ), _mm_sub_ps( _mm_set1_ps( 360.0f ), a ), a );
+  return a;
+}
+#endif
+
+// Copies one row of a 3-chan 32f image into 3 planar rows, replicating
+// the first and last pixel into a 1 element border on each side
+inline void deinterleaveRow( const float *src, int width, float *planes[3] ) {
+  for( int x = 0; x < width; x++, src += 3 ) {
+    planes[0][x] = src[0];
+    planes[1][x] = src[1];
+    planes[2][x] = src[2];
+  }
+  for( int c = 0; c < 3; c++ ) {
+    planes[c][-1] = planes[c][0];
+    planes[c][width] = planes[c][width-1];
+  }
+}
+
+// Computes Lab gradient magnitude and orientation (degrees) in one pass
+//
+// Equivalent to taking a 3x3 Sobel of each channel (replicated borders),
+// taking the norm across channels in x and y, signed by the first channel,
+// and then the magnitude and angle of the resultant vector. Input rows are
+// processed through a 3 row window of planar buffers so no full size
+// derivative images are ever created.
+void calculateLabGradient( IplImage *lab, IplImage *mag, IplImage *ori ) {
+
+  assert( lab->nChannels == 3 && lab->depth == IPL_DEPTH_32F );
+  assert( mag->depth == IPL_DEPTH_32F && ori->depth == IPL_DEPTH_32F );
+
+  const int width = lab->width;
+  const int height = lab->height;
+
+  // 3 window rows x 3 channels, plus dx2, dy2, dxL, dyL accumulators
+  const int rowSize = width + 2;
+  vector<float> buffer( 13 * rowSize );
+  float *window[3][3];
+  int windowRow[3] = { -1, -1, -1 };
+  for( int w = 0; w < 3; w++ )
+    for( int c = 0; c < 3; c++ )
+      window[w][c] = &buffer[ ( w * 3 + c ) * rowSize + 1 ];
+  float *dx2 = &buffer[ 9 * rowSize ];
+  float *dy2 = &buffer[ 10 * rowSize ];
+  float *dxL = &buffer[ 11 * rowSize ];
+  float *dyL = &buffer[ 12 * rowSize ];
+
+  for( int r = 0; r < height; r++ ) {
+
+    // Load any window rows not already loaded (border rows are replicated)
+    int srcRows[3] = { max( r - 1, 0 ), r, min( r + 1, height - 1 ) };
+    for( int i = 0; i < 3; i++ ) {
+      int slot = srcRows[i] % 3;
+      if( windowRow[slot] != srcRows[i] ) {
+        deinterleaveRow( (float*)( lab->imageData + srcRows[i] * lab->widthStep ),
+          width, window[slot] );
+        windowRow[slot] = srcRows[i];
+      }
+    }
+
+    // Accumulate sobel responses across channels
+    for( int c = 0; c < 3; c++ ) {
+      const float *up = window[ srcRows[0] % 3 ][c];
+      const float *md = window[ srcRows[1] % 3 ][c];
+      const float *dn = window[ srcRows[2] % 3 ][c];
+      int x = 0;
+#if SCALLOP_TK_SSE2
+      const __m128 two = _mm_set1_ps( 2.0f );
+      for( ; x <= width - 4; x += 4 ) {
+        __m128 colL = _mm_add_ps( _mm_add_ps( _mm_loadu_ps( up + x - 1 ), _mm_loadu_ps( dn + x - 1 ) ),
+          _mm_mul_ps( two, _mm_loadu_ps( md + x - 1 ) ) );
+        __m128 colR = _mm_add_ps( _mm_add_ps( _mm_loadu_ps( up + x + 1 ), _mm_loadu_ps( dn + x + 1 ) ),
+          _mm_mul_ps( two, _mm_loadu_ps( md + x + 1 ) ) );
+        __m128 rowU = _mm_add_ps( _mm_add_ps( _mm_loadu_ps( up + x - 1 ), _mm_loadu_ps( up + x + 1 ) ),
+          _mm_mul_ps( two, _mm_loadu_ps( up + x ) ) );
+        __m128 rowD = _mm_add_ps( _mm_add_ps( _mm_loadu_ps( dn + x - 1 ), _mm_loadu_ps( dn + x + 1 ) ),
+          _mm_mul_ps( two, _mm_loadu_ps( dn + x ) ) );
+        __m128 gx = _mm_sub_ps( colR, colL );
+        __m128 gy = _mm_sub_ps( rowD, rowU );
+        if( c == 0 ) {
+          _mm_storeu_ps( dxL + x, gx );
+          _mm_storeu_ps( dyL + x, gy );
+          _mm_storeu_ps( dx2 + x, _mm_mul_ps( gx, gx ) );
+          _mm_storeu_ps( dy2 + x, _mm_mul_ps( gy, gy ) );
+        } else {
+          _mm_storeu_ps( dx2 + x, _mm_add_ps( _mm_loadu_ps( dx2 + x ), _mm_mul_ps( gx, gx ) ) );
+          _mm_storeu_ps( dy2 + x, _mm_add_ps( _mm_loadu_ps( dy2 + x ), _mm_mul_ps( gy, gy ) ) );
+        }
+      }
+#endif
+      for( ; x < width; x++ ) {
+        float gx = ( up[x+1] + 2.0f * md[x+1] + dn[x+1] ) - ( up[x-1] + 2.0f * md[x-1] + dn[x-1] );
+        float gy = ( dn[x-1] + 2.0f * dn[x] + dn[x+1] ) - ( up[x-1] + 2.0f * up[x] + up[x+1] );
+        if( c == 0 ) {
+          dxL[x] = gx;
+          dyL[x] = gy;
+          dx2[x] = gx * gx;
+          dy2[x] = gy * gy;
+        } else {
+          dx2[x] += gx * gx;
+          dy2[x] += gy * gy;
+        }
+      }
+    }
+
+    // Reduce to signed channel norms, magnitude and orientation
+    float *ptr_mag = (float*)( mag->imageData + r * mag->widthStep );
+    float *ptr_ori = (float*)( ori->imageData + r * ori->widthStep );
+    int x = 0;
+#if SCALLOP_TK_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    for( ; x <= width - 4; x += 4 ) {
+      __m128 sx = _mm_loadu_ps( dx2 + x );
+      __m128 sy = _mm_loadu_ps( dy2 + x );
+      __m128 gx = _mm_sqrt_ps( sx );
+      __m128 gy = _mm_sqrt_ps( sy );
+      gx = selectPS( _mm_cmplt_ps( _mm_loadu_ps( dxL + x ), zero ), _mm_sub_ps( zero, gx ), gx );
+      gy = selectPS( _mm_cmplt_ps( _mm_loadu_ps( dyL + x ), zero ), _mm_sub_ps( zero, gy ), gy );
+      _mm_storeu_ps( ptr_mag + x, _mm_sqrt_ps( _mm_add_ps( sx, sy ) ) );
+      _mm_storeu_ps( ptr_ori + x, fastAtan2Deg( gy, gx ) );
+    }
+#endif
+    for( ; x < width; x++ ) {
+      float gx = sqrt( dx2[x] );
+      float gy = sqrt( dy2[x] );
+      if( dxL[x] < 0.0f )
+        gx = -gx;
+      if( dyL[x] < 0.0f )
+        gy = -gy;
+      ptr_mag[x] = sqrt( dx2[x] + dy2[x] );
+      ptr_ori[x] = fastAtan2Deg( gy, gx );
+    }
+  }
+}
+
 // Create a chain of all gradient images we need across all operations
 GradientChain createGradientChain( IplImage *img_lab, IplImage *img_gs_32f,
   IplImage *img_gs_8u, IplImage *img_rgb_8u, hfResults *color,
@@ -287,8 +386,9 @@ GradientChain createGradientChain( IplImage *img_lab, IplImage *img_gs_32f,
 
   // Create Lab derivatives
   float adj_sigma_1 = LAB_GRAD_SIGMA * minRad / MPFMR_TEMPLATE;
-  output.dxColorSig1 = gaussDerivHorizontal( input, adj_sigma_1 );
-  output.dyColorSig1 = gaussDerivVerticle( input, adj_sigma_1 );
+  output.dxColorSig1 = cvCreateImage( cvGetSize( input ), IPL_DEPTH_32F, input->nChannels );
+  output.dyColorSig1 = cvCreateImage( cvGetSize( input ), IPL_DEPTH_32F, input->nChannels );
+  DerivativeFilterBank::get( adj_sigma_1 )->filter( input, output.dxColorSig1, output.dyColorSig1 );
   output.dxMergedSig1 = mergeAbs3Chan( output.dxColorSig1 );
   output.dyMergedSig1 = mergeAbs3Chan( output.dyColorSig1 );
   cvScale(output.dxMergedSig1,output.dxMergedSig1,1.0/23.0);
@@ -297,8 +397,9 @@ GradientChain createGradientChain( IplImage *img_lab, IplImage *img_gs_32f,
   cvAdd( output.dxMergedSig1, output.dyMergedSig1, output.dMergedSig1 );
 
   // Create color derivative
-  output.dxCCGrad = gaussDerivHorizontal( color->EnvironmentMap, ENV_GRAD_SIGMA );
-  output.dyCCGrad = gaussDerivVerticle( color->EnvironmentMap, ENV_GRAD_SIGMA );
+  output.dxCCGrad = cvCreateImage( cvGetSize( color->EnvironmentMap ), IPL_DEPTH_32F, 1 );
+  output.dyCCGrad = cvCreateImage( cvGetSize( color->EnvironmentMap ), IPL_DEPTH_32F, 1 );
+  DerivativeFilterBank::get( ENV_GRAD_SIGMA )->filter( color->EnvironmentMap, output.dxCCGrad, output.dyCCGrad );
   cvAbs( output.dyCCGrad, output.dyCCGrad );
   cvAbs( output.dxCCGrad, output.dxCCGrad );
   cvScale(output.dxCCGrad,output.dxCCGrad,1.0/0.50);
@@ -332,40 +433,10 @@ GradientChain createGradientChain( IplImage *img_lab, IplImage *img_gs_32f,
   // Create net watershed map (deprecated)
   //createWatershedMap( output, img_rgb_8u );
 
-  // Take Lab derivative magntitude and direction
-  IplImage *lab_dx = cvCreateImage( cvGetSize( img_lab ), img_lab->depth, 3 );
-  IplImage *lab_dy = cvCreateImage( cvGetSize( img_lab ), img_lab->depth, 3 );
-  cvSobel( img_lab, lab_dx, 1, 0, 3 );
-  cvSobel( img_lab, lab_dy, 0, 1, 3 );
-  IplImage *lab_mag = cvCreateImage( cvGetSize( img_lab ), img_lab->depth, 1 );
-  IplImage *lab_ori = cvCreateImage( cvGetSize( img_lab ), img_lab->depth, 1 );
-
-  // Make a single pass on lab images to calc magnitude and orientation approx
-  int lab_entries = lab_dx->width * lab_dy->height;
-  float *ptr_dx = (float*)lab_dx->imageData;
-  float *ptr_dy = (float*)lab_dy->imageData;
-  float *ptr_mag = (float*)lab_mag->imageData;
-  float *ptr_ori = (float*)lab_ori->imageData;  
-  for( int i=0; i<lab_entries; i++ ) {
-    float dx_mag = ptr_dx[0]*ptr_dx[0] + ptr_dx[1]*ptr_dx[1] + ptr_dx[2]*ptr_dx[2];
-    float dy_mag = ptr_dy[0]*ptr_dy[0] + ptr_dy[1]*ptr_dy[1] + ptr_dy[2]*ptr_dy[2];
-    dx_mag = sqrt( dx_mag );
-    dy_mag = sqrt( dy_mag );
-    if( *ptr_dx < 0.0f )
-      dx_mag *= -1.0f;
-    if( *ptr_dy < 0.0f )
-      dy_mag *= -1.0f;
-    *ptr_mag = sqrt(dx_mag*dx_mag+dy_mag*dy_mag);
-    *ptr_ori = cvFastArctan(dy_mag, dx_mag);
-    ptr_dx = ptr_dx + 3;
-    ptr_dy = ptr_dy + 3;
-    ptr_mag = ptr_mag + 1;
-    ptr_ori = ptr_ori + 1;
-  }
-
-  // Set output lab mag/ori
-  output.dLabMag = lab_mag;
-  output.dLabOri = lab_ori;
+  // Take Lab derivative magntitude and direction in a single fused pass
+  output.dLabMag = cvCreateImage( cvGetSize( img_lab ), img_lab->depth, 1 );
+  output.dLabOri = cvCreateImage( cvGetSize( img_lab ), img_lab->depth, 1 );
+  calculateLabGradient( img_lab, output.dLabMag, output.dLabOri );
 
   // Make a single pass on color class images to calc magnitude approx
   
@@ -375,8 +446,6 @@ GradientChain createGradientChain( IplImage *img_lab, IplImage *img_gs_32f,
     cvReleaseImage(&input);
   cvReleaseImage(&by);
   cvReleaseImage(&bx);
-  cvReleaseImage( &lab_dx );
-  cvReleaseImage( &lab_dy );
 
   return output;
 }
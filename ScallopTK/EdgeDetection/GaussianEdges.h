@@ -19,6 +19,8 @@
 //Scallop Includes
 #include "ScallopTK/Utilities/Definitions.h"
 #include "ScallopTK/Utilities/HelperFunctions.h"
+#include "ScallopTK/Utilities/SIMD.h"
+#include "ScallopTK/EdgeDetection/DerivativeFilterBank.h"
 #include "ScallopTK/ObjectProposals/HistogramFiltering.h"
 
 //------------------------------------------------------------------------------
@@ -65,12 +67,6 @@ struct GradientChain {
   IplImage *WatershedInput;
 };
 
-//------------------------------------------------------------------------------
-//                                 Constants
-//------------------------------------------------------------------------------
-
-const float KERNEL_SIZE_PER_SIGMA = 6;
-
 //------------------------------------------------------------------------------
 //                             Function Prototypes
 //------------------------------------------------------------------------------
@@ -78,6 +74,10 @@ const float KERNEL_SIZE_PER_SIGMA = 6;
 IplImage *gaussDerivVerticle( IplImage *input, double sigma );
 IplImage *gaussDerivHorizontal( IplImage *input, double sigma );
 
+// Computes Lab gradient magnitude and orientation (degrees) in one pass,
+// mag and ori must be single channel 32f images the same size as lab
+void calculateLabGradient( IplImage *lab, IplImage *mag, IplImage *ori );
+
 GradientChain createGradientChain( IplImage *img_lab, IplImage *img_gs_32f,
   IplImage *img_gs_8u, IplImage *img_rgb_8u, hfResults *color,
   float minRad, float maxRad );
@@ -14,7 +14,7 @@ CvMat *createGaborFilter( float sigma, float theta, float lambda, float psi, flo
 //                                  Constants
 //------------------------------------------------------------------------------
 
-#define NUM_FILTERS 6
+#define NUM_FILTERS NUM_GABOR_FILTERS
 //int samppos[5][2] = { {32, 32}, {32, 17}, {17, 32}, {46, 32}, {32, 46} };
 
 //------------------------------------------------------------------------------
@@ -69,7 +69,7 @@ CvMat *createGaborFilter( float sigma, float theta, float lambda, float psi, flo
   }
 }*/
 
-void calculateGaborFeatures( IplImage *img_gs_32f, CandidatePtrVector& cds ) {
+GaborFeatureGenerator::GaborFeatureGenerator( IplImage *img_gs_32f ) {
 
   // Create linear filters
   CvMat *filterBank[NUM_FILTERS];
@@ -81,7 +81,6 @@ void calculateGaborFeatures( IplImage *img_gs_32f, CandidatePtrVector& cds ) {
   filterBank[5] = createGaborFilter( 1.8, PI/3, 5.4, 1.8, 2.17 );
 
   // Create images to store results
-  IplImage *results[NUM_FILTERS];
   for( int i=0; i<NUM_FILTERS; i++ )
     results[i] = cvCreateImage( cvGetSize(img_gs_32f), IPL_DEPTH_32F, 1 );
 
@@ -89,7 +88,16 @@ void calculateGaborFeatures( IplImage *img_gs_32f, CandidatePtrVector& cds ) {
   for( int i=0; i<NUM_FILTERS; i++ ) {
     cvFilter2D( img_gs_32f, results[i], filterBank[i] );
     cvSmooth( results[i], results[i], CV_BLUR, 5 );
+    cvReleaseMat( &filterBank[i] );
   }
+}
+
+GaborFeatureGenerator::~GaborFeatureGenerator() {
+  for( int i=0; i<NUM_FILTERS; i++ )
+    cvReleaseImage( &results[i] );
+}
+
+void GaborFeatureGenerator::Generate( CandidatePtrVector& cds ) {
 
   // Compile vars for scan
   float *img_ptr[NUM_FILTERS];
@@ -161,12 +169,11 @@ void calculateGaborFeatures( IplImage *img_gs_32f, CandidatePtrVector& cds ) {
 
     }
   }
+}
 
-  // Deallocate results
-  for( int i=0; i<NUM_FILTERS; i++ ) {
-    cvReleaseImage( &results[i] );
-    cvReleaseMat( &filterBank[i] );
-  }
+void calculateGaborFeatures( IplImage *img_gs_32f, CandidatePtrVector& cds ) {
+  GaborFeatureGenerator generator( img_gs_32f );
+  generator.Generate( cds );
 }
 
 // Modeled after wikipedia entry
@@ -22,12 +22,35 @@
 #include "ScallopTK/Utilities/Definitions.h"
 #include "ScallopTK/Utilities/HelperFunctions.h"
 
+namespace ScallopTK
+{
+
+//------------------------------------------------------------------------------
+//                                 Constants
+//------------------------------------------------------------------------------
+
+const int NUM_GABOR_FILTERS = 6;
+
 //------------------------------------------------------------------------------
 //                             Function Prototypes
 //------------------------------------------------------------------------------
 
-namespace ScallopTK
-{
+class GaborFeatureGenerator {
+
+public:
+
+  // Filters the whole image with every kernel in the bank
+  explicit GaborFeatureGenerator( IplImage *img_gs_32f );
+  ~GaborFeatureGenerator();
+
+  // Samples the filter responses around each active candidate
+  void Generate( CandidatePtrVector& cds );
+
+private:
+
+  // Smoothed filter responses
+  IplImage *results[NUM_GABOR_FILTERS];
+};
 
 //void performGaborFiltering( Candidate *cd );
 void calculateGaborFeatures( IplImage *img_gs_32f, CandidatePtrVector& cds );
@@ -120,7 +120,7 @@ void calculateSizeFeatures( Candidate *cd, ImageProperties& ip, float initResize
   if( !cd->isActive )
     return;
   float majorAxisMeters, minor_meters, area_msq, perimeter_m;
-  float aPS = sizeAdj * ip.getAvgPixelSizeMeters() / initResize;
+  float aPS = sizeAdj * ip.getPixelSizeMeters( cd->r / initResize, cd->c / initResize ) / initResize;
   majorAxisMeters = cd->major * aPS;
   minor_meters = cd->minor * aPS;
   cd->majorAxisMeters = majorAxisMeters;
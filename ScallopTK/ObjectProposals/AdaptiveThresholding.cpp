@@ -78,45 +78,31 @@ namespace ScallopTK
 
 void calcFilterStats( IplImage *img, atStats& stats ) {
 
-  // Calculate percentiles
-  float *ptr = (float*) img->imageData;
-  int sze = img->width * img->height;
-  float *endptr = ptr + sze;
-  int skippage = sze / AT_SAMPLES;
-  if( skippage < 1 )
-    skippage = 1;
-  int entries = sze / skippage;
-  vector<float> val_list(entries,0.0f);
-  int counter = 0;
-  while( counter < entries ) {
-    val_list[counter] = *ptr;
-    counter++;
-    ptr = ptr + skippage;
-  }
-  sort( val_list.begin(), val_list.end() );
-  
+  // Sample the image
+  fsSamples samples;
+  int stride = fsSampleStride( img->width * img->height, AT_SAMPLES );
+  fsSampleImage( img, stride, samples );
+  int entries = samples.values.size();
+
   // Determine where 0.0 (start threshold) lies
-  // Binary search would have been more efficient, but irrelevant 
-  // because this takes so short a time...
-  int pivot = val_list.size();
-  for( int i=0; i<val_list.size(); i++ ) {
-    if( val_list[i] > 0.0 ) {
-      pivot = i;
-      break;
-    }
+  int pivot = fsCountAtOrBelow( samples, 0.0f );
+
+  // Ranks of all lower and upper %tiles, selected together in one pass
+  int ranks[AT_LOWER_SIZE+AT_UPPER_SIZE];
+  float values[AT_LOWER_SIZE+AT_UPPER_SIZE];
+  for( int i=0; i<AT_LOWER_SIZE; i++ ) {
+    ranks[i] = (int)(AT_LOWER_PER[i]*(float)pivot);
   }
+  for( int i=0; i<AT_UPPER_SIZE; i++ ) {
+    ranks[AT_LOWER_SIZE+i] = (int)(AT_UPPER_PER[i]*(float)(entries-pivot)) + pivot;
+  }
+  fsSelectRanks( samples, ranks, AT_LOWER_SIZE+AT_UPPER_SIZE, values );
 
   // Calculate lower %tiles
   if( pivot > 0 ) {
-    
-    int ind_list[AT_LOWER_SIZE];
-    int range = pivot;
-    for( int i=0; i<AT_LOWER_SIZE; i++ ) {
-      ind_list[i] = (int)(AT_LOWER_PER[i]*(float)range);
-      if( ind_list[i] < 0 )
-        ind_list[i] = 0;
-      stats.lower_intvls[i] = val_list[ ind_list[i] ];
-    }
+
+    for( int i=0; i<AT_LOWER_SIZE; i++ )
+      stats.lower_intvls[i] = values[i];
 
   } else {
 
@@ -128,16 +114,10 @@ void calcFilterStats( IplImage *img, atStats& stats ) {
   }
 
   // Calculate higher %tiles
-  if( pivot < val_list.size() ) {
-
-    int ind_list[AT_UPPER_SIZE];
-    int range = val_list.size() - pivot;
-    for( int i=0; i<AT_UPPER_SIZE; i++ ) {
-      ind_list[i] = (int)(AT_UPPER_PER[i]*(float)range) + pivot;
-      if( ind_list[i] >= val_list.size() )
-        ind_list[i] = val_list.size() - 1;
-      stats.upper_intvls[i] = val_list[ ind_list[i] ];
-    }
+  if( pivot < entries ) {
+
+    for( int i=0; i<AT_UPPER_SIZE; i++ )
+      stats.upper_intvls[i] = values[AT_LOWER_SIZE+i];
 
   } else {
 
@@ -147,7 +127,16 @@ void calcFilterStats( IplImage *img, atStats& stats ) {
     for( int i=0; i<AT_UPPER_SIZE; i++ )
       stats.upper_intvls[i] = (val+=inc);
   }
+}
 
+// Converts region counts at one threshold into the next search direction
+int atSearchDirection( int lowcount, int highcount ) {
+  int retval = 0x0;
+  if( lowcount > 100000 )
+    retval = retval | AT_LOWER;
+  if( highcount > 0 )
+    retval = retval | AT_RAISE;
+  return ( AT_RECURSIVE_SEARCH ? retval : 0 );
 }
 
 int hfBinaryClassify(IplImage *bin, float minRad, float maxRad, CandidatePtrVector& kps ) {
@@ -171,96 +160,136 @@ int hfBinaryClassify(IplImage *bin, float minRad, float maxRad, CandidatePtrVect
       highcount++;
   }
 
-  //Create return
-  int retval = 0x0;
-  if( lowcount > 100000 )
-    retval = retval | AT_LOWER;
-  if( highcount > 0 )
-    retval = retval | AT_RAISE;
-
   //Deallocate
   if(Contours)
   {
     cvReleaseMemStorage( &Contours->storage );
   }
-  return 0;
+  return atSearchDirection( lowcount, highcount );
 }
 
-int hfLowBinarySearch(hfResults* imgs, atStats* stats, CandidatePtrVector& kps, float minRad, float maxRad, int position ) {
+// Component tree engine state shared by every threshold of one search
+struct atTreeEngine {
 
-  // Recursive end condition
-  if( position >= AT_LOWER_SIZE )
-    return position;
+  atTreeEngine( IplImage *map, float minRad ) : tree( map ) {
+    // Smaller boxes are always rejected by findStableMatches
+    tree.findNodes( (int)ceil( 2*minRad ), eligible );
+  }
+
+  ComponentTree tree;
+  vector<int> eligible;
+};
+
+// Same as thresholding at t and calling hfBinaryClassify, but only the
+// components large enough to pass the size test are rasterized and traced
+int atTreeClassify( const atTreeEngine& engine, float t, float minRad, float maxRad, CandidatePtrVector& kps ) {
+
+  // Every component not traced below counts as too small
+  int lowcount = engine.tree.countComponents( t );
+  int highcount = 0;
+
+  CvMemStorage *mem = cvCreateMemStorage(0);
+  for( unsigned int i=0; i<engine.eligible.size(); i++ ) {
+    int node = engine.eligible[i];
+    if( !engine.tree.isComponent( node, t ) )
+      continue;
+    lowcount--;
+
+    // Trace the component's contour in image coordinates
+    CvPoint offset;
+    IplImage *mask = engine.tree.extractComponent( node, t, offset );
+    CvSeq *Contours = NULL;
+    cvClearMemStorage( mem );
+    cvFindContours( mask, mem, &Contours, sizeof(CvContour),
+      CV_RETR_CCOMP, CV_CHAIN_APPROX_SIMPLE, offset );
+    for( CvSeq *ptr = Contours; ptr != NULL; ptr = ptr->h_next ) {
+      int ret = findStableMatches( ptr, minRad, maxRad, kps, mask );
+      if( ret == -1 )
+        lowcount++;
+      if( ret == 1 )
+        highcount++;
+    }
+    cvReleaseImage(&mask);
+  }
+  cvReleaseMemStorage(&mem);
+
+  return atSearchDirection( lowcount, highcount );
+}
+
+// Extracts candidates from the map thresholded at t with either engine
+int atClassifyThreshold( hfResults* imgs, const atTreeEngine* engine, float t,
+  float minRad, float maxRad, CandidatePtrVector& kps ) {
+
+  if( engine ) {
+    return atTreeClassify( *engine, t, minRad, maxRad, kps );
+  }
 
   // Threshold image
   IplImage *threshed = cvCreateImage( cvGetSize(imgs->NetScallops), IPL_DEPTH_8U, 1 );
-  cvThreshold(imgs->NetScallops,threshed, stats->lower_intvls[position],1.0f,CV_THRESH_BINARY);  
+  cvThreshold(imgs->NetScallops,threshed,t,1.0f,CV_THRESH_BINARY);
 
   // Classify binary groups
   int option = hfBinaryClassify(threshed, minRad, maxRad, kps );
 
+  // Deallocate memory
+  cvReleaseImage(&threshed);
+  return option;
+}
+
+int hfLowBinarySearch(hfResults* imgs, const atTreeEngine* engine, atStats* stats, CandidatePtrVector& kps, float minRad, float maxRad, int position ) {
+
+  // Recursive end condition
+  if( position >= AT_LOWER_SIZE )
+    return position;
+
+  // Threshold and classify binary groups
+  int option = atClassifyThreshold(imgs, engine, stats->lower_intvls[position], minRad, maxRad, kps );
+
   // Call recursive search at a different threshold
   if( option & AT_LOWER ) {
-    hfLowBinarySearch(imgs, stats, kps, minRad, maxRad, 2*position );
+    hfLowBinarySearch(imgs, engine, stats, kps, minRad, maxRad, 2*position );
   }
   if( option & AT_RAISE ) {
-    hfLowBinarySearch(imgs, stats, kps, minRad, maxRad, 2*position+1 );
+    hfLowBinarySearch(imgs, engine, stats, kps, minRad, maxRad, 2*position+1 );
   }
-
-  // Deallocate memory
-  cvReleaseImage(&threshed);
   return position;
 }
 
-int hfHighBinarySearch(hfResults* imgs, atStats* stats, CandidatePtrVector& kps, float minRad, float maxRad, int position ) {
+int hfHighBinarySearch(hfResults* imgs, const atTreeEngine* engine, atStats* stats, CandidatePtrVector& kps, float minRad, float maxRad, int position ) {
 
   // Recursive end condition
   if( position >= AT_UPPER_SIZE )
     return position;
 
-  // Threshold image
-  IplImage *threshed = cvCreateImage( cvGetSize(imgs->NetScallops), IPL_DEPTH_8U, 1 );
-  cvThreshold(imgs->NetScallops,threshed,stats->upper_intvls[position],1.0f,CV_THRESH_BINARY);  
-
-  // Classify binary groups
-  int option = hfBinaryClassify(threshed, minRad, maxRad, kps );
+  // Threshold and classify binary groups
+  int option = atClassifyThreshold(imgs, engine, stats->upper_intvls[position], minRad, maxRad, kps );
 
   // Call recursive search at a different threshold
   if( option & AT_LOWER ) {
-    hfHighBinarySearch(imgs, stats, kps, minRad, maxRad, 2*position );
+    hfHighBinarySearch(imgs, engine, stats, kps, minRad, maxRad, 2*position );
   }
   if( option & AT_RAISE ) {
-    hfHighBinarySearch(imgs, stats, kps, minRad, maxRad, 2*position+1 );
+    hfHighBinarySearch(imgs, engine, stats, kps, minRad, maxRad, 2*position+1 );
   }
-
-  // Deallocate memory
-  cvReleaseImage(&threshed);
   return position;
 }
 
-int hfSeedSearch(hfResults* imgs, atStats* stats, CandidatePtrVector& kps, float minRad, float maxRad ) {
+int hfSeedSearch(hfResults* imgs, const atTreeEngine* engine, atStats* stats, CandidatePtrVector& kps, float minRad, float maxRad ) {
 
-  // Threshold image
-  IplImage *threshed = cvCreateImage( cvGetSize(imgs->NetScallops), IPL_DEPTH_8U, 1 );
-  cvThreshold(imgs->NetScallops,threshed, 0.0f,1.0f,CV_THRESH_BINARY);  
-
-  // Classify binary groups
-  int option = hfBinaryClassify(threshed, minRad, maxRad, kps );
+  // Threshold and classify binary groups
+  int option = atClassifyThreshold(imgs, engine, 0.0f, minRad, maxRad, kps );
 
   // Call recursive search at a different threshold
   if( option & AT_LOWER ) {
-    hfLowBinarySearch(imgs, stats, kps, minRad, maxRad, 1 );
+    hfLowBinarySearch(imgs, engine, stats, kps, minRad, maxRad, 1 );
   }
   if( option & AT_RAISE ) {
-    hfHighBinarySearch(imgs, stats, kps, minRad, maxRad, 1 );
+    hfHighBinarySearch(imgs, engine, stats, kps, minRad, maxRad, 1 );
   }
-
-  // Deallocate memory
-  cvReleaseImage(&threshed);
   return option;
 }
 
-void performAdaptiveFiltering( hfResults* color, CandidatePtrVector& cds, float minRad, bool doubleIntrp ) {
+void performAdaptiveFiltering( hfResults* color, CandidatePtrVector& cds, float minRad, bool doubleIntrp, bool useComponentTree ) {
 
   // Resize and smooth image as desired
   IplImage *img = color->NetScallops;
@@ -277,7 +306,15 @@ void performAdaptiveFiltering( hfResults* color, CandidatePtrVector& cds, float
   // Calculate filter stats (percentiles)
   atStats netStats;
   calcFilterStats( img, netStats );
-  hfSeedSearch(color,&netStats,cds,color->minRad*resize_factor,color->maxRad*resize_factor);
+
+  // Build the component tree once for all thresholds if requested
+  float searchMinRad = color->minRad*resize_factor;
+  float searchMaxRad = color->maxRad*resize_factor;
+  atTreeEngine *engine = NULL;
+  if( useComponentTree )
+    engine = new atTreeEngine( color->NetScallops, searchMinRad );
+  hfSeedSearch(color,engine,&netStats,cds,searchMinRad,searchMaxRad);
+  delete engine;
 
   // Adjust kps for scale  
   float scale = 1 / (resize_factor * color->scale );
@@ -20,6 +20,7 @@
 
 //Scallop Includes
 #include "ScallopTK/ObjectProposals/HistogramFiltering.h"
+#include "ScallopTK/ObjectProposals/ComponentTree.h"
 #include "ScallopTK/EdgeDetection/EdgeLinking.h"
 #include "ScallopTK/Utilities/Definitions.h"
 #include "ScallopTK/Utilities/HelperFunctions.h"
@@ -60,6 +61,9 @@ struct atStats {
 const int AT_LOWER = 0x01;
 const int AT_RAISE = 0x02;
 
+// Recurse into the percentile thresholds after the seed threshold?
+const bool AT_RECURSIVE_SEARCH = true;
+
 // Sampling points for approximating percentiles
 const int AT_SAMPLES = 1200;
 
@@ -67,8 +71,11 @@ const int AT_SAMPLES = 1200;
 //                                Prototypes
 //------------------------------------------------------------------------------
 
+// If useComponentTree is set, all thresholds are answered from a single
+// component tree of the map instead of a threshold and contour search per
+// threshold. Both engines produce the same candidates.
 void performAdaptiveFiltering( hfResults* color, CandidatePtrVector& cds,
-  float minRad, bool doubleIntrp = false );
+  float minRad, bool doubleIntrp = false, bool useComponentTree = false );
 
 }
 
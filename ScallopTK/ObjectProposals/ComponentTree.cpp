@@ -0,0 +1,187 @@
+
+#include "ComponentTree.h"
+
+namespace ScallopTK
+{
+
+//------------------------------------------------------------------------------
+//                                 Helpers
+//------------------------------------------------------------------------------
+
+// Orders pixel indices by decreasing map value
+struct ctLevelGreater {
+  ctLevelGreater( const vector<float>& level ) : level( level ) {}
+  bool operator()( int a, int b ) const { return level[a] > level[b]; }
+  const vector<float>& level;
+};
+
+// Union-find root lookup with path halving
+inline int ctFindRoot( vector<int>& zpar, int p ) {
+  while( zpar[p] != p ) {
+    zpar[p] = zpar[zpar[p]];
+    p = zpar[p];
+  }
+  return p;
+}
+
+//------------------------------------------------------------------------------
+//                               Construction
+//------------------------------------------------------------------------------
+
+ComponentTree::ComponentTree( IplImage *map ) {
+
+  assert( map->depth == IPL_DEPTH_32F && map->nChannels == 1 );
+
+  width = map->width;
+  height = map->height;
+  const int n = width * height;
+  level.resize( n );
+  parent.assign( n, -1 );
+  boxIndex.assign( n, -1 );
+  for( int r=0; r<height; r++ ) {
+    float *ptr = (float*)(map->imageData + map->widthStep*r);
+    copy( ptr, ptr+width, level.begin()+r*width );
+  }
+
+  // The frame is always background, so nothing to build without an interior
+  if( width < 3 || height < 3 ) {
+    return;
+  }
+
+  // Sort interior pixels from brightest to darkest
+  vector<int> order;
+  order.reserve( (width-2)*(height-2) );
+  for( int r=1; r<height-1; r++ ) {
+    for( int c=1; c<width-1; c++ ) {
+      order.push_back( r*width+c );
+    }
+  }
+  stable_sort( order.begin(), order.end(), ctLevelGreater( level ) );
+
+  // Union-find over 8-connected neighbours, each new pixel becomes the
+  // parent of the components it touches and absorbs their bounding boxes
+  vector<int> zpar( n, -1 );
+  vector<CvRect> extent( n );
+  const int offsets[8] = { -width-1, -width, -width+1, -1, 1, width-1, width, width+1 };
+  for( size_t i=0; i<order.size(); i++ ) {
+    const int p = order[i];
+    const int pr = p / width;
+    const int pc = p % width;
+    parent[p] = p;
+    zpar[p] = p;
+    int minx = pc, maxx = pc, miny = pr, maxy = pr;
+    for( int k=0; k<8; k++ ) {
+      const int q = p + offsets[k];
+      const int qr = q / width;
+      const int qc = q % width;
+      if( qr < 1 || qr >= height-1 || qc < 1 || qc >= width-1 || zpar[q] == -1 ) {
+        continue;
+      }
+      const int root = ctFindRoot( zpar, q );
+      if( root != p ) {
+        parent[root] = p;
+        zpar[root] = p;
+        const CvRect& e = extent[root];
+        minx = min( minx, e.x );
+        miny = min( miny, e.y );
+        maxx = max( maxx, e.x + e.width - 1 );
+        maxy = max( maxy, e.y + e.height - 1 );
+      }
+    }
+    extent[p] = cvRect( minx, miny, maxx-minx+1, maxy-miny+1 );
+  }
+
+  // Canonicalize, parents are always processed after children so walk
+  // backwards to point every pixel at the first ancestor of lower level
+  for( int i=(int)order.size()-1; i>=0; i-- ) {
+    const int p = order[i];
+    const int q = parent[p];
+    if( level[parent[q]] == level[q] ) {
+      parent[p] = parent[q];
+    }
+  }
+
+  // Record canonical nodes, the last pixel merged at each level holds
+  // the complete bounding box of its component
+  for( size_t i=0; i<order.size(); i++ ) {
+    const int p = order[i];
+    const bool isRoot = ( parent[p] == p );
+    if( isRoot || level[parent[p]] != level[p] ) {
+      boxIndex[p] = boxes.size();
+      nodes.push_back( p );
+      boxes.push_back( extent[p] );
+      nodeLevels.push_back( level[p] );
+      parentLevels.push_back( isRoot ? -FLT_MAX : level[parent[p]] );
+    }
+  }
+  for( size_t i=0; i<nodes.size(); i++ ) {
+    if( parent[nodes[i]] == nodes[i] ) {
+      parent[nodes[i]] = -1;
+    }
+  }
+  sort( nodeLevels.begin(), nodeLevels.end() );
+  sort( parentLevels.begin(), parentLevels.end() );
+}
+
+//------------------------------------------------------------------------------
+//                                 Queries
+//------------------------------------------------------------------------------
+
+void ComponentTree::findNodes( int minSide, vector<int>& output ) const {
+  output.clear();
+  for( size_t i=0; i<nodes.size(); i++ ) {
+    if( boxes[i].width >= minSide && boxes[i].height >= minSide ) {
+      output.push_back( nodes[i] );
+    }
+  }
+}
+
+bool ComponentTree::isComponent( int node, float t ) const {
+  return level[node] > t && ( parent[node] == -1 || level[parent[node]] <= t );
+}
+
+int ComponentTree::countComponents( float t ) const {
+  int above = nodeLevels.end() - upper_bound( nodeLevels.begin(), nodeLevels.end(), t );
+  int parentsAbove = parentLevels.end() - upper_bound( parentLevels.begin(), parentLevels.end(), t );
+  return above - parentsAbove;
+}
+
+CvRect ComponentTree::boundingBox( int node ) const {
+  return boxes[ boxIndex[node] ];
+}
+
+IplImage *ComponentTree::extractComponent( int node, float t, CvPoint& offset ) const {
+
+  const CvRect box = boundingBox( node );
+  IplImage *mask = cvCreateImage( cvSize( box.width+2, box.height+2 ), IPL_DEPTH_8U, 1 );
+  cvZero( mask );
+  offset = cvPoint( box.x-1, box.y-1 );
+
+  // Flood fill the component from its canonical pixel, it never leaves box
+  vector<int> stack( 1, node );
+  mask->imageData[ (node/width-offset.y)*mask->widthStep + node%width-offset.x ] = 1;
+  while( !stack.empty() ) {
+    const int p = stack.back();
+    stack.pop_back();
+    const int pr = p / width;
+    const int pc = p % width;
+    for( int dr=-1; dr<=1; dr++ ) {
+      for( int dc=-1; dc<=1; dc++ ) {
+        const int qr = pr + dr;
+        const int qc = pc + dc;
+        if( qr < 1 || qr >= height-1 || qc < 1 || qc >= width-1 ) {
+          continue;
+        }
+        const int q = qr*width + qc;
+        char& m = mask->imageData[ (qr-offset.y)*mask->widthStep + qc-offset.x ];
+        if( m == 0 && level[q] > t ) {
+          m = 1;
+          stack.push_back( q );
+        }
+      }
+    }
+  }
+  return mask;
+}
+
+}
@@ -0,0 +1,88 @@
+#ifndef SCALLOP_TK_COMPONENT_TREE_H_
+#define SCALLOP_TK_COMPONENT_TREE_H_
+
+//------------------------------------------------------------------------------
+//                               Include Files
+//------------------------------------------------------------------------------
+
+//Standard C/C++
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+#include <assert.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+//Opencv
+#include <cv.h>
+#include <cxcore.h>
+
+//Scallop Includes
+#include "ScallopTK/Utilities/Definitions.h"
+
+namespace ScallopTK
+{
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+//                            Component Tree Class
+//------------------------------------------------------------------------------
+
+// Max-tree of a single channel 32f map
+//
+// Built once, the tree describes the 8-connected components of the binary
+// image (map > t) for every threshold t. The 1-pixel image frame is treated
+// as background, as cvFindContours does, so the components match a contour
+// search on cvThreshold( map, CV_THRESH_BINARY ) exactly.
+class ComponentTree {
+public:
+
+  // Builds the tree, O(n log n) for the initial sort, near-linear otherwise
+  explicit ComponentTree( IplImage *map );
+  ~ComponentTree() {}
+
+  // Nodes whose bounding box has both sides >= minSide (boxes only grow
+  // towards the root, so these are the only nodes worth testing)
+  void findNodes( int minSide, vector<int>& nodes ) const;
+
+  // Is node a whole component of (map > t)?
+  bool isComponent( int node, float t ) const;
+
+  // Total number of components in (map > t)
+  int countComponents( float t ) const;
+
+  // Bounding box of a node's component
+  CvRect boundingBox( int node ) const;
+
+  // Rasterizes node's component at threshold t into a new 8u mask with a
+  // 1 pixel zero border, offset is the image position of mask pixel (0,0)
+  IplImage *extractComponent( int node, float t, CvPoint& offset ) const;
+
+private:
+
+  // Map properties
+  int width;
+  int height;
+  vector<float> level;
+
+  // Parent of every pixel, canonical nodes point to the parent component
+  // and non-canonical pixels to their canonical node, roots are -1
+  vector<int> parent;
+
+  // Canonical nodes and their bounding boxes
+  vector<int> nodes;
+  vector<CvRect> boxes;
+
+  // Sorted node levels and parent levels, for counting components
+  vector<float> nodeLevels;
+  vector<float> parentLevels;
+
+  // Index into boxes for each pixel (-1 if not canonical)
+  vector<int> boxIndex;
+};
+
+}
+
+#endif
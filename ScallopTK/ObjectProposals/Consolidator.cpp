@@ -117,6 +117,67 @@ void prioritizeCandidates( CandidatePtrVector& Blob,
   kd_free( kd );
 }
 
+unsigned truncateCandidates( CandidatePtrVector& cds, unsigned maxCount ) {
+
+  if( maxCount == 0 || cds.size() <= maxCount )
+    return 0;
+
+  unsigned removed = cds.size() - maxCount;
+  for( unsigned int i = maxCount; i < cds.size(); i++ )
+    deallocateCandidate( cds[i] );
+  cds.resize( maxCount );
+  return removed;
+}
+
+static bool isStrongerResponse( const Candidate* cd1, const Candidate* cd2 ) {
+  return cd1->magnitude > cd2->magnitude;
+}
+
+unsigned capCandidates( CandidatePtrVector& cds, unsigned maxCount ) {
+
+  if( maxCount == 0 || cds.size() <= maxCount )
+    return 0;
+
+  std::stable_sort( cds.begin(), cds.end(), isStrongerResponse );
+  return truncateCandidates( cds, maxCount );
+}
+
+unsigned capCandidates( CandidatePtrVector& cds, unsigned maxCount,
+  IplImage *saliency, float scale ) {
+
+  if( maxCount == 0 || cds.size() <= maxCount )
+    return 0;
+
+  // Saliency at each center, paired with the original position for stability
+  vector< pair<float,int> > order( cds.size() );
+  for( unsigned int i = 0; i < cds.size(); i++ ) {
+    int r = (int)( cds[i]->r * scale );
+    int c = (int)( cds[i]->c * scale );
+    r = min( max( r, 0 ), saliency->height-1 );
+    c = min( max( c, 0 ), saliency->width-1 );
+    float value = ((float*)(saliency->imageData + saliency->widthStep*r))[c];
+    order[i] = make_pair( -value, (int)i );
+  }
+  std::sort( order.begin(), order.end() );
+
+  CandidatePtrVector ranked( cds.size() );
+  for( unsigned int i = 0; i < cds.size(); i++ )
+    ranked[i] = cds[ order[i].second ];
+  cds = ranked;
+
+  return truncateCandidates( cds, maxCount );
+}
+
+static bool isHigherPriority( const Candidate* cd1, const Candidate* cd2 ) {
+  return cd1->methodRank < cd2->methodRank;
+}
+
+void orderByPriority( CandidatePtrVector& cds ) {
+
+  // Equal ranks keep their consolidation order (template, blob, adaptive, canny)
+  std::stable_sort( cds.begin(), cds.end(), isHigherPriority );
+}
+
 void AddDFS( struct kdnode *ptr, CandidateQueue& Ordered ) {
 
   if( ptr == NULL )
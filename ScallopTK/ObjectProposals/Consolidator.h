@@ -15,6 +15,7 @@
 #include <math.h>
 #include <fstream>
 #include <queue>
+#include <algorithm>
 
 //Opencv
 #include <cv.h>
@@ -62,6 +63,24 @@ typedef priority_queue<Candidate*, CandidatePtrVector, CompareRank> CandidateQue
 void prioritizeCandidates( CandidatePtrVector& Blob, CandidatePtrVector& Adaptive,
   CandidatePtrVector& Template, CandidatePtrVector& Canny, CandidatePtrVector& Unordered,
   CandidateQueue& Ordered, ThreadStatistics *GS );
+
+// Keeps only the strongest maxCount proposals of a single detector, deleting
+// the rest, and returns how many were removed (0 means no limit). Ranks by
+// magnitude, which is the detector response for blob and template proposals
+unsigned capCandidates( CandidatePtrVector& cds, unsigned maxCount );
+
+// As above for adaptive proposals, which have no response of their own, so
+// are ranked by the saliency map value at their centers instead (map pixels
+// are scale times image pixels)
+unsigned capCandidates( CandidatePtrVector& cds, unsigned maxCount,
+  IplImage *saliency, float scale );
+
+// As above for proposals already in order of quality, keeping the first
+// maxCount (Canny proposals are in order of circle fit)
+unsigned truncateCandidates( CandidatePtrVector& cds, unsigned maxCount );
+
+// Sorts consolidated candidates into the same order as the priority queue
+void orderByPriority( CandidatePtrVector& cds );
   
 }
 
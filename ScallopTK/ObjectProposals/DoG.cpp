@@ -15,16 +15,16 @@ namespace ScallopTK
 
 //Functions for creating cross-channel trapezoidal DoG structure
 IplImage* formatBase( IplImage* img, float sigma, bool upscale, float maxRad );
-IplImage* downsample( IplImage* img );
-IplImage*** buildGaussTrap( IplImage* base, int octvs, int intvls, double sigma );
-IplImage*** buildDoGTrap( IplImage*** gaussTrap, int octvs, int intvls );
+void gaussIncrements( double* sig, int intvls, double sigma );
+IplImage** createOctaveViews( IplImage** pool, int levels, CvSize size );
+void releaseOctaveViews( IplImage*** views, int levels );
 IplImage*** mergeDoGChannels( IplImage*** DoGTrap, int octvs, int intvls );
 IplImage*** absDoGChannels( IplImage*** DoGTrap, int octvs, int intvls );
 
 //Candidate selection and filtering
-void detectExtremum( IplImage*** DoGTrap, int octvs, int intvls, double contr_thr, int curv_thr, CandidatePtrVector& kps, float minRad, float maxRad  );
-void detectMinExtremum( IplImage*** DoGTrap, int octvs, int intvls, double contr_thr, int curv_thr, CandidatePtrVector& kps, float minRad, float maxRad  );
-void detectMaxExtremum( IplImage*** DoGTrap, int octvs, int intvls, double contr_thr, int curv_thr, CandidatePtrVector& kps, float minRad, float maxRad  );
+bool isScaleScanned( int octv, int intvl, int intvls, float minRad, float maxRad );
+int scanExtremumRow( const float** rows, int start, int end, int mode, int* survivors );
+void detectExtremum( IplImage*** DoGTrap, int octv, int intvls, double contr_thr, int curv_thr, CandidatePtrVector& kps, float minRad, float maxRad, int mode );
 bool interpExtremum( IplImage*** DoGTrap, int octv, int intvl, int r, int c, int intvls, double contr_thr, DoG_Candidate& point );
 void interpStep( IplImage*** DoGTrap, int octv, int intvl, int r, int c, double* xi, double* xr, double* xc );
 CvMat* deriv3D( IplImage*** DoGTrap, int octv, int intvl, int r, int c );
@@ -63,26 +63,72 @@ bool findDoGCandidates( IplImage* input, CandidatePtrVector& kps, float minRad,
   //Compensate scanning radii
   minRad = minRad / DOG_COMPENSATION;
 
-  //Build gaussian trapezoid
-  IplImage*** gaussTrap = buildGaussTrap( init, octaves, intervals, sigma );  
-  IplImage*** DoGTrap = buildDoGTrap( gaussTrap, octaves, intervals );
+  //Octaves above the last one holding a scanned level are never built
+  int lastOctave = -1;
+  for( int o = 0; o < octaves; o++ )
+    for( int i = 1; i <= intervals; i++ )
+      if( isScaleScanned( o, i, intervals, minRad, maxRad ) )
+        lastOctave = o;
+
+  //Pooled level buffers sized for the first octave, every octave is built
+  //and scanned in turn within views of these (extrema never span octaves)
+  IplImage** gaussPool = (IplImage **)calloc( intervals + 3, sizeof( IplImage* ) );
+  IplImage** DoGPool = (IplImage **)calloc( intervals + 2, sizeof( IplImage* ) );
+  gaussPool[0] = init;
+  for( int i = 1; i < intervals + 3; i++ )
+    gaussPool[i] = cvCreateImage( cvGetSize(init), IPL_DEPTH_32F, init->nChannels );
+  for( int i = 0; i < intervals + 2; i++ )
+    DoGPool[i] = cvCreateImage( cvGetSize(init), IPL_DEPTH_32F, init->nChannels );
+
+  double* sig = (double *)calloc( intervals + 3, sizeof(double) );
+  gaussIncrements( sig, intervals, sigma );
+
+  IplImage*** DoGTrap = (IplImage ***) calloc( octaves, sizeof( IplImage** ) );
+  IplImage** gauss = createOctaveViews( gaussPool, intervals + 3, cvGetSize(init) );
+
+  for( int o = 0; o <= lastOctave; o++ ) {
+
+    bool scanned = false;
+    for( int i = 1; i <= intervals; i++ )
+      scanned = scanned || isScaleScanned( o, i, intervals, minRad, maxRad );
+
+    //Blur incrementally, unscanned octaves only feed the next octave's base
+    int levels = ( scanned ? intervals + 3 : intervals + 1 );
+    for( int i = 1; i < levels; i++ )
+      cvSmooth( gauss[i-1], gauss[i], CV_GAUSSIAN, 0, 0, sig[i], sig[i] );
+
+    //Take DoGs and find candidates in this octave
+    if( scanned ) {
+      DoGTrap[o] = createOctaveViews( DoGPool, intervals + 2, cvGetSize(gauss[0]) );
+      for( int i = 0; i < intervals + 2; i++ )
+        cvSub( gauss[i+1], gauss[i], DoGTrap[o][i], NULL );
+      detectExtremum( DoGTrap, o, intervals, 0.04f, 10, kps, minRad, maxRad, mode );
+      releaseOctaveViews( &DoGTrap[o], intervals + 2 );
+    }
 
-  //Find Candidates
-  if( mode == DOG_MIN ) {
-    detectMinExtremum( DoGTrap, octaves, intervals, 0.04f, 10, kps, minRad, maxRad );  
-  } else if( mode == DOG_MAX ) {
-    detectMaxExtremum( DoGTrap, octaves, intervals, 0.04f, 10, kps, minRad, maxRad );  
-  } else {
-    detectExtremum( DoGTrap, octaves, intervals, 0.04f, 10, kps, minRad, maxRad );
+    //Base of new octave is halved image from end of previous octave
+    if( o < lastOctave ) {
+      IplImage** next = createOctaveViews( gaussPool, intervals + 3,
+        cvSize( gauss[0]->width / 2, gauss[0]->height / 2 ) );
+      cvResize( gauss[intervals], next[0], CV_INTER_NN );
+      releaseOctaveViews( &gauss, intervals + 3 );
+      gauss = next;
+    }
   }
   
   //Adjust Candidates for scale & border
   adjustForScale( kps, upscale, maxRad );
 
   //Deallocate variables used
-  releaseTrap( &gaussTrap, octaves, intervals + 3 );
-  releaseTrap( &DoGTrap, octaves, intervals + 2 );
-  cvReleaseImage(&init);  
+  releaseOctaveViews( &gauss, intervals + 3 );
+  for( int i = 0; i < intervals + 3; i++ )
+    cvReleaseImage( &gaussPool[i] );
+  for( int i = 0; i < intervals + 2; i++ )
+    cvReleaseImage( &DoGPool[i] );
+  free( gaussPool );
+  free( DoGPool );
+  free( DoGTrap );
+  free( sig );
   return true;
 }
 
@@ -123,79 +169,39 @@ IplImage* formatBase( IplImage* img, float sigma, bool upscale, float maxRad )
   return base;
 }
 
-//Builds a gaussian trapezoid so that we can take DoGs
-IplImage*** buildGaussTrap( IplImage* base, int octvs, int intvls, double sigma )
+//Create array of smoothing increments for each interval
+void gaussIncrements( double* sig, int intvls, double sigma )
 {
-  // Declare required variables
-  IplImage*** gaussTrap;
-  double* sig = (double *)calloc( intvls + 3, sizeof(double));
-  int i, o;
-
-  // Allocated memory for trapezoidal structure
-  gaussTrap = (IplImage ***) calloc( octvs, sizeof( IplImage** ) );
-  for( i = 0; i < octvs; i++ )
-    gaussTrap[i] = (IplImage **)calloc( intvls + 3, sizeof( IplImage* ) );
-
-  // Create array of smoothing increments for each interval
   sig[0] = sigma;
   double k = pow( 2.0, 1.0 / intvls );
-  for( i = 1; i < intvls + 3; i++ )
+  for( int i = 1; i < intvls + 3; i++ )
   {
     double sig_prev = pow( k, i - 1 ) * sigma;
     double sig_total = sig_prev * k;
     sig[i] = sqrt( sig_total * sig_total - sig_prev * sig_prev );
   }
-
-  // Create images for each octave and interval
-  for( o = 0; o < octvs; o++ )
-    for( i = 0; i < intvls + 3; i++ )
-    {
-      if( o == 0  &&  i == 0 )
-        gaussTrap[o][i] = cvCloneImage(base);
-
-      /* base of new octvave is halved image from end of previous octave */
-      else if( i == 0 )
-        gaussTrap[o][i] = downsample( gaussTrap[o-1][intvls] );
-
-      /* blur the current octave's last image to create the next one */
-      else {
-        gaussTrap[o][i] = cvCreateImage( cvGetSize(gaussTrap[o][i-1]),
-          IPL_DEPTH_32F, gaussTrap[o][i-1]->nChannels );
-        cvSmooth( gaussTrap[o][i-1], gaussTrap[o][i],
-          CV_GAUSSIAN, 0, 0, sig[i], sig[i] );
-      }
-    }
-  free( sig );
-  return gaussTrap;
 }
 
-//Downsample an image by half
-IplImage* downsample( IplImage* img )
+//Image headers of the given size over the data of each pool buffer
+IplImage** createOctaveViews( IplImage** pool, int levels, CvSize size )
 {
-  IplImage* smaller = cvCreateImage( cvSize(img->width / 2, img->height / 2),
-    img->depth, img->nChannels );
-  cvResize( img, smaller, CV_INTER_NN );
-  return smaller;
+  IplImage** views = (IplImage **)calloc( levels, sizeof( IplImage* ) );
+  for( int i = 0; i < levels; i++ ) {
+    views[i] = cvCreateImageHeader( size, IPL_DEPTH_32F, pool[i]->nChannels );
+    cvSetData( views[i], pool[i]->imageData, pool[i]->widthStep );
+  }
+  return views;
 }
 
-
-//Takes the DoG from our pre-built gaussian trap
-IplImage*** buildDoGTrap( IplImage*** GaussTrap, int octvs, int intvls )
+//Releases views, but not the pool buffers they point into
+void releaseOctaveViews( IplImage*** views, int levels )
 {
-  IplImage*** DoGTrap;
-
-  DoGTrap = (IplImage ***) calloc( octvs, sizeof( IplImage** ) );
-  for( int i = 0; i < octvs; i++ )
-    DoGTrap[i] = (IplImage **)calloc( intvls + 2, sizeof(IplImage*) );
-
-  for( int o = 0; o < octvs; o++ ) {
-    for( int i = 0; i < intvls + 2; i++ ) {
-      DoGTrap[o][i] = cvCreateImage( cvGetSize(GaussTrap[o][i]), IPL_DEPTH_32F, GaussTrap[o][i]->nChannels );
-      cvSub( GaussTrap[o][i+1], GaussTrap[o][i], DoGTrap[o][i], NULL );
-      //showImageRange( DoGTrap[o][i] );
-    }
-  }
-  return DoGTrap;
+  if( !*views )
+    return;
+  for( int i = 0; i < levels; i++ )
+    cvReleaseImageHeader( &(*views)[i] );
+  free( *views );
+  *views = NULL;
 }
 
 //Merges DoG channels
@@ -260,149 +266,120 @@ IplImage*** absDoGChannels( IplImage*** DoGTrap, int octvs, int intvls )
 //                    Extrema Localization and Filtering
 //------------------------------------------------------------------------------
 
-int isMax( IplImage*** DoGTrap, int octv, int intvl, int r, int c )
-{
-  float val = getPixel32f( DoGTrap[octv][intvl], r, c );
-  int i, j, k;
-
-  /* check for maximum */
-  for( i = -1; i <= 1; i++ )
-    for( j = -1; j <= 1; j++ )
-      for( k = -1; k <= 1; k++ )
-        if( val > getPixel32f( DoGTrap[octv][intvl + i], r + j, c + k ) )
-          return false;
-
-
-  return true;
-}
-
-int isMin( IplImage*** DoGTrap, int octv, int intvl, int r, int c )
+//Does level intvl of octave octv fall within the scanned radius range
+bool isScaleScanned( int octv, int intvl, int intvls, float minRad, float maxRad )
 {
-  float val = getPixel32f( DoGTrap[octv][intvl], r, c );
-  int i, j, k;
+  float nextScaleSigma = 2*DOG_SIGMA*pow(2.0f,octv+(intvl+1)/intvls);
+  float prevScaleSigma = 2*DOG_SIGMA*pow(2.0f,octv+(intvl-1)/intvls);
 
-  /* check for maximum */
-  for( i = -1; i <= 1; i++ )
-    for( j = -1; j <= 1; j++ )
-      for( k = -1; k <= 1; k++ )
-        if( val < getPixel32f( DoGTrap[octv][intvl + i], r + j, c + k ) )
-          return false;
-
-
-  return true;
+  return !( nextScaleSigma <= minRad || prevScaleSigma >= maxRad );
 }
 
-//Detect and Filter Scale Space Extrenum
-void detectMinExtremum( IplImage*** DoGTrap, int octvs, int intvls, double contr_thr, int curv_thr, CandidatePtrVector& kps, float minRad, float maxRad )
+//Tests a row of DoG pixels against their 26 scale space neighbours
+//
+//rows[3*l+j] is row r+j-1 of level intvl+l-1, so rows[4] is the scanned row.
+//A minimum is >= all neighbours and a maximum <= all neighbours (ties kept),
+//columns in [start,end) passing the test for mode are written to survivors
+//in increasing order, and their count returned.
+int scanExtremumRow( const float** rows, int start, int end, int mode, int* survivors )
 {
-  for( int o = 0; o < octvs; o++ ) {
-    for( int i = 1; i <= intvls; i++ ) {
-
-      float nextScaleSigma = 2*DOG_SIGMA*pow(2.0f,o+(i+1)/intvls);
-      float prevScaleSigma = 2*DOG_SIGMA*pow(2.0f,o+(i-1)/intvls);
-
-      if( nextScaleSigma <= minRad || prevScaleSigma >= maxRad )
-        continue;
-
-      for( int r = DOG_SCAN_START; r < DoGTrap[o][i]->height-DOG_SCAN_START; r++ ) {
-        for( int c = DOG_SCAN_START; c < DoGTrap[o][i]->width-DOG_SCAN_START; c++ ) {
-          if( isMin( DoGTrap, o, i, r, c ) )  
-          {  
-            DoG_Candidate point;
-            if( interpExtremum(DoGTrap, o, i, r, c, intvls, contr_thr, point) ) 
-            {
-              Candidate* to_add = new Candidate;
-              to_add->r = point.y;
-              to_add->c = point.x;
-              to_add->major = DOG_COMPENSATION*DOG_SIGMA*
-                pow(2.0f,point.octv+(point.intvl+point.subintvl)/intvls);
-              to_add->minor = to_add->major;
-              to_add->angle = 0.0;
-              to_add->method = DOG;
-              to_add->magnitude = getPixel32f( DoGTrap[o][i], r, c );
-              kps.push_back( to_add );
-            }
-          }
+  const bool testMin = ( mode != DOG_MAX );
+  const bool testMax = ( mode != DOG_MIN );
+  int count = 0;
+  int c = start;
+
+#if SCALLOP_TK_SSE2
+  //Scanned level first, it rejects most pixels before the others are read
+  static const int levelOrder[3] = { 1, 0, 2 };
+  const __m128 none = _mm_setzero_ps();
+  const __m128 all = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+
+  for( ; c <= end-4; c+=4 ) {
+    const __m128 val = _mm_loadu_ps( rows[4]+c );
+    __m128 minMask = ( testMin ? all : none );
+    __m128 maxMask = ( testMax ? all : none );
+    int bits = 0;
+    for( int l = 0; l < 3; l++ ) {
+      const float** level = rows + 3*levelOrder[l];
+      for( int j = 0; j < 3; j++ ) {
+        for( int k = -1; k <= 1; k++ ) {
+          const __m128 nb = _mm_loadu_ps( level[j]+c+k );
+          minMask = _mm_and_ps( minMask, _mm_cmpnlt_ps( val, nb ) );
+          maxMask = _mm_and_ps( maxMask, _mm_cmpngt_ps( val, nb ) );
         }
       }
+      bits = _mm_movemask_ps( _mm_or_ps( minMask, maxMask ) );
+      if( bits == 0 )
+        break;
     }
+    for( int b = 0; b < 4; b++ )
+      if( bits & ( 1 << b ) )
+        survivors[count++] = c + b;
   }
-}
+#endif
 
-//Detect and Filter Scale Space Extrenum
-void detectMaxExtremum( IplImage*** DoGTrap, int octvs, int intvls, double contr_thr, int curv_thr, CandidatePtrVector& kps, float minRad, float maxRad )
-{
-  for( int o = 0; o < octvs; o++ ) {
-    for( int i = 1; i <= intvls; i++ ) {
-
-      float nextScaleSigma = 2*DOG_SIGMA*pow(2.0f,o+(i+1)/intvls);
-      float prevScaleSigma = 2*DOG_SIGMA*pow(2.0f,o+(i-1)/intvls);
-
-      if( nextScaleSigma <= minRad || prevScaleSigma >= maxRad )
-        continue;
-
-      for( int r = DOG_SCAN_START; r < DoGTrap[o][i]->height-DOG_SCAN_START; r++ ) {
-        for( int c = DOG_SCAN_START; c < DoGTrap[o][i]->width-DOG_SCAN_START; c++ ) {
-          if( isMax( DoGTrap, o, i, r, c ) )  
-          {  
-            DoG_Candidate point;
-            if( interpExtremum(DoGTrap, o, i, r, c, intvls, contr_thr, point) ) 
-            {
-              Candidate* to_add = new Candidate;
-              to_add->r = point.y;
-              to_add->c = point.x;
-              to_add->major = DOG_COMPENSATION*DOG_SIGMA*
-                pow(2.0f,point.octv+(point.intvl+point.subintvl)/intvls);
-              to_add->minor = to_add->major;
-              to_add->angle = 0.0;
-              to_add->method = DOG;
-              to_add->magnitude = getPixel32f( DoGTrap[o][i], r, c );
-              kps.push_back( to_add );
-            }
-          }
-        }
+  for( ; c < end; c++ ) {
+    const float val = rows[4][c];
+    bool isMin = testMin;
+    bool isMax = testMax;
+    for( int j = 0; j < 9 && ( isMin || isMax ); j++ ) {
+      for( int k = -1; k <= 1; k++ ) {
+        if( val < rows[j][c+k] )
+          isMin = false;
+        if( val > rows[j][c+k] )
+          isMax = false;
       }
     }
+    if( isMin || isMax )
+      survivors[count++] = c;
   }
+  return count;
 }
 
-//Detect and Filter Scale Space Extrenum
-void detectExtremum( IplImage*** DoGTrap, int octvs, int intvls, double contr_thr, int curv_thr, CandidatePtrVector& kps, float minRad, float maxRad )
+//Detect and Filter Scale Space Extrenum within a single octave
+void detectExtremum( IplImage*** DoGTrap, int octv, int intvls, double contr_thr, int curv_thr, CandidatePtrVector& kps, float minRad, float maxRad, int mode )
 {
-  for( int o = 0; o < octvs; o++ ) {
-    for( int i = 1; i <= intvls; i++ ) {
-
-      float nextScaleSigma = 2*DOG_SIGMA*pow(2.0f,o+(i+1)/intvls);
-      float prevScaleSigma = 2*DOG_SIGMA*pow(2.0f,o+(i-1)/intvls);
-
-      if( nextScaleSigma <= minRad || prevScaleSigma >= maxRad )
-        continue;
-
-      for( int r = DOG_SCAN_START; r < DoGTrap[o][i]->height-DOG_SCAN_START; r++ ) {
-        for( int c = DOG_SCAN_START; c < DoGTrap[o][i]->width-DOG_SCAN_START; c++ ) {
-          if( isMin( DoGTrap, o, i, r, c ) || isMax( DoGTrap, o, i, r, c ) )  
-          {  
-            DoG_Candidate point;
-            if( interpExtremum(DoGTrap, o, i, r, c, intvls, contr_thr, point) ) 
-            {
-              Candidate* to_add = new Candidate;
-              to_add->r = point.y;
-              to_add->c = point.x;
-              to_add->major = DOG_COMPENSATION*DOG_SIGMA*
-                pow(2.0f,point.octv+(point.intvl+point.subintvl)/intvls);
-              to_add->minor = to_add->major;
-              to_add->angle = 0.0;
-              to_add->method = DOG;
-              to_add->magnitude = getPixel32f( DoGTrap[o][i], r, c );
-              kps.push_back( to_add );
-            }
-          }
+  const int o = octv;
+  const int width = DoGTrap[o][0]->width;
+  const int height = DoGTrap[o][0]->height;
+  vector<int> survivors( width + 1 );
+  const float* rows[9];
+
+  for( int i = 1; i <= intvls; i++ ) {
+
+    if( !isScaleScanned( o, i, intvls, minRad, maxRad ) )
+      continue;
+
+    for( int r = DOG_SCAN_START; r < height-DOG_SCAN_START; r++ ) {
+
+      for( int l = 0; l < 3; l++ ) {
+        IplImage* level = DoGTrap[o][i+l-1];
+        for( int j = 0; j < 3; j++ )
+          rows[3*l+j] = (float*)(level->imageData + level->widthStep*(r+j-1));
+      }
+
+      int count = scanExtremumRow( rows, DOG_SCAN_START, width-DOG_SCAN_START, mode, &survivors[0] );
+
+      for( int s = 0; s < count; s++ ) {
+        const int c = survivors[s];
+        DoG_Candidate point;
+        if( interpExtremum(DoGTrap, o, i, r, c, intvls, contr_thr, point) ) 
+        {
+          Candidate* to_add = new Candidate;
+          to_add->r = point.y;
+          to_add->c = point.x;
+          to_add->major = DOG_COMPENSATION*DOG_SIGMA*
+            pow(2.0f,point.octv+(point.intvl+point.subintvl)/intvls);
+          to_add->minor = to_add->major;
+          to_add->angle = 0.0;
+          to_add->method = DOG;
+          to_add->magnitude = getPixel32f( DoGTrap[o][i], r, c );
+          kps.push_back( to_add );
         }
       }
     }
   }
 }
-
 bool interpExtremum( IplImage*** DoGTrap, int octv, int intvl, int r, int c, int intvls, double contr_thr, DoG_Candidate& point )
 {
   double xi, xr, xc, contr;
@@ -24,6 +24,7 @@
 //Scallop Includes
 #include "ScallopTK/Utilities/Definitions.h"
 #include "ScallopTK/Utilities/HelperFunctions.h"
+#include "ScallopTK/Utilities/SIMD.h"
 
 //Visual Debugger
 #ifdef ENABLE_VISUAL_DEBUGGER
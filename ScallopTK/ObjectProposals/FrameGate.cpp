@@ -0,0 +1,139 @@
+
+#include "FrameGate.h"
+
+namespace ScallopTK
+{
+
+//------------------------------------------------------------------------------
+//                            Function Definitions
+//------------------------------------------------------------------------------
+
+// Fraction of thumbnail pixels whose color is rare within the thumbnail
+static float salientFraction( IplImage *thumbnail ) {
+
+  salFilter saliency;
+  saliency.allocMap( GATE_SALIENCY_BINS );
+  saliency.buildMap( thumbnail );
+  saliency.smoothHist();
+
+  // The saliency map holds negated (smoothed) color bin counts
+  IplImage *map = saliency.classify3dImage( thumbnail );
+  const float rareCount = GATE_RARE_COLOR_FRACTION * map->width * map->height;
+  int salient = 0;
+
+  for( int r=0; r<map->height; r++ ) {
+    float *ptr = (float*)(map->imageData + r*map->widthStep);
+    for( int c=0; c<map->width; c++ ) {
+      if( -ptr[c] < rareCount ) {
+        salient++;
+      }
+    }
+  }
+
+  float fraction = salient / (float)( map->width * map->height );
+  cvReleaseImage( &map );
+  return fraction;
+}
+
+int gateFrame( const cv::Mat& image, int format, const FrameGateParameters& params ) {
+
+  if( image.cols == 0 || image.rows == 0 ) {
+    return GATE_PASSED;
+  }
+
+  const int width = min( GATE_THUMBNAIL_WIDTH, image.cols );
+  const int height = max( ( width * image.rows ) / image.cols, 1 );
+  const cv::Size size( width, height );
+  cv::Mat converted, thumbnail, grey;
+
+  if( format == PIXEL_FORMAT_BGR || format == PIXEL_FORMAT_RGB ||
+      format == PIXEL_FORMAT_GRAY ) {
+    // Nearest neighbour sampling only touches thumbnail pixels
+    cv::Mat sampled;
+    cv::resize( image, sampled, size, 0, 0, cv::INTER_NEAREST );
+    convertPixelFormat( sampled, format, size, converted );
+  } else {
+    // Sampling a Bayer mosaic would mix up its color sites
+    convertPixelFormat( image, format, size, converted );
+  }
+
+  converted.convertTo( thumbnail, CV_8U, converted.depth() == CV_16U ? 1.0/257.0 : 1.0 );
+  cv::cvtColor( thumbnail, grey, CV_BGR2GRAY );
+
+  // Grey level histogram
+  int hist[256];
+  for( int i=0; i<256; i++ ) {
+    hist[i] = 0;
+  }
+  for( int r=0; r<grey.rows; r++ ) {
+    const unsigned char *ptr = grey.ptr<unsigned char>( r );
+    for( int c=0; c<grey.cols; c++ ) {
+      hist[ ptr[c] ]++;
+    }
+  }
+  const float pixels = grey.rows * grey.cols;
+
+  // Strobe failures and blown out frames
+  int dark = 0, bright = 0;
+  for( int i=0; i<=GATE_CLIP_LEVEL; i++ ) {
+    dark += hist[i];
+    bright += hist[255-i];
+  }
+  if( dark > params.MaxClippedFraction * pixels ) {
+    return GATE_UNDEREXPOSED;
+  }
+  if( bright > params.MaxClippedFraction * pixels ) {
+    return GATE_OVEREXPOSED;
+  }
+
+  // Turbid water and sediment plumes, from the grey level percentile spread
+  int lower = -1, upper = -1, count = 0;
+  for( int i=0; i<256; i++ ) {
+    count += hist[i];
+    if( lower < 0 && count >= GATE_CONTRAST_LOWER * pixels ) {
+      lower = i;
+    }
+    if( upper < 0 && count >= GATE_CONTRAST_UPPER * pixels ) {
+      upper = i;
+    }
+  }
+  if( ( upper - lower ) / 255.0f < params.MinContrast ) {
+    return GATE_LOW_CONTRAST;
+  }
+
+  // Featureless water column
+  float entropy = 0.0f;
+  for( int i=0; i<256; i++ ) {
+    if( hist[i] > 0 ) {
+      float p = hist[i] / pixels;
+      entropy -= p * log( p ) / log( 2.0f );
+    }
+  }
+  if( entropy < params.MinEntropy ) {
+    return GATE_LOW_ENTROPY;
+  }
+
+  // Nothing stands out from the background colors
+  if( params.MinSalientFraction > 0.0f ) {
+    IplImage thumbnailIpl = thumbnail;
+    if( salientFraction( &thumbnailIpl ) < params.MinSalientFraction ) {
+      return GATE_LOW_SALIENCY;
+    }
+  }
+
+  return GATE_PASSED;
+}
+
+const char *gateResultName( int result ) {
+  switch( result ) {
+    case GATE_PASSED:       return "passed";
+    case GATE_UNDEREXPOSED: return "underexposed";
+    case GATE_OVEREXPOSED:  return "overexposed";
+    case GATE_LOW_CONTRAST: return "low contrast";
+    case GATE_LOW_ENTROPY:  return "low entropy";
+    case GATE_LOW_SALIENCY: return "low saliency";
+  }
+  return "unknown";
+}
+
+}
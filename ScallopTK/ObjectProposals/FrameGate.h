@@ -0,0 +1,90 @@
+#ifndef SCALLOP_TK_FRAME_GATE_H_
+#define SCALLOP_TK_FRAME_GATE_H_
+
+//------------------------------------------------------------------------------
+//                               Include Files
+//------------------------------------------------------------------------------
+
+//Standard C/C++
+#include <math.h>
+#include <algorithm>
+
+//Opencv
+#include <cv.h>
+#include <cxcore.h>
+
+//Scallop Includes
+#include "ScallopTK/Utilities/Definitions.h"
+#include "ScallopTK/Utilities/PixelFormats.h"
+#include "ScallopTK/ObjectProposals/HistogramFiltering.h"
+
+namespace ScallopTK
+{
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+//                                 Constants
+//------------------------------------------------------------------------------
+
+// Width of the thumbnail all gate statistics are computed on
+const int GATE_THUMBNAIL_WIDTH = 128;
+
+// Grey levels at or below (above 255 minus) this count as clipped
+const int GATE_CLIP_LEVEL = 8;
+
+// Percentiles whose grey level spread measures contrast
+const float GATE_CONTRAST_LOWER = 0.05f;
+const float GATE_CONTRAST_UPPER = 0.95f;
+
+// Bins per channel of the thumbnail saliency histogram
+const int GATE_SALIENCY_BINS = 16;
+
+// Pixels whose smoothed color bin holds less than this fraction of the
+// thumbnail are salient
+const float GATE_RARE_COLOR_FRACTION = 0.01f;
+
+//------------------------------------------------------------------------------
+//                              Class Definitions
+//------------------------------------------------------------------------------
+
+// Thresholds for rejecting a frame, defaults only reject degenerate frames
+struct FrameGateParameters
+{
+  // Max fraction of pixels clipped to black or white
+  float MaxClippedFraction;
+
+  // Min spread between the grey level percentiles, in [0,1]
+  float MinContrast;
+
+  // Min grey level histogram entropy, in bits
+  float MinEntropy;
+
+  // Min fraction of pixels with rare colors
+  float MinSalientFraction;
+
+  FrameGateParameters()
+  : MaxClippedFraction( 0.95f ),
+    MinContrast( 0.02f ),
+    MinEntropy( 1.0f ),
+    MinSalientFraction( 0.0001f )
+  {}
+};
+
+//------------------------------------------------------------------------------
+//                             Function Prototypes
+//------------------------------------------------------------------------------
+
+// Checks whether a frame could contain any targets from a nearest neighbour
+// thumbnail (exposure, contrast, grey level entropy and the mass of rare
+// colors under a salFilter), returns GATE_PASSED or the rejection reason
+//
+// The image can be in any PIXEL_FORMAT_*, only the thumbnail is converted
+int gateFrame( const cv::Mat& image, int format, const FrameGateParameters& params );
+
+// Printable name for a gate result
+const char *gateResultName( int result );
+
+}
+
+#endif
@@ -8,29 +8,47 @@
 namespace ScallopTK
 {
 
-//Class constructor, loads the desired filter from file
-bool hfFilter::loadFromFile( const string& filter_fn, bool allocSecondary ) {
+//Process-wide cache of mapped filter banks, keyed by filename
+static cv::Mutex filterBankLock;
+static map< string, cv::Ptr<hfFilterBank> > filterBankCache;
 
-  //Default Init
-  filterLoaded = false;
-  filter3d = NULL;
-  secondary3d = NULL;
+//Returns the shared bank for a filter file, mapping it on first use
+cv::Ptr<hfFilterBank> hfFilterBank::load( const string& filter_fn ) {
+
+  cv::AutoLock lock( filterBankLock );
+
+  map< string, cv::Ptr<hfFilterBank> >::iterator itr = filterBankCache.find( filter_fn );
+  if( itr != filterBankCache.end() ) {
+    return itr->second;
+  }
+
+  cv::Ptr<hfFilterBank> bank = new hfFilterBank();
+  if( !bank->parse( filter_fn ) ) {
+    return cv::Ptr<hfFilterBank>();
+  }
 
-  //Read header data and checksums
-  string fn_w_dir = filter_fn;
-  ifstream filtin (fn_w_dir.c_str(), ios::in | ios::binary);
-  if( !filtin.is_open() ) {
+  filterBankCache[ filter_fn ] = bank;
+  return bank;
+}
+
+//Maps the desired filter file and reads its header, no data is copied
+bool hfFilterBank::parse( const string& filter_fn ) {
+
+  //Map file and check it can at least contain a header
+  if( !file.open( filter_fn ) ) {
     cerr << "ERROR: Color filter file does not exist in this directory!" << endl;
     return false;
   }
+  if( file.size() < (size_t)HEADER_BYTES ) {
+    cerr << "ERROR: Invalid or Corrupt Filter File" << endl;
+    return false;
+  }
 
   //Read header information
-  char* buffer = new char[HEADER_BYTES];
-  filtin.read( buffer, HEADER_BYTES );
-  float* float_rdr = (float*) buffer;
-  int* int_rdr = (int*) buffer;
+  const float* float_rdr = (const float*) file.data();
+  const int* int_rdr = (const int*) file.data();
   int Checksum1 = int_rdr[0];
-  numChan = int_rdr[1];
+  int numChan = int_rdr[1];
   histBinsCh1 = int_rdr[2];
   histBinsCh2 = int_rdr[3];
   histBinsCh3 = int_rdr[4];
@@ -52,33 +70,20 @@ bool hfFilter::loadFromFile( const string& filter_fn, bool allocSecondary ) {
     return false;
   }
 
-  //Dealloc initial read
-  delete[] buffer;
-
-  //Read filter data
-  int bytesRemaining = histBinsCh1*histBinsCh2*histBinsCh3*4 + 4;
-  buffer = new char[bytesRemaining];
-  filtin.read( buffer, bytesRemaining );
-  float_rdr = (float*) buffer;
-  int_rdr = (int*) buffer;
-
   //Scaling factors to help with formating
   size = histBinsCh1*histBinsCh2*histBinsCh3;
   ch1_scale = histBinsCh3*histBinsCh2;
   ch2_scale = histBinsCh3;
 
-  //Format filter data
-  filter3d = new float[size];
-  if( allocSecondary )
-    secondary3d = new float[size];
-  
-  //Copy into filter3d buffer
-  for( int i=0; i<size; i++ ) {
-    filter3d[i] = float_rdr[i];
+  //Filter data directly follows header, with a final checksum after it
+  if( file.size() < (size_t)HEADER_BYTES + size*4 + 4 ) {
+    cerr << "ERROR: Invalid or Corrupt Filter File!" << endl;
+    return false;
   }
+  filter3d = (const float*)( file.data() + HEADER_BYTES );
 
   //Check final checksum
-  if( int_rdr[size] != CHECKSUM ) {
+  if( ((const int*)filter3d)[size] != CHECKSUM ) {
     cerr << "ERROR: Invalid or Corrupt Filter File!" << endl;
     return false;
   }
@@ -88,16 +93,57 @@ bool hfFilter::loadFromFile( const string& filter_fn, bool allocSecondary ) {
   bprCh2 = histBinsCh2 / (endCh2 - startCh2);
   bprCh3 = histBinsCh3 / (endCh3 - startCh3);
 
-  //Dealloc and indicate success
-  delete[] buffer;
+  //Precompute bin offsets for 8-bit input
+  buildLUTs();
+  return true;
+}
+
+// Fills the 8-bit lookup tables, each 8-bit value v is mapped to the same
+// bin the 32f path would give the value v/255
+void hfFilterBank::buildLUTs() {
+  for( int v = 0; v < LUT_ENTRIES; v++ ) {
+    float val = v / 255.0f;
+    int b1 = (int)((val - startCh1) * bprCh1);
+    int b2 = (int)((val - startCh2) * bprCh2);
+    int b3 = (int)((val - startCh3) * bprCh3);
+    lutCh1[v] = ( b1 < 0 || b1 >= histBinsCh1 ? LUT_INVALID : b1*ch1_scale );
+    lutCh2[v] = ( b2 < 0 || b2 >= histBinsCh2 ? LUT_INVALID : b2*ch2_scale );
+    lutCh3[v] = ( b3 < 0 || b3 >= histBinsCh3 ? LUT_INVALID : b3 );
+  }
+}
+
+//Loads the desired filter, sharing the underlying bank if already loaded
+bool hfFilter::loadFromFile( const string& filter_fn, bool allocSecondary ) {
+
+  //Default Init
+  if( private3d != NULL ) {
+    delete[] private3d;
+  }
+  if( secondary3d != NULL ) {
+    delete[] secondary3d;
+  }
+  filterLoaded = false;
+  filter3d = NULL;
+  private3d = NULL;
+  secondary3d = NULL;
+  secondaryAllowed = allocSecondary;
+
+  //Get shared filter contents
+  bank = hfFilterBank::load( filter_fn );
+  if( bank.empty() ) {
+    return false;
+  }
+
+  //Indicate success
+  filter3d = bank->filter3d;
   filterLoaded = true;
   return true;
 }
 
-// Class deconstructor (Deallocates filters)
+// Class deconstructor (Deallocates filters, bank is reference counted)
 hfFilter::~hfFilter() {
-  if( filter3d != NULL ) {
-    delete[] filter3d;
+  if( private3d != NULL ) {
+    delete[] private3d;
   }
   if( secondary3d != NULL ) {
     delete[] secondary3d;
@@ -106,42 +152,43 @@ hfFilter::~hfFilter() {
   
 // Classifies a 3-d point based off of the loaded histogram
 float hfFilter::classifyPoint3d( float* pt ) {
-  int b1 = (int)(histBinsCh1 * (pt[0] - startCh1) / (endCh1 - startCh1));
-  int b2 = (int)(histBinsCh2 * (pt[1] - startCh2) / (endCh2 - startCh2));
-  int b3 = (int)(histBinsCh3 * (pt[2] - startCh3) / (endCh3 - startCh3));
-
-  if( b1 < 0 || b1 >= histBinsCh1 || 
-    b2 < 0 || b2 >= histBinsCh2 || 
-    b3 < 0 || b3 >= histBinsCh3 ) {
+  const hfFilterBank& b = *bank;
+  int b1 = (int)(b.histBinsCh1 * (pt[0] - b.startCh1) / (b.endCh1 - b.startCh1));
+  int b2 = (int)(b.histBinsCh2 * (pt[1] - b.startCh2) / (b.endCh2 - b.startCh2));
+  int b3 = (int)(b.histBinsCh3 * (pt[2] - b.startCh3) / (b.endCh3 - b.startCh3));
+
+  if( b1 < 0 || b1 >= b.histBinsCh1 || 
+    b2 < 0 || b2 >= b.histBinsCh2 || 
+    b3 < 0 || b3 >= b.histBinsCh3 ) {
     return 0.0f;
   }
   
-  return *(filter3d+b1*ch1_scale+b2*ch2_scale+b3);
+  return *(filter3d+b1*b.ch1_scale+b2*b.ch2_scale+b3);
 }
 
 //FAST FILTER - UNSTABLE IF USED INCORRECTLY
 IplImage *hfFilter::classify3dImage( IplImage *img ) {
   assert( img->nChannels == 3 );
+  if( img->depth == IPL_DEPTH_8U )
+    return classify3dImage8u( img );
   assert( img->depth == IPL_DEPTH_32F );
+  const hfFilterBank& b = *bank;
   IplImage *output = cvCreateImage( cvGetSize( img ), IPL_DEPTH_32F, 1 );
-  int istep = img->widthStep;
-  int ostep = output->widthStep;
   int height = output->height;
   int width = output->width;
   float *ivalue = (float*)(img->imageData);
   float *ovalue = (float*)(output->imageData);
-  char *test = output->imageData;
   for( int i=0; i<height*width; i++ ) {
-    int b1 = (int)((ivalue[0] - startCh1) * bprCh1);
-    int b2 = (int)((ivalue[1] - startCh2) * bprCh2);
-    int b3 = (int)((ivalue[2] - startCh3) * bprCh3);
+    int b1 = (int)((ivalue[0] - b.startCh1) * b.bprCh1);
+    int b2 = (int)((ivalue[1] - b.startCh2) * b.bprCh2);
+    int b3 = (int)((ivalue[2] - b.startCh3) * b.bprCh3);
 
-    if( b1 < 0 || b1 >= histBinsCh1 || 
-      b2 < 0 || b2 >= histBinsCh2 || 
-      b3 < 0 || b3 >= histBinsCh3 ) {
+    if( b1 < 0 || b1 >= b.histBinsCh1 || 
+      b2 < 0 || b2 >= b.histBinsCh2 || 
+      b3 < 0 || b3 >= b.histBinsCh3 ) {
       *ovalue = 0.0f;
     } else {    
-      *ovalue = *(filter3d+ch1_scale*b1+ch2_scale*b2+b3);
+      *ovalue = *(filter3d+b.ch1_scale*b1+b.ch2_scale*b2+b3);
     }
 
     ivalue = ivalue + 3;
@@ -150,32 +197,99 @@ IplImage *hfFilter::classify3dImage( IplImage *img ) {
   return output;
 }
 
+// 8-bit version of the above, a table lookup per channel instead of float math
+IplImage *hfFilter::classify3dImage8u( IplImage *img ) {
+  assert( img->nChannels == 3 );
+  assert( img->depth == IPL_DEPTH_8U );
+  const int *lutCh1 = bank->lutCh1;
+  const int *lutCh2 = bank->lutCh2;
+  const int *lutCh3 = bank->lutCh3;
+  IplImage *output = cvCreateImage( cvGetSize( img ), IPL_DEPTH_32F, 1 );
+  int height = output->height;
+  int width = output->width;
+  for( int r=0; r<height; r++ ) {
+    unsigned char *ivalue = (unsigned char*)(img->imageData + r*img->widthStep);
+    float *ovalue = (float*)(output->imageData + r*output->widthStep);
+    for( int c=0; c<width; c++, ivalue += 3 ) {
+      int o1 = lutCh1[ivalue[0]];
+      int o2 = lutCh2[ivalue[1]];
+      int o3 = lutCh3[ivalue[2]];
+      ovalue[c] = ( (o1 | o2 | o3) < 0 ? 0.0f : filter3d[o1+o2+o3] );
+    }
+  }
+  return output;
+}
+
+void hfFilter::allocSecondary() {
+  assert( secondaryAllowed );
+  if( secondary3d == NULL ) {
+    secondary3d = new float[bank->size];
+    flushSecondary();
+  }
+}
+
 void hfFilter::flushSecondary() {
+  if( secondary3d == NULL ) {
+    allocSecondary();
+    return;
+  }
   float *ptr = secondary3d;
-  for( int i = 0; i < size; i++ ) {
+  for( int i = 0; i < bank->size; i++ ) {
     *(ptr+i) = 0.0f;
   }
 }
 
 void hfFilter::mergeSecondary( float ratio, float secondaryDown ) {
 
-  for( int i = 0; i < size; i++ ) {
-    filter3d[i] = ratio * secondary3d[i] * secondaryDown
-          + (1-ratio) * filter3d[i];
+  // Copy on write, the shared bank is never modified
+  if( private3d == NULL ) {
+    private3d = new float[bank->size];
+    memcpy( private3d, bank->filter3d, bank->size * sizeof(float) );
   }
+
+  mergeSecondary( ratio, secondaryDown, private3d, private3d );
+  filter3d = private3d;
 }
 
-int hfFilter::insertInSecondary( float *val ) {
-  int b1 = (int)((val[0] - startCh1) * bprCh1);
-  int b2 = (int)((val[1] - startCh2) * bprCh2);
-  int b3 = (int)((val[2] - startCh3) * bprCh3);
+void hfFilter::mergeSecondary( float ratio, float secondaryDown,
+  const float *src, float *dst ) const {
+
+  // Nothing was ever inserted, secondary is all 0s
+  if( secondary3d == NULL ) {
+    for( int i = 0; i < bank->size; i++ ) {
+      dst[i] = (1-ratio) * src[i];
+    }
+    return;
+  }
+
+  for( int i = 0; i < bank->size; i++ ) {
+    dst[i] = ratio * secondary3d[i] * secondaryDown
+          + (1-ratio) * src[i];
+  }
+}
+
+void hfFilter::setPrimary( const float *primary ) {
+  if( primary != NULL )
+    filter3d = primary;
+  else if( private3d != NULL )
+    filter3d = private3d;
+  else
+    filter3d = bank->filter3d;
+}
 
-  if( b1 < 0 || b1 >= histBinsCh1 || 
-    b2 < 0 || b2 >= histBinsCh2 || 
-    b3 < 0 || b3 >= histBinsCh3 ) {
+int hfFilter::insertInSecondary( float *val ) {
+  const hfFilterBank& b = *bank;
+  int b1 = (int)((val[0] - b.startCh1) * b.bprCh1);
+  int b2 = (int)((val[1] - b.startCh2) * b.bprCh2);
+  int b3 = (int)((val[2] - b.startCh3) * b.bprCh3);
+
+  if( b1 < 0 || b1 >= b.histBinsCh1 || 
+    b2 < 0 || b2 >= b.histBinsCh2 || 
+    b3 < 0 || b3 >= b.histBinsCh3 ) {
     return 0;
   } 
-  float *ptr = secondary3d + b1*ch1_scale+b2*ch2_scale+b3;
+  allocSecondary();
+  float *ptr = secondary3d + b1*b.ch1_scale+b2*b.ch2_scale+b3;
   *ptr = *ptr + 1.0f;
   return 1;
 }
@@ -193,6 +307,15 @@ void salFilter::allocMap( int binsPerDim ) {
   histBinsCh3 = binsPerDim;
   filter3d = new float[size];
   flushFilter();
+
+  // Precompute bin offsets for 8-bit input
+  for( int v = 0; v < LUT_ENTRIES; v++ ) {
+    int b = (int)((v / 255.0f) * binsPerDim);
+    bool valid = ( b >= 0 && b < binsPerDim );
+    lutCh1[v] = ( valid ? b*ch1_scale : LUT_INVALID );
+    lutCh2[v] = ( valid ? b*ch2_scale : LUT_INVALID );
+    lutCh3[v] = ( valid ? b : LUT_INVALID );
+  }
 }
 
 
@@ -255,6 +378,8 @@ salFilter::~salFilter() {
 
 IplImage *salFilter::classify3dImage( IplImage *img ) {
   assert( img->nChannels == 3 );
+  if( img->depth == IPL_DEPTH_8U )
+    return classify3dImage8u( img );
   assert( img->depth == IPL_DEPTH_32F );
   IplImage *output = cvCreateImage( cvGetSize( img ), IPL_DEPTH_32F, 1 );
   int istep = img->widthStep;
@@ -285,8 +410,48 @@ IplImage *salFilter::classify3dImage( IplImage *img ) {
   return output;
 }
 
+IplImage *salFilter::classify3dImage8u( IplImage *img ) {
+  assert( img->nChannels == 3 );
+  assert( img->depth == IPL_DEPTH_8U );
+  IplImage *output = cvCreateImage( cvGetSize( img ), IPL_DEPTH_32F, 1 );
+  int height = output->height;
+  int width = output->width;
+  for( int r=0; r<height; r++ ) {
+    unsigned char *ivalue = (unsigned char*)(img->imageData + r*img->widthStep);
+    float *ovalue = (float*)(output->imageData + r*output->widthStep);
+    for( int c=0; c<width; c++, ivalue += 3 ) {
+      int o1 = lutCh1[ivalue[0]];
+      int o2 = lutCh2[ivalue[1]];
+      int o3 = lutCh3[ivalue[2]];
+      ovalue[c] = ( (o1 | o2 | o3) < 0 ? 0.0f : filter3d[o1+o2+o3] );
+    }
+  }
+  return output;
+}
+
+void salFilter::buildMap8u( IplImage *img ) {
+  for( int r=0; r<img->height; r++ ) {
+    unsigned char *img_ptr = (unsigned char*)(img->imageData + r*img->widthStep);
+    unsigned char *img_end = img_ptr + img->width * 3;
+    for( ; img_ptr < img_end; img_ptr += 3 ) {
+      int o1 = lutCh1[img_ptr[0]];
+      int o2 = lutCh2[img_ptr[1]];
+      int o3 = lutCh3[img_ptr[2]];
+      if( (o1 | o2 | o3) >= 0 ) {
+        filter3d[o1+o2+o3] -= 1.0f;
+      }
+    }
+  }
+  isValid = true;
+}
+
 void salFilter::buildMap( IplImage *img ) {
 
+  if( img->depth == IPL_DEPTH_8U ) {
+    buildMap8u( img );
+    return;
+  }
+
   int pixels_to_skip = 1;
 
   float *img_ptr = (float*) img->imageData;
@@ -314,6 +479,104 @@ void salFilter::buildMap( IplImage *img ) {
 }
 
 
+//-------------------------------SHARED------------------------------------
+
+hfGeneration::hfGeneration() {
+  id = 0;
+  for( int i = 0; i < HF_ADAPTIVE_FILTERS; i++ ) {
+    filters[i] = NULL;
+  }
+}
+
+hfGeneration::~hfGeneration() {
+  for( int i = 0; i < HF_ADAPTIVE_FILTERS; i++ ) {
+    if( filters[i] != NULL ) {
+      delete[] filters[i];
+    }
+  }
+}
+
+hfSharedModel::hfSharedModel() {
+  current = new hfGeneration;
+  for( int i = 0; i < MAX_THREADS; i++ ) {
+    hazards[i] = NULL;
+  }
+}
+
+hfSharedModel::~hfSharedModel() {
+  delete current;
+  for( unsigned i = 0; i < retired.size(); i++ ) {
+    delete retired[i];
+  }
+}
+
+const hfGeneration* hfSharedModel::acquire( int threadID ) {
+  assert( threadID >= 0 && threadID < MAX_THREADS );
+
+  // Publish our hazard pointer, then make sure the generation wasn't
+  // replaced (and possibly reclaimed) before other threads could see it
+  hfGeneration *gen;
+  do {
+    gen = (hfGeneration*) atomicLoadPointer( (void* volatile*) &current );
+    atomicStorePointer( (void* volatile*) &hazards[threadID], gen );
+  } while( gen != atomicLoadPointer( (void* volatile*) &current ) );
+
+  return gen;
+}
+
+void hfSharedModel::release( int threadID ) {
+  assert( threadID >= 0 && threadID < MAX_THREADS );
+  atomicStorePointer( (void* volatile*) &hazards[threadID], NULL );
+}
+
+bool hfSharedModel::tryPublish( hfFilter* filters[HF_ADAPTIVE_FILTERS],
+  const float ratios[HF_ADAPTIVE_FILTERS],
+  const float secondaryDowns[HF_ADAPTIVE_FILTERS] ) {
+
+  if( !mergeLock.trylock() ) {
+    return false;
+  }
+
+  // Only mergers modify current, so it can't change while we hold the lock
+  const hfGeneration *prior = current;
+  hfGeneration *next = new hfGeneration;
+  next->id = prior->id + 1;
+
+  for( int i = 0; i < HF_ADAPTIVE_FILTERS; i++ ) {
+    const float *src = ( prior->filters[i] ? prior->filters[i] : filters[i]->bankPrimary() );
+    if( ratios[i] > 0.0f ) {
+      next->filters[i] = new float[ filters[i]->filterSize() ];
+      filters[i]->mergeSecondary( ratios[i], secondaryDowns[i], src, next->filters[i] );
+    } else if( prior->filters[i] != NULL ) {
+      next->filters[i] = new float[ filters[i]->filterSize() ];
+      memcpy( next->filters[i], src, filters[i]->filterSize() * sizeof(float) );
+    }
+  }
+
+  // Swap in new generation, the old one is freed once it's no longer pinned
+  retired.push_back( (hfGeneration*) atomicExchangePointer( (void* volatile*) &current, next ) );
+  reclaim();
+
+  mergeLock.unlock();
+  return true;
+}
+
+void hfSharedModel::reclaim() {
+  vector<hfGeneration*> stillPinned;
+  for( unsigned i = 0; i < retired.size(); i++ ) {
+    bool pinned = false;
+    for( int t = 0; t < MAX_THREADS && !pinned; t++ ) {
+      pinned = ( atomicLoadPointer( (void* volatile*) &hazards[t] ) == retired[i] );
+    }
+    if( pinned ) {
+      stillPinned.push_back( retired[i] );
+    } else {
+      delete retired[i];
+    }
+  }
+  retired.swap( stillPinned );
+}
+
 //-------------------------------SECOND------------------------------------
 
 // Class to construct our filter and perform classifications with it
@@ -358,25 +621,47 @@ hfResults *ColorClassifier::classifiyImage( IplImage *img ) {
   return ptr;
 }
 
+void ColorClassifier::setSharedModel( hfSharedModel *model, int id ) {
+  sharedModel = model;
+  threadID = id;
+}
+
+void ColorClassifier::resetPending() {
+  mergePending = false;
+  pendingFrames = 0;
+  for( int i = 0; i < HF_ADAPTIVE_FILTERS; i++ ) {
+    pendingCounts[i] = 0;
+    pendingDetections[i] = 0;
+  }
+}
+
 void ColorClassifier::Update( IplImage *img, IplImage *mask, int Detections[] ) {
 
-  // Reset all secondary filters to 0  
-  Environment.flushSecondary();
+  assert( img->depth == IPL_DEPTH_32F );
+
+  // Detections which contribute to each adaptive filter
+  int frameDetections[HF_ADAPTIVE_FILTERS];
+  frameDetections[HF_WHITE_SCALLOP] = Detections[SCALLOP_WHITE];
+  frameDetections[HF_BROWN_SCALLOP] = Detections[SCALLOP_BROWN] + Detections[SCALLOP_BURIED];
+  frameDetections[HF_ENVIRONMENT] = 0;
 
-  if( Detections[SCALLOP_WHITE] > 0 )
+  // Reset all secondary filters to 0, unless holding unmerged deltas
+  if( pendingCounts[HF_ENVIRONMENT] == 0 )
+    Environment.flushSecondary();
+
+  if( frameDetections[HF_WHITE_SCALLOP] > 0 && pendingCounts[HF_WHITE_SCALLOP] == 0 )
     WhiteScallop.flushSecondary();
 
   //if( Detections[DOLLAR] > 0 )
   //  SandDollars.flushSecondary();
 
-  if( Detections[SCALLOP_BROWN] || Detections[SCALLOP_BURIED] > 0 )
+  if( frameDetections[HF_BROWN_SCALLOP] > 0 && pendingCounts[HF_BROWN_SCALLOP] == 0 )
     BrownScallop.flushSecondary();
 
   // Build secondary filters - TODO REWRITE OH GOD MY EYES
   int brown_scallop_count = 0;
   int envi_count = 0;
   int white_scallop_count = 0;
-  int sand_dollar_count = 0;
   unsigned char *mask_ptr = (unsigned char*) mask->imageData;
   unsigned char *ctag = mask_ptr;
   float *img_ptr = (float*) img->imageData;
@@ -420,20 +705,58 @@ void ColorClassifier::Update( IplImage *img, IplImage *mask, int Detections[] )
     }
   }
 
-  // Merge secondary filters into primary if change
-  Environment.mergeSecondary( DEFAULT_MERGE_RATIO, 1.0f/envi_count );
+  // Add to any deltas not merged previously
+  pendingCounts[HF_WHITE_SCALLOP] += white_scallop_count;
+  pendingCounts[HF_BROWN_SCALLOP] += brown_scallop_count;
+  pendingCounts[HF_ENVIRONMENT] += envi_count;
+  pendingFrames++;
+
+  for( int i = 0; i < HF_ADAPTIVE_FILTERS; i++ ) {
+    pendingDetections[i] += frameDetections[i];
+  }
+
+  // Compute merge ratios, each secondary is normalized by its own count
+  float ratios[HF_ADAPTIVE_FILTERS];
+  float downs[HF_ADAPTIVE_FILTERS];
+
+  // The environment moves by the per frame rate once for every frame being
+  // merged, so its rate is the same however frames are spread over threads
+  ratios[HF_ENVIRONMENT] = 1.0f - pow( 1.0f - DEFAULT_MERGE_RATIO, (float)pendingFrames );
+  ratios[HF_WHITE_SCALLOP] = pendingDetections[HF_WHITE_SCALLOP] * DETECTION_MERGE_RATIO;
+  ratios[HF_BROWN_SCALLOP] = pendingDetections[HF_BROWN_SCALLOP] * DETECTION_MERGE_RATIO;
+
+  //float DOLLAR_MR = Detections[DOLLAR]*DETECTION_MERGE_RATIO;
 
-  float WHITE_MR = Detections[SCALLOP_WHITE]*0.004f;
-  if( Detections[SCALLOP_WHITE] )
-    WhiteScallop.mergeSecondary( WHITE_MR, 1.0f/envi_count );
+  for( int i = 0; i < HF_ADAPTIVE_FILTERS; i++ ) {
+    if( pendingCounts[i] == 0 ) {
+      ratios[i] = 0.0f;
+    }
+    ratios[i] = min( ratios[i], 1.0f );
+    downs[i] = ( pendingCounts[i] > 0 ? 1.0f / pendingCounts[i] : 0.0f );
+  }
 
-  //float DOLLAR_MR = Detections[DOLLAR]*0.004f;
-  //if( Detections[DOLLAR] )
-  //  SandDollars.mergeSecondary( DOLLAR_MR, 1.0f/envi_count );
+  // Merge secondary filters into primary if change
+  if( sharedModel ) {
+    hfFilter* filters[HF_ADAPTIVE_FILTERS];
+    filters[HF_WHITE_SCALLOP] = &WhiteScallop;
+    filters[HF_BROWN_SCALLOP] = &BrownScallop;
+    filters[HF_ENVIRONMENT] = &Environment;
+
+    // Keep accumulating if another thread is busy merging
+    mergePending = !sharedModel->tryPublish( filters, ratios, downs );
+  } else {
+    if( ratios[HF_ENVIRONMENT] > 0.0f )
+      Environment.mergeSecondary( ratios[HF_ENVIRONMENT], downs[HF_ENVIRONMENT] );
+    if( ratios[HF_WHITE_SCALLOP] > 0.0f )
+      WhiteScallop.mergeSecondary( ratios[HF_WHITE_SCALLOP], downs[HF_WHITE_SCALLOP] );
+    if( ratios[HF_BROWN_SCALLOP] > 0.0f )
+      BrownScallop.mergeSecondary( ratios[HF_BROWN_SCALLOP], downs[HF_BROWN_SCALLOP] );
+    mergePending = false;
+  }
 
-  float BROWN_MR = (Detections[SCALLOP_BROWN]+Detections[SCALLOP_BURIED])*0.004f;
-  if( Detections[SCALLOP_BROWN] )
-    BrownScallop.mergeSecondary( BROWN_MR, 1.0f/envi_count );
+  if( !mergePending ) {
+    resetPending();
+  }
 }
 
 // Deallocate filter results
@@ -451,22 +774,12 @@ void hfDeallocResults( hfResults* res ) {
 }
 
 void quickPercentiles( IplImage* img, float p1, float p2, float &op1, float& op2 ) {
-  float *ptr = (float*) img->imageData;
-  int sze = img->width * img->height;
-  float *endptr = ptr + sze;
-  int skippage = 20;
-  if( sze / 1300 > 20 )
-    skippage = sze / 1300;
-  vector<float> val_list(sze/skippage+1,0.0f);
-  int counter = 0;
-  while( ptr < endptr ) {
-    val_list[counter] = *ptr;
-    counter++;
-    ptr = ptr + skippage;
-  }
-  sort( val_list.begin(), val_list.end() );
-  op1 = val_list[p1*sze/skippage];
-  op2 = val_list[p2*sze/skippage];
+  const float q[2] = { p1, p2 };
+  float output[2];
+  int stride = fsSampleStride( img->width * img->height, 1300, 20 );
+  fsQuantiles( img, stride, q, 2, output );
+  op1 = output[0];
+  op2 = output[1];
 }
 
 hfResults *ColorClassifier::performColorClassification( IplImage* img, float minRad, float maxRad ) {
@@ -474,6 +787,14 @@ hfResults *ColorClassifier::performColorClassification( IplImage* img, float min
   // Declare pointer to output
   hfResults *results;
 
+  // Pin the latest shared filter generation, if adapting across threads
+  if( sharedModel ) {
+    const hfGeneration *gen = sharedModel->acquire( threadID );
+    WhiteScallop.setPrimary( gen->filters[HF_WHITE_SCALLOP] );
+    BrownScallop.setPrimary( gen->filters[HF_BROWN_SCALLOP] );
+    Environment.setPrimary( gen->filters[HF_ENVIRONMENT] );
+  }
+
   // Perform Class-by-Class Classification
   float resizeFactor = MPFMR_COLOR_CLASS / minRad;
   if( resizeFactor < RESIZE_FACTOR_REQUIRED ) {
@@ -492,6 +813,14 @@ hfResults *ColorClassifier::performColorClassification( IplImage* img, float min
     results->scale = 1.0f;
   }
 
+  // Unpin generation, filters fall back on the banks until the next frame
+  if( sharedModel ) {
+    WhiteScallop.setPrimary( NULL );
+    BrownScallop.setPrimary( NULL );
+    Environment.setPrimary( NULL );
+    sharedModel->release( threadID );
+  }
+
   // Create environment map
   float p1, p2;
   quickPercentiles( results->EnvironmentalClass, 0.04, 0.40, p1, p2 ); 
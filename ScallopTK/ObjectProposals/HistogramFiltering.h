@@ -8,6 +8,7 @@
 //Standard C/C++
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <iostream>
 #include <string>
 #include <map>
@@ -21,6 +22,8 @@
 //Scallop Includes
 #include "ScallopTK/Utilities/Definitions.h"
 #include "ScallopTK/Utilities/HelperFunctions.h"
+#include "ScallopTK/Utilities/MemoryMapping.h"
+#include "ScallopTK/Utilities/Threads.h"
 #include "ScallopTK/ObjectProposals/DoG.h"
 
 namespace ScallopTK
@@ -36,6 +39,12 @@ const int CHECKSUM = 999999;
 //Header size devoted in each filter matlab filter file
 const int HEADER_BYTES = 48;
 
+//Number of entries in each per-channel bin lookup table (8-bit input)
+const int LUT_ENTRIES = 256;
+
+//Value stored in a bin lookup table for out-of-range inputs
+const int LUT_INVALID = -1;
+
 //------------------------------------------------------------------------------
 //  Struct to contain a particular color classification result for some image
 //------------------------------------------------------------------------------
@@ -53,6 +62,72 @@ struct hfResults {
   IplImage *EnvironmentMap;
 };
 
+//------------------------------------------------------------------------------
+//                       Shared Filter Bank Class Prototype
+//------------------------------------------------------------------------------
+
+// Read-only contents of a single filter file. Each file is memory mapped once
+// and shared by reference between every hfFilter which loads it, across all
+// threads and detector instances.
+class hfFilterBank {
+public:
+  ~hfFilterBank() {}
+
+  // Returns the shared bank for the given file, mapping it on first use,
+  // or an empty pointer if the file is missing or invalid
+  static cv::Ptr<hfFilterBank> load( const string& filter_fn );
+
+  // Pointer to the histogram within the mapped file
+  const float *filter3d;
+
+  // The start of the range that this histogram covers
+  float startCh1;
+  float startCh2;
+  float startCh3;
+
+  // The end of the range that this histogram covers
+  float endCh1;
+  float endCh2;
+  float endCh3;
+
+  // The range of each channel that the histogram covers
+  float bprCh1; // Bins per range (end-start)
+  float bprCh2;
+  float bprCh3;
+
+  // The number of bins per each channel of the histogram
+  int histBinsCh1;
+  int histBinsCh2;
+  int histBinsCh3;
+
+  // Histogram steps
+  int ch1_scale;
+  int ch2_scale;
+
+  // Total # of floats in histogram
+  int size;
+
+  // Per-channel bin offsets into filter3d for every possible 8-bit value,
+  // already multiplied by the histogram step, or LUT_INVALID if out of range
+  int lutCh1[LUT_ENTRIES];
+  int lutCh2[LUT_ENTRIES];
+  int lutCh3[LUT_ENTRIES];
+
+private:
+
+  // Only created through load
+  hfFilterBank() : filter3d( NULL ) {}
+
+  // Validates the mapped file and reads its header
+  bool parse( const string& filter_fn );
+
+  // Fills the above lookup tables, must be called after bpr/start are known
+  void buildLUTs();
+
+  // Underlying file contents
+  MappedFile file;
+};
+
 //------------------------------------------------------------------------------
 //                         Single Filter Class Prototype
 //------------------------------------------------------------------------------
@@ -61,13 +136,14 @@ struct hfResults {
 class hfFilter {
 public:
   // Declares a new filter
-  hfFilter() { filterLoaded = false; filter3d = NULL; secondary3d = NULL; };
+  hfFilter() { filterLoaded = false; filter3d = NULL; private3d = NULL; secondary3d = NULL; };
   ~hfFilter();
 
   // Loads a filter from a file in the default filter directory
   // A secondary buffer should be used if you want to modify the filter, by
   // first inserting values into the secondary buffer, and then merging that
-  // buffer into the primary
+  // buffer into the primary. The primary is shared with all other filters
+  // loaded from the same file until the first merge, when it gets copied.
   bool loadFromFile( const string& filter_fn, bool allocSecondary = false );
 
   // Returns true if a valid filter is loaded
@@ -76,7 +152,8 @@ public:
   // Classifies a single value
   float classifyPoint3d( float* pt );
 
-  // Classifies an entire 3-chan image
+  // Classifies an entire 3-chan image, either 32f in the range [0,1]
+  // or 8u in the range [0,255] (the latter uses the bin lookup tables)
   IplImage *classify3dImage( IplImage *img );
 
   // Sets the secondary buffer to 0
@@ -88,48 +165,48 @@ public:
   // Merges secondary into filter
   void mergeSecondary( float ratio, float secondaryDown );
 
+  // Merges secondary with the filter src, writing the result into dst
+  // (which must hold filterSize() floats), without modifying this filter
+  void mergeSecondary( float ratio, float secondaryDown,
+    const float *src, float *dst ) const;
+
+  // Sets which primary buffer classification reads, NULL for the shared bank
+  void setPrimary( const float *primary );
+
+  // Returns the unmodified primary buffer from the shared bank
+  const float *bankPrimary() const { return bank->filter3d; }
+
+  // Total # of floats in histogram
+  int filterSize() const { return bank->size; }
+
 private:
 
-  // Buffer to hold color filter
-  float *filter3d;
+  // Shared read-only filter contents
+  cv::Ptr<hfFilterBank> bank;
+
+  // Buffer to hold color filter, either the shared bank or private3d
+  const float *filter3d;
+
+  // Private copy of the filter, only allocated once it has been modified
+  float *private3d;
 
   // Buffer to hold secondary filter
   //  The secondary filter is a double buffer, it exists if we 
   //  want to merge the secondary into the primary filter [TODO Better descr]
+  //  It is per filter instance, and only allocated on first use
   float *secondary3d;
 
   // Was the filter successfully loaded?
   bool filterLoaded;
 
-  // The start of the range that this histogram covers
-  float startCh1;
-  float startCh2;
-  float startCh3;
-
-  // The end of the range that this histogram covers
-  float endCh1;
-  float endCh2;
-  float endCh3;
+  // Is use of the secondary buffer allowed
+  bool secondaryAllowed;
 
-  // The range of each channel that the histogram covers
-  float bprCh1; // Bins per range (end-start)
-  float bprCh2;
-  float bprCh3;
+  // Allocates secondary3d if not already allocated
+  void allocSecondary();
 
-  // The number of bins per each channel of the histogram
-  int histBinsCh1;
-  int histBinsCh2;
-  int histBinsCh3;
-
-  // The number of channels (deprecated, always should be 3)
-  int numChan;
-
-  // Histogram steps
-  int ch1_scale;
-  int ch2_scale;
-
-  // Total # of floats in histogram
-  int size;
+  // Classifies an 8-bit 3-chan image using the lookup tables
+  IplImage *classify3dImage8u( IplImage *img );
 };
 
 //------------------------------------------------------------------------------
@@ -137,7 +214,7 @@ private:
 //------------------------------------------------------------------------------
 
 // Class to construct our filter and perform classifications with it
-// Only RGB support [0,1] range, very similar to the above
+// Only RGB support, 32f [0,1] or 8u [0,255] range, very similar to the above
 class salFilter {
 public:
   // Declares a new filter
@@ -176,6 +253,86 @@ private:
 
   // Total # of floats in histogram
   int size;
+
+  // Per-channel bin offsets for every possible 8-bit value (see hfFilter)
+  int lutCh1[LUT_ENTRIES];
+  int lutCh2[LUT_ENTRIES];
+  int lutCh3[LUT_ENTRIES];
+
+  // 8-bit specializations of the above, using the lookup tables
+  IplImage *classify3dImage8u( IplImage *img );
+  void buildMap8u( IplImage *img );
+};
+
+//------------------------------------------------------------------------------
+//                     Shared Adaptive Model Class Prototype
+//------------------------------------------------------------------------------
+
+// Index of each online adapted filter within a generation
+const int HF_WHITE_SCALLOP = 0;
+const int HF_BROWN_SCALLOP = 1;
+const int HF_ENVIRONMENT = 2;
+const int HF_ADAPTIVE_FILTERS = 3;
+
+// A single published set of adapted filters, never modified once published
+struct hfGeneration {
+  hfGeneration();
+  ~hfGeneration();
+
+  // Sequential id of this generation, 0 being the unmodified banks
+  unsigned id;
+
+  // Filter buffers, NULL if the filter is still the unmodified bank
+  float *filters[HF_ADAPTIVE_FILTERS];
+};
+
+// Color model adapted online and shared by all threads of one detector
+//
+// Threads classify using the last published generation, which they pin with
+// a per-thread hazard pointer, so reading it never takes a lock. Each thread
+// accumulates histogram deltas in its own ColorClassifier, which are merged
+// into a new generation and published via an atomic pointer swap. Old
+// generations are reclaimed once no thread has them pinned.
+class hfSharedModel {
+public:
+
+  hfSharedModel();
+  ~hfSharedModel();
+
+  // Pins and returns the current generation for the given thread
+  const hfGeneration* acquire( int threadID );
+
+  // Unpins whatever generation the given thread holds
+  void release( int threadID );
+
+  // Builds a new generation by merging the secondary buffer of each filter
+  // with a non-zero ratio into the current generation, then publishes it.
+  // If another thread is currently merging, returns false without merging,
+  // so the caller can keep its deltas for a later attempt.
+  bool tryPublish( hfFilter* filters[HF_ADAPTIVE_FILTERS],
+    const float ratios[HF_ADAPTIVE_FILTERS],
+    const float secondaryDowns[HF_ADAPTIVE_FILTERS] );
+
+private:
+
+  // Currently published generation
+  hfGeneration* volatile current;
+
+  // Generation pinned by each thread, if any
+  hfGeneration* volatile hazards[MAX_THREADS];
+
+  // Replaced generations which may still be pinned
+  vector<hfGeneration*> retired;
+
+  // Serializes mergers only, never taken by readers
+  cv::Mutex mergeLock;
+
+  // Deletes all retired generations not pinned by any thread
+  void reclaim();
+
+  // Not copyable
+  hfSharedModel( const hfSharedModel& );
+  hfSharedModel& operator=( const hfSharedModel& );
 };
 
 //------------------------------------------------------------------------------
@@ -188,7 +345,7 @@ class ColorClassifier {
 public:
 
   // Class Constructor
-  ColorClassifier() { filtersLoaded=false; }
+  ColorClassifier() { filtersLoaded=false; sharedModel=NULL; threadID=0; resetPending(); }
 
   // Class Destructr
   ~ColorClassifier() {}
@@ -200,16 +357,37 @@ public:
   bool isValid() { return filtersLoaded; }
 
   // Performs all required histogram-based filtering of image
+  //  Input can be either a 32f [0,1] or 8u [0,255] 3-chan image
   hfResults *classifiyImage( IplImage *img );
 
   // Calls classifyImage after resizing/smoothing image
+  //  Passing the 8u image is prefered, it avoids all float bin arithmetic
   hfResults *performColorClassification( IplImage* img, float minRad, float maxRad );
 
   // Updates all of the filters after interest points have been classified
+  //  If a shared model is set, deltas are published to it as a new
+  //  generation, otherwise this classifier's own filters are modified
   void Update( IplImage *img, IplImage *mask, int Detections[] );
-  
+
+  // Use a color model shared between threads, given this thread's id
+  void setSharedModel( hfSharedModel *model, int id );
+
 private:
 
+  // Optional shared adaptive model and our thread id within it
+  hfSharedModel *sharedModel;
+  int threadID;
+
+  // Deltas accumulated in secondary filters but not yet merged, these are
+  // carried across frames if another thread was merging during Update
+  bool mergePending;
+  int pendingFrames;
+  int pendingCounts[HF_ADAPTIVE_FILTERS];
+  int pendingDetections[HF_ADAPTIVE_FILTERS];
+
+  // Clears the above
+  void resetPending();
+
   // Last classifier results for last image (managed externally)
   IplImage *img;
   hfResults *res;
@@ -25,6 +25,8 @@ const int END3 = START3 + INTERVALS_SCALE3;
 const int TOTAL_SCALES = END3 + 1;
 const float BASE_SIGMA = 1.2f;
 const int MAX_T4_IP = INT_MAX;
+const int T4_BINS = 20;
+const int T4_TILE_WIDTH = 256;
 
 // Structs
 struct t4cand {
@@ -51,9 +53,8 @@ struct SSInfo {
 //                            Function Prototypes
 //------------------------------------------------------------------------------
 
-IplImage *gaussDerivVerticle( IplImage *input, double sigma );
-IplImage *gaussDerivHorizontal( IplImage *input, double sigma );
 IplImage *createT4Scale( IplImage *dx, IplImage *dy, float radius, float offset );
+IplImage *createT4ScaleB( IplImage *dx, IplImage *dy, float radius, int offset );
 IplImage *createT4ScaleC( IplImage *dx, IplImage *dy, float radius, int offset );
 void detectT4Extremum( IplImage** ss, Candidates& cds, SSInfo& ssinfo );
 void interpolateIP( IplImage **ss, Candidates& cds, CandidatePtrVector& kps, float resize_factor,
@@ -80,23 +81,50 @@ void showChain( IplImage **ss ) {
   }
 }
 
-float quickMedianTemp( IplImage* img ) {
-  float *ptr = (float*) img->imageData;
-  int sze = img->width * img->height;
-  float *endptr = ptr + sze;
-  int skippage = 20;
-  if( sze / 1000 > 20 )
-    skippage = sze / 1000;
-  vector<float> val_list(sze/skippage+1,0.0f);
-  int counter = 0;
-  while( ptr < endptr ) {
-    val_list[counter] = *ptr;
-    counter++;
-    ptr = ptr + skippage;
+// Builds a range of scale space levels, each level is independent
+class T4LevelBuilder : public cv::ParallelLoopBody {
+public:
+  T4LevelBuilder( IplImage *dx, IplImage *dy, IplImage **ss,
+    const float *radii, const int *offsets )
+    : dx( dx ), dy( dy ), ss( ss ), radii( radii ), offsets( offsets ) {}
+
+  void operator()( const cv::Range& range ) const {
+    for( int i=range.start; i<range.end; i++ ) {
+      ss[i] = createT4ScaleB( dx, dy, radii[i], offsets[i] );
+    }
+  }
+
+private:
+  IplImage *dx;
+  IplImage *dy;
+  IplImage **ss;
+  const float *radii;
+  const int *offsets;
+};
+
+#ifdef TEMPLATE_BENCHMARKING
+// Times the gather (C) and shifted buffer (B) kernels at every radius
+// used by the scale space, writing: radius C_ms B_ms max_abs_diff
+void benchmarkT4Kernels( IplImage *dx, IplImage *dy, float minRad, float maxRad ) {
+  const float ratio = 1.2;
+  float first = minRad * ratio;
+  int levels = INTERVALS_SCALE1 + INTERVALS_SCALE2 + INTERVALS_SCALE3;
+  float step = ( maxRad - first ) / levels;
+  for( int i=0; i<=levels; i++ ) {
+    float rad = first + i * step;
+    getTimeSinceLastCall();
+    IplImage *refScale = createT4ScaleC( dx, dy, rad, maxRad );
+    double refTime = getTimeSinceLastCall();
+    IplImage *newScale = createT4ScaleB( dx, dy, rad, maxRad );
+    double newTime = getTimeSinceLastCall();
+    double maxDiff = cvNorm( refScale, newScale, CV_C );
+    tp_bm_output << rad << " " << refTime << " " << newTime << " " << maxDiff << endl;
+    cvReleaseImage( &refScale );
+    cvReleaseImage( &newScale );
   }
-  sort( val_list.begin(), val_list.end() );
-  return val_list[0.5f*sze/skippage];
+  getTimeSinceLastCall();
 }
+#endif
 
 // Create tapprox hough ss
 IplImage **createScaleSpace( IplImage* dx, IplImage *dy, float minRad, float maxRad, SSInfo& ssinfo, IplImage *mask ) {
@@ -138,21 +166,28 @@ IplImage **createScaleSpace( IplImage* dx, IplImage *dy, float minRad, float max
   offset.x = maxRad;
   offset.y = maxRad;
   CvScalar scala;
-  scala.val[0] = quickMedianTemp( dx );
+  scala.val[0] = quickMedian( dx, 1000 );
   cvCopyMakeBorder( dx, dxBase, offset, IPL_BORDER_CONSTANT, scala );
   cvCopyMakeBorder( dy, dyBase, offset, IPL_BORDER_CONSTANT, scala );
   cvSmooth( dxBase, dxBase, 2, 3, 3 );
   cvSmooth( dyBase, dyBase, 2, 3, 3 );
 
+  // Per-level kernel radii and offsets, levels within an octave run in parallel
+  float radii[TOTAL_SCALES];
+  int offsets[TOTAL_SCALES];
+
   // Create SS#1
   float currad = s1 - intvl1;
   for( int i=START1-1; i<END1+1; i++ ) {
     ssinfo.RELATIVE_SCALE[i] = 1.0f;
     ssinfo.SCALE_OFFSET[i] = maxRad;
     ssinfo.SCALE_RADII[i] = currad;
-    ss[i] = createT4ScaleC( dxBase, dyBase, currad, maxRad );
+    radii[i] = currad;
+    offsets[i] = maxRad;
     currad = currad + intvl1;
   }
+  cv::parallel_for_( cv::Range( START1-1, END1+1 ),
+    T4LevelBuilder( dxBase, dyBase, ss, radii, offsets ) );
 
   // Resize base to remaining 2 scales
   float resize_factor2 = 0.5f;
@@ -181,9 +216,12 @@ IplImage **createScaleSpace( IplImage* dx, IplImage *dy, float minRad, float max
     ssinfo.TOP_OFFSET[i] = maxRad;
     ssinfo.SCALE_OFFSET[i] = maxRad * resize_factor2;
     ssinfo.SCALE_RADII[i] = currad;
-    ss[i] = createT4ScaleC( dxLvl2, dyLvl2, currad*resize_factor2, ssinfo.SCALE_OFFSET[i] );
+    radii[i] = currad*resize_factor2;
+    offsets[i] = ssinfo.SCALE_OFFSET[i];
     currad = currad + intvl2;
   }
+  cv::parallel_for_( cv::Range( START2-1, END2+1 ),
+    T4LevelBuilder( dxLvl2, dyLvl2, ss, radii, offsets ) );
 
   // Resize base to remaining 2 scales
   float resize_factor3 = 0.5f;
@@ -212,9 +250,12 @@ IplImage **createScaleSpace( IplImage* dx, IplImage *dy, float minRad, float max
     ssinfo.RELATIVE_SCALE[i] = resize_factor2 * resize_factor3;
     ssinfo.TOP_OFFSET[i] = maxRad;
     ssinfo.SCALE_OFFSET[i] = maxRad / 4.0f;
-    ss[i] = createT4ScaleC( dxLvl3, dyLvl3, currad*resize_factor2*resize_factor3, maxRad / 4.0f );
+    radii[i] = currad*resize_factor2*resize_factor3;
+    offsets[i] = maxRad / 4.0f;
     currad = currad + intvl3;
   }
+  cv::parallel_for_( cv::Range( START3-1, END3+1 ),
+    T4LevelBuilder( dxLvl3, dyLvl3, ss, radii, offsets ) );
 
   // Deallocations
   cvReleaseImage( &dxBase );
@@ -281,15 +322,83 @@ IplImage *createT4Scale( IplImage *dx, IplImage *dy, float radius, float offset
   return scale;
 }
 
+// Sums the same segment of every shifted source row into out, the sum
+// for each column is kept in registers across all taps
+inline void sumShiftedRows( const float **src, int n, float *out ) {
+  int i = 0;
+#if SCALLOP_TK_SSE2
+  for( ; i <= n-8; i+=8 ) {
+    __m128 acc0 = _mm_loadu_ps( src[0]+i );
+    __m128 acc1 = _mm_loadu_ps( src[0]+i+4 );
+    for( int j=1; j<T4_BINS; j++ ) {
+      acc0 = _mm_add_ps( acc0, _mm_loadu_ps( src[j]+i ) );
+      acc1 = _mm_add_ps( acc1, _mm_loadu_ps( src[j]+i+4 ) );
+    }
+    _mm_storeu_ps( out+i, acc0 );
+    _mm_storeu_ps( out+i+4, acc1 );
+  }
+#endif
+  for( ; i < n; i++ ) {
+    float acc = src[0][i];
+    for( int j=1; j<T4_BINS; j++ ) {
+      acc += src[j][i];
+    }
+    out[i] = acc;
+  }
+}
+
 // Option 2: use shifted temp buffers
-IplImage *createT4ScaleB( IplImage *dx, IplImage *dy, float radius ) {
+//
+// The response is a sum of 20 shifted dx/dy planes, so whole row segments
+// are summed with contiguous vector loads instead of gathering 20 scattered
+// samples per pixel. Columns are tiled so the 20 source row segments of a
+// tile stay in cache. Output is identical to createT4ScaleC.
+IplImage *createT4ScaleB( IplImage *dx, IplImage *dy, float radius, int offset ) {
+
+  int rpos[T4_BINS];
+  int cpos[T4_BINS];
+  IplImage *src[T4_BINS];
+
+  for( int i = 0; i<T4_BINS; i++ ) {
+    float angle = 2*PI*i/T4_BINS - 0.7*PI;
+    rpos[i] = radius * sin( angle );
+    cpos[i] = radius * cos( angle );
+    src[i] = ( (i/5) % 2 == 0 ? dy : dx );
+  }
 
   IplImage *scale = cvCreateImage( cvGetSize( dx ), IPL_DEPTH_32F, 1 );
-  for( int r=0; r < scale->height; r++ ) {
-    for( int c=0; c < scale->width; c++ ) {
+  const int rstart = offset+1;
+  const int rend = scale->height-offset-1;
+  const int cstart = offset+1;
+  const int cend = scale->width-offset-1;
+
+  // Only the border outside the valid region needs clearing
+  if( rstart >= rend || cstart >= cend ) {
+    cvZero(scale);
+  } else {
+    for( int r=0; r < scale->height; r++ ) {
+      float *out = (float*)(scale->imageData + scale->widthStep*r);
+      if( r < rstart || r >= rend ) {
+        memset( out, 0, scale->width * sizeof(float) );
+      } else {
+        memset( out, 0, cstart * sizeof(float) );
+        memset( out + cend, 0, ( scale->width - cend ) * sizeof(float) );
+      }
+    }
+  }
 
+  const float *rows[T4_BINS];
+  for( int c0=cstart; c0 < cend; c0 += T4_TILE_WIDTH ) {
+    const int len = min( T4_TILE_WIDTH, cend-c0 );
+    for( int r=rstart; r < rend; r++ ) {
+      for( int j=0; j<T4_BINS; j++ ) {
+        rows[j] = ((float*)(src[j]->imageData + src[j]->widthStep*(r+rpos[j]))) + c0 + cpos[j];
+      }
+      float *out = ((float*)(scale->imageData + scale->widthStep*r)) + c0;
+      sumShiftedRows( rows, len, out );
     }
   }
+  cvSmooth(scale, scale, 2, 9, 9 );
   return scale;
 }
 
@@ -654,6 +763,7 @@ void findTemplateCandidates( GradientChain& grad, CandidatePtrVector& kps,
   tp_exe_times.clear();
   initializeTimer();
   startTimer();
+  benchmarkT4Kernels( dx, dy, minRad, maxRad );
 #endif
   
   // Create Scale Space
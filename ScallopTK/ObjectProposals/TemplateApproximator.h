@@ -14,6 +14,7 @@
 //Standard C/C++
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -28,6 +29,7 @@
 //Scallop Includes
 #include "ScallopTK/Utilities/Definitions.h"
 #include "ScallopTK/Utilities/HelperFunctions.h"
+#include "ScallopTK/Utilities/SIMD.h"
 #include "ScallopTK/ScaleDetection/ImageProperties.h"
 #include "ScallopTK/EdgeDetection/GaussianEdges.h"
 
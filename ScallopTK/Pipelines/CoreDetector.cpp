@@ -10,6 +10,7 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <deque>
 #include <fstream>
 #include <stdio.h>
 #include <stdlib.h>
@@ -28,6 +29,7 @@
 #include "ScallopTK/Utilities/Filesystem.h"
 
 #include "ScallopTK/ScaleDetection/ImageProperties.h"
+#include "ScallopTK/ScaleDetection/FootprintIndex.h"
 #include "ScallopTK/ScaleDetection/StereoComputation.h"
 
 #include "ScallopTK/EdgeDetection/WatershedEdges.h"
@@ -35,6 +37,7 @@
 #include "ScallopTK/EdgeDetection/ExpensiveSearch.h"
 
 #include "ScallopTK/ObjectProposals/HistogramFiltering.h"
+#include "ScallopTK/ObjectProposals/FrameGate.h"
 #include "ScallopTK/ObjectProposals/PriorStatistics.h"
 #include "ScallopTK/ObjectProposals/AdaptiveThresholding.h"
 #include "ScallopTK/ObjectProposals/TemplateApproximator.h"
@@ -49,12 +52,50 @@
 #include "ScallopTK/Classifiers/TrainingUtils.h"
 #include "ScallopTK/Classifiers/Classifier.h"
 
+#include "ScallopTK/Pipelines/TileSource.h"
+
+#include "ScallopTK/Utilities/PixelFormats.h"
+
+#ifdef USE_TIFF
+#include "ScallopTK/Pipelines/TiffTileSource.h"
+#endif
+
 namespace ScallopTK
 {
 
 // Number of worker threads
 int THREADS;
 
+// Candidates per feature extraction batch when on a frame time budget, the
+// deadline is checked between batches
+const unsigned BUDGET_CHUNK_SIZE = 32;
+
+// Mosaic tiles are read with this many max search radii of context around
+// their core, enough for an object centered in the core and its features
+const float TILE_MARGIN_RADII = 3.0f;
+
+// Tile cores are at least this many margins wide, bounding margin overhead
+const int TILE_MIN_CORE_MARGINS = 4;
+
+// Pixels per min search radius at which images are screened for blobs
+const float SCREENING_PIXELS_FOR_MIN_RAD = 3.0f;
+
+// Width of the grey thumbnails used to estimate motion between frames
+const int TEMPORAL_THUMBNAIL_WIDTH = 256;
+
+// Min correlation of the overlapping thumbnail parts of two aligned frames
+const double TEMPORAL_MIN_ALIGNMENT = 0.5;
+
+// Min correlation of a carried over detection with its new location
+const double TEMPORAL_MIN_AGREEMENT = 0.6;
+
+// Frames processed incrementally in a row before a full frame refresh
+const int TEMPORAL_REFRESH_INTERVAL = 8;
+
+// Min ratio of the largest to smallest pixel size in an image for it to be
+// processed in scale bands
+const float SCALE_BAND_MIN_RANGE = 1.25f;
+
 // Variables for benchmarking tests
 #ifdef ENABLE_BENCHMARKING
   const string BenchmarkingFilename = "BenchmarkingResults.dat";
@@ -71,6 +112,10 @@ struct AlgorithmArgs {
   // Input image
   cv::Mat InputImage;
 
+  // Pixel format of the input image (PIXEL_FORMAT_*), converted to BGR when
+  // the image is formatted for processing
+  int InputFormat;
+
   // Input filename for input image, full path, if available
   string InputFilename;
 
@@ -89,6 +134,25 @@ struct AlgorithmArgs {
   // Will only process the left half of the input image if set
   bool ProcessLeftHalfOnly;
 
+  // Right image of a stereo pair, if not the right half of the input image
+  cv::Mat StereoImage;
+
+  // Stereo baseline (meters, 0 to disable) and max disparity (pixels) used
+  // to measure per pixel scale from the stereo pair
+  float StereoBaseline;
+  int StereoMaxDisparity;
+
+  // Known per pixel sizes (meters) of the input image, used over metadata,
+  // and the pixel size of the frame it is part of for where too little of
+  // the map is known
+  cv::Mat PixelSizeMap;
+  float FramePixelSize;
+
+  // Derive per pixel sizes from the camera model, and process images in
+  // ScaleMapBands bands each searching only the radii valid within it
+  bool EnableScaleMap;
+  int ScaleMapBands;
+
   // Output options
   bool EnableOutputDisplay;
   bool EnableListOutput;
@@ -112,6 +176,30 @@ struct AlgorithmArgs {
   // Container for color filters
   ColorClassifier *CC;
 
+  // Update the color filters from this image's detections
+  bool EnableColorAdaptation;
+
+  // Use the component tree adaptive thresholding engine
+  bool UseComponentTreeThresholding;
+
+  // Per frame time (seconds) and candidate budgets, 0 for no limit
+  float FrameTimeBudget;
+  int FrameCandidateBudget;
+
+  // Per proposal detector candidate caps, 0 for no limit
+  int MaxBlobCandidates;
+  int MaxAdaptiveCandidates;
+  int MaxTemplateCandidates;
+  int MaxCannyCandidates;
+
+  // Screen the image at a coarse scale and process only the regions found
+  bool EnableScreeningPass;
+  float ScreeningMaxCoverage;
+
+  // Reject frames which cannot contain targets before processing them
+  bool EnableFrameGate;
+  FrameGateParameters GateParameters;
+
   // Container for external statistics collected so far (densities, etc)
   ThreadStatistics *Stats;
 
@@ -139,86 +227,233 @@ struct AlgorithmArgs {
   // Output final detections
   DetectionVector FinalDetections;
 
+  // Output work done and skipped on the frame
+  FrameStatistics FrameStats;
+
   AlgorithmArgs()
-  : Model( NULL ),
+  : FramePixelSize( 0.0f ),
+    FrameTimeBudget( 0.0f ),
+    FrameCandidateBudget( 0 ),
+    MaxBlobCandidates( 0 ),
+    MaxAdaptiveCandidates( 0 ),
+    MaxTemplateCandidates( 0 ),
+    MaxCannyCandidates( 0 ),
+    EnableScreeningPass( false ),
+    ScreeningMaxCoverage( 1.0f ),
+    EnableFrameGate( false ),
+    Model( NULL ),
     GTData( NULL )
   {}
 };
 
-// Our Core Detection Algorithm - performs classification for a single image
-//   inputs - shown above
-//   outputs - returns NULL
-void *processImage( void *InputArgs ) {
+// Wall clock seconds since a cv::getTickCount() reading
+static double secondsSince( int64 start ) {
+  return ( cv::getTickCount() - start ) / cv::getTickFrequency();
+}
 
-//--------------------Get Pointers to Main Inputs---------------------
+// Replaces the metadata derived scale of image with one measured from its
+// stereo pair, at the resolution the metadata scale would process it at.
+// Returns true if the scale was measured.
+static bool measureStereoScale( AlgorithmArgs *Options, const cv::Mat& image,
+  ImageProperties& inputProp )
+{
+  if( Options->StereoBaseline <= 0.0f )
+  {
+    return false;
+  }
 
-  // Read input arguments (pthread requires void* as argument type)
-  AlgorithmArgs *Options = (AlgorithmArgs*) InputArgs;
-  ColorClassifier *CC = Options->CC;
-  ThreadStatistics *Stats = Options->Stats;
+  cv::Mat rightImage = Options->StereoImage;
 
-#ifdef ENABLE_BENCHMARKING
-  executionTimes.clear();
-  startTimer();
-#endif
+  if( rightImage.empty() && Options->ProcessLeftHalfOnly )
+  {
+    const cv::Mat& input = Options->InputImage;
+    rightImage = input( cv::Rect( input.cols/2, 0, input.cols/2, input.rows ) );
+  }
 
-  // Declare input image in assorted formats for later operations
-  cv::Mat inputImgMat = Options->InputImage;
+  if( rightImage.empty() || rightImage.size() != image.size() )
+  {
+    return false;
+  }
 
-  if( inputImgMat.cols == 0 || inputImgMat.rows == 0 )
+  float scale = (float)STEREO_MATCH_WIDTH / image.cols;
+
+  if( inputProp.hasMetadata() )
   {
-    throw std::runtime_error( "Invalid input image" );
+    scale = MAX_PIXELS_FOR_MIN_RAD * inputProp.getAvgPixelSizeMeters()
+      / Options->MinSearchRadiusMeters;
   }
 
-  if( Options->ProcessLeftHalfOnly )
+  scale = min( scale, 1.0f );
+
+  cv::Mat disparity, pixelSizes;
+  computeDisparityMap( image, rightImage, scale,
+    Options->StereoMaxDisparity, disparity );
+  computePixelSizeMap( disparity, scale, Options->StereoBaseline, pixelSizes );
+
+  if( inputProp.setPixelSizeMap( pixelSizes ) )
   {
-    inputImgMat = inputImgMat(
-      cv::Rect( 0, 0, inputImgMat.cols/2, inputImgMat.rows ) );
+    return true;
   }
 
-//----------------------Calculate Object Size-------------------------
+  if( !inputProp.hasMetadata() )
+  {
+    cerr << "WARN: Unable to measure scale from stereo for image ";
+    cerr << Options->InputFilenameNoDir << endl;
+  }
+  return false;
+}
 
-  // Declare Image Properties reader (for metadata read, size calc, etc)
-  ImageProperties inputProp;
+// Reads image properties and the min and max search radii in pixels for the
+// image, printing why and returning false if it cannot be processed
+static bool computeSearchRadii( AlgorithmArgs *Options, const cv::Mat& image,
+  ImageProperties& inputProp, float& minRadPixels, float& maxRadPixels )
+{
+  if( Options->UseMetadata && !Options->PixelSizeMap.empty() )
+  {
+    // Scale already known per pixel, e.g. for a region of a larger image
+    inputProp.calculateImageProperties( image.cols, image.rows );
 
-  if( Options->UseMetadata )
+    if( !inputProp.setPixelSizeMap( Options->PixelSizeMap ) &&
+        !inputProp.setPixelSizeMap( cv::Mat( 1, 1, CV_32F,
+          cv::Scalar( Options->FramePixelSize ) ) ) )
+    {
+      cerr << "ERROR: Unknown scale for region of image ";
+      cerr << Options->InputFilenameNoDir << endl;
+      return false;
+    }
+  }
+  else if( Options->UseMetadata )
   {
     // Automatically loads metadata from input file if necessary
     if( !Options->MetadataProvided )
     {
-      inputProp.calculateImageProperties( Options->InputFilename, inputImgMat.cols,
-        inputImgMat.rows, Options->FocalLength );
+      inputProp.calculateImageProperties( Options->InputFilename, image.cols,
+        image.rows, Options->FocalLength );
     }
     else
     {
-      inputProp.calculateImageProperties( inputImgMat.cols, inputImgMat.rows,
+      inputProp.calculateImageProperties( image.cols, image.rows,
          Options->Altitude, Options->Pitch, Options->Roll, Options->FocalLength );
     }
 
+    // Measure per pixel scale from the stereo pair instead, if available,
+    // else from the camera model if enabled
+    if( !measureStereoScale( Options, image, inputProp ) &&
+        Options->EnableScaleMap && inputProp.hasMetadata() )
+    {
+      inputProp.calculatePixelSizeMap();
+    }
+
     if( !inputProp.hasMetadata() )
     {
       cerr << "ERROR: Failure to read image metadata for file ";
       cerr << Options->InputFilenameNoDir << endl;
-      threadExit();
-      return NULL;
+      return false;
     }
   }
   else
   {
-    inputProp.calculateImageProperties( inputImgMat.cols, inputImgMat.rows);
+    inputProp.calculateImageProperties( image.cols, image.rows );
   }
 
-  // Get the min and max Scallop size from combined image properties and input parameters
-  float minRadPixels = ( Options->UseMetadata ? Options->MinSearchRadiusMeters
-    : Options->MinSearchRadiusPixels ) / inputProp.getAvgPixelSizeMeters();
-  float maxRadPixels = ( Options->UseMetadata ? Options->MaxSearchRadiusMeters
-    : Options->MaxSearchRadiusPixels ) / inputProp.getAvgPixelSizeMeters();
+  // Get the min and max Scallop size from combined image properties and input
+  // parameters, covering every pixel size within the image
+  minRadPixels = ( Options->UseMetadata ? Options->MinSearchRadiusMeters
+    : Options->MinSearchRadiusPixels ) / inputProp.getMaxPixelSizeMeters();
+  maxRadPixels = ( Options->UseMetadata ? Options->MaxSearchRadiusMeters
+    : Options->MaxSearchRadiusPixels ) / inputProp.getMinPixelSizeMeters();
 
   // Threshold size scanning range
   if( maxRadPixels < 1.0 )
   {
     cerr << "WARN: Scallop scanning size range is less than 1 pixel for image ";
     cerr << Options->InputFilenameNoDir << ", skipping." << endl;
+    return false;
+  }
+
+  return true;
+}
+
+// Runs the frame pre-gate if enabled, recording and reporting why the frame
+// was rejected. Rejected frames have no detections.
+static bool frameRejected( AlgorithmArgs *Options, const cv::Mat& image )
+{
+  if( !Options->EnableFrameGate || Options->IsTrainingMode )
+  {
+    return false;
+  }
+
+  Options->FrameStats.GateResult = gateFrame( image, Options->InputFormat, Options->GateParameters );
+
+  if( Options->FrameStats.GateResult == GATE_PASSED )
+  {
+    return false;
+  }
+
+  cout << "  Frame rejected by pre-gate: "
+       << gateResultName( Options->FrameStats.GateResult ) << endl;
+
+  Options->FrameStats.ProcessedFraction = 0.0f;
+  return true;
+}
+
+// Our Core Detection Algorithm - performs classification for a single image
+//   inputs - shown above
+//   outputs - returns NULL
+void *processImage( void *InputArgs ) {
+
+//--------------------Get Pointers to Main Inputs---------------------
+
+  // Read input arguments (pthread requires void* as argument type)
+  AlgorithmArgs *Options = (AlgorithmArgs*) InputArgs;
+  ColorClassifier *CC = Options->CC;
+  ThreadStatistics *Stats = Options->Stats;
+
+  // Frame budget accounting
+  const int64 frameStart = cv::getTickCount();
+  FrameStatistics& frameStats = Options->FrameStats;
+  frameStats = FrameStatistics();
+
+  // Detections from a previous frame must not leak into an early exit
+  Options->FinalDetections.clear();
+
+#ifdef ENABLE_BENCHMARKING
+  executionTimes.clear();
+  startTimer();
+#endif
+
+  // Declare input image in assorted formats for later operations
+  cv::Mat inputImgMat = Options->InputImage;
+
+  if( inputImgMat.cols == 0 || inputImgMat.rows == 0 )
+  {
+    throw std::runtime_error( "Invalid input image" );
+  }
+
+  if( Options->ProcessLeftHalfOnly )
+  {
+    inputImgMat = inputImgMat(
+      cv::Rect( 0, 0, inputImgMat.cols/2, inputImgMat.rows ) );
+  }
+
+  // Skip frames which cannot contain targets before any real work
+  if( frameRejected( Options, inputImgMat ) )
+  {
+    frameStats.ElapsedSeconds = secondsSince( frameStart );
+    markThreadAsFinished( Options->ThreadID );
+    threadExit();
+    return NULL;
+  }
+
+//----------------------Calculate Object Size-------------------------
+
+  // Declare Image Properties reader (for metadata read, size calc, etc)
+  ImageProperties inputProp;
+  float minRadPixels, maxRadPixels;
+
+  if( !computeSearchRadii( Options, inputImgMat, inputProp, minRadPixels, maxRadPixels ) )
+  {
+    frameStats.ProcessedFraction = 0.0f;
     threadExit();
     return NULL;
   }
@@ -235,21 +470,25 @@ void *processImage( void *InputArgs ) {
   //  resize the image if this results in a downscale.
   float resizeFactor = MAX_PIXELS_FOR_MIN_RAD / minRadPixels;
 
+  //  The input is converted to BGR in the same step, so that external
+  //  buffers are only read once and never copied at full size.
   if( resizeFactor < RESIZE_FACTOR_REQUIRED ) {
-    cv::Mat resizedImgMat;
-
-    cv::resize( inputImgMat, resizedImgMat,
-      cv::Size( (int)( resizeFactor*inputImgMat.cols ),
-                (int)( resizeFactor*inputImgMat.rows ) ) );
-
-    inputImgMat = resizedImgMat;
     minRadPixels = minRadPixels * resizeFactor;
     maxRadPixels = maxRadPixels * resizeFactor;
-
   } else {
     resizeFactor = 1.0f;
   }
 
+  cv::Mat formattedImgMat;
+
+  convertPixelFormat( inputImgMat, Options->InputFormat,
+    resizeFactor == 1.0f ? inputImgMat.size() :
+      cv::Size( (int)( resizeFactor*inputImgMat.cols ),
+                (int)( resizeFactor*inputImgMat.rows ) ),
+    formattedImgMat );
+
+  inputImgMat = formattedImgMat;
+
   // The remaining code uses legacy OpenCV API (IplImage)
   IplImage inputImgIplWrapper = inputImgMat;
   IplImage *inputImg = &inputImgIplWrapper;
@@ -296,7 +535,8 @@ void *processImage( void *InputArgs ) {
   // Perform color classifications on base image
   //   Puts results in hfResults struct
   //   Contains classification results for different organisms, and sal maps
-  hfResults *color = CC->performColorClassification( imgRGB32f,
+  //   Uses the 8u image so bins come from lookup tables, not float math
+  hfResults *color = CC->performColorClassification( imgRGB8u,
     minRadPixels, maxRadPixels );
 
 #ifdef ENABLE_BENCHMARKING
@@ -330,14 +570,18 @@ void *processImage( void *InputArgs ) {
   }
 
   filterCandidates( cdsColorBlob, minRadPixels, maxRadPixels, true );
+  frameStats.CappedCandidates += capCandidates( cdsColorBlob, Options->MaxBlobCandidates );
 
 #ifdef ENABLE_BENCHMARKING
   executionTimes.push_back( getTimeSinceLastCall() );
 #endif
 
   // Perform Adaptive Filtering
-  performAdaptiveFiltering( color, cdsAdaptiveFilt, minRadPixels, false );
+  performAdaptiveFiltering( color, cdsAdaptiveFilt, minRadPixels, false,
+    Options->UseComponentTreeThresholding );
   filterCandidates( cdsAdaptiveFilt, minRadPixels, maxRadPixels, true );
+  frameStats.CappedCandidates += capCandidates( cdsAdaptiveFilt, Options->MaxAdaptiveCandidates,
+    color->NetScallops, color->scale );
 
 #ifdef ENABLE_BENCHMARKING
   executionTimes.push_back( getTimeSinceLastCall() );
@@ -346,6 +590,7 @@ void *processImage( void *InputArgs ) {
   // Template Approx Candidate Detection
   findTemplateCandidates( gradients, cdsTemplateAprx, inputProp, mask );
   filterCandidates( cdsTemplateAprx, minRadPixels, maxRadPixels, true );
+  frameStats.CappedCandidates += capCandidates( cdsTemplateAprx, Options->MaxTemplateCandidates );
 
 #ifdef ENABLE_BENCHMARKING
   executionTimes.push_back( getTimeSinceLastCall() );
@@ -354,6 +599,7 @@ void *processImage( void *InputArgs ) {
   // Stable Canny Edge Candidates
   findCannyCandidates( gradients, cdsCannyEdge );
   filterCandidates( cdsCannyEdge, minRadPixels, maxRadPixels, true );
+  frameStats.CappedCandidates += truncateCandidates( cdsCannyEdge, Options->MaxCannyCandidates );
 
 #ifdef ENABLE_BENCHMARKING
   executionTimes.push_back( getTimeSinceLastCall() );
@@ -409,6 +655,27 @@ void *processImage( void *InputArgs ) {
 
 //--------------------Extract Features---------------------------
 
+  // When classifying on a frame budget, candidates are handled in priority
+  // order so that whatever is skipped is what the detectors trusted least
+  const bool useBudget = !Options->IsTrainingMode &&
+    ( Options->FrameTimeBudget > 0.0f || Options->FrameCandidateBudget > 0 );
+
+  CandidatePtrVector cdsByPriority = cdsAllUnordered;
+  unsigned budgetCount = cdsByPriority.size();
+
+  if( useBudget )
+  {
+    orderByPriority( cdsByPriority );
+
+    if( Options->FrameCandidateBudget > 0 )
+    {
+      budgetCount = min( budgetCount, (unsigned)Options->FrameCandidateBudget );
+    }
+  }
+
+  const unsigned chunkSize = ( useBudget && Options->FrameTimeBudget > 0.0f ?
+    BUDGET_CHUNK_SIZE : max( budgetCount, 1u ) );
+
   if( Options->Model->requiresFeatures() )
   {
     // Initializes Candidate stats used for classification
@@ -417,64 +684,146 @@ void *processImage( void *InputArgs ) {
 #ifdef ENABLE_BENCHMARKING
     executionTimes.push_back( getTimeSinceLastCall() );
 #endif
+  }
+
+  // Size feature scaling
+  float sizeAdj = ( Options->UseMetadata ? 1.0 : 0.0008 );
+    // Above is a hack to make size features more comparable when we have/don't
+    // have input metadata used to compute size info
+
+  const bool useCascade = Options->Model->hasCascade() && !Options->IsTrainingMode;
+
+  // Whole image feature generators, built on first use
+  cv::Ptr<HoGFeatureGenerator> gsHoG;
+  cv::Ptr<HoGFeatureGenerator> salHoG;
+  cv::Ptr<GaborFeatureGenerator> gabor;
+
+  // Positive classifications from all processed batches
+  CandidatePtrVector interestingCds;
+  unsigned processed = 0;
 
-    // Identifies edges around each IP
-    edgeSearch( gradients, color, imgLab32f, cdsAllUnordered, imgRGB32f );
+  for( bool first = true; first || processed < budgetCount; first = false )
+  {
+    // Stop once the frame deadline has passed
+    if( useBudget && Options->FrameTimeBudget > 0.0f &&
+        secondsSince( frameStart ) >= Options->FrameTimeBudget )
+    {
+      break;
+    }
+
+    CandidatePtrVector cdsBatch( cdsByPriority.begin() + processed,
+      cdsByPriority.begin() + min( processed + chunkSize, budgetCount ) );
+    processed += cdsBatch.size();
+
+    if( Options->Model->requiresFeatures() )
+    {
+      // Candidates which need the expensive features below
+      CandidatePtrVector cdsFeatureSet;
+
+      if( useCascade )
+      {
+        // Cheap size and color features, edge based size features are not
+        // known yet and are recomputed below for any survivors
+        for( int i=0; i<cdsBatch.size(); i++ ) {
+          calculateSizeFeatures( cdsBatch[i], inputProp, resizeFactor, sizeAdj );
+        }
+        createColorQuadrants( imgGrey32f, cdsBatch );
+        for( int i=0; i<cdsBatch.size(); i++ ) {
+          calculateColorFeatures( imgRGB32f, color, cdsBatch[i] );
+        }
+
+        // Reject easy negatives before any expensive features are computed
+        Options->Model->rejectCandidates( cdsBatch, cdsFeatureSet );
+      }
+      else
+      {
+        cdsFeatureSet = cdsBatch;
+      }
+
+      // Identifies edges around each IP
+      edgeSearch( gradients, color, imgLab32f, cdsFeatureSet, imgRGB32f );
 
 #ifdef ENABLE_BENCHMARKING
-    executionTimes.push_back( getTimeSinceLastCall() );
+      executionTimes.push_back( getTimeSinceLastCall() );
 #endif
 
-    // Creates an unoriented gs HoG descriptor around each IP
-    HoGFeatureGenerator gsHoG( imgGrey32f, minRadPixels, maxRadPixels, 0 );
-    gsHoG.Generate( cdsAllUnordered );
+      // Creates an unoriented gs HoG descriptor around each IP
+      if( gsHoG.empty() )
+      {
+        gsHoG = new HoGFeatureGenerator( imgGrey32f, minRadPixels, maxRadPixels, 0 );
+      }
+      gsHoG->Generate( cdsFeatureSet );
 
 #ifdef ENABLE_BENCHMARKING
-    executionTimes.push_back( getTimeSinceLastCall() );
+      executionTimes.push_back( getTimeSinceLastCall() );
 #endif
 
-    // Creates an unoriented sal HoG descriptor around each IP
-    HoGFeatureGenerator salHoG( color->SaliencyMap, minRadPixels, maxRadPixels, 1 );
-    salHoG.Generate( cdsAllUnordered );
+      // Creates an unoriented sal HoG descriptor around each IP
+      if( salHoG.empty() )
+      {
+        salHoG = new HoGFeatureGenerator( color->SaliencyMap, minRadPixels, maxRadPixels, 1 );
+      }
+      salHoG->Generate( cdsFeatureSet );
 
 #ifdef ENABLE_BENCHMARKING
-    executionTimes.push_back( getTimeSinceLastCall() );
+      executionTimes.push_back( getTimeSinceLastCall() );
 #endif
 
-    // Calculates size based features around each IP
-    float sizeAdj = ( Options->UseMetadata ? 1.0 : 0.0008 );
-      // Above is a hack to make size features more comparable when we have/don't
-      // have input metadata used to compute size info
-
-    for( int i=0; i<cdsAllUnordered.size(); i++ ) {
-      calculateSizeFeatures( cdsAllUnordered[i], inputProp, resizeFactor, sizeAdj );
-    }
+      // Calculates size based features around each IP
+      for( int i=0; i<cdsFeatureSet.size(); i++ ) {
+        calculateSizeFeatures( cdsFeatureSet[i], inputProp, resizeFactor, sizeAdj );
+      }
 
 #ifdef ENABLE_BENCHMARKING
-    executionTimes.push_back( getTimeSinceLastCall() );
+      executionTimes.push_back( getTimeSinceLastCall() );
 #endif
 
-    // Calculates color based features around each IP
-    createColorQuadrants( imgGrey32f, cdsAllUnordered );
-    for( int i=0; i<cdsAllUnordered.size(); i++ ) {
-      calculateColorFeatures( imgRGB32f, color, cdsAllUnordered[i] );
-    }
+      // Calculates color based features around each IP
+      if( !useCascade )
+      {
+        createColorQuadrants( imgGrey32f, cdsFeatureSet );
+        for( int i=0; i<cdsFeatureSet.size(); i++ ) {
+          calculateColorFeatures( imgRGB32f, color, cdsFeatureSet[i] );
+        }
+      }
 
 #ifdef ENABLE_BENCHMARKING
-    executionTimes.push_back( getTimeSinceLastCall() );
+      executionTimes.push_back( getTimeSinceLastCall() );
 #endif
 
-    // Calculates gabor based features around each IP
-    calculateGaborFeatures( imgGrey32f, cdsAllUnordered );
+      // Calculates gabor based features around each IP
+      if( gabor.empty() )
+      {
+        gabor = new GaborFeatureGenerator( imgGrey32f );
+      }
+      gabor->Generate( cdsFeatureSet );
 
 #ifdef ENABLE_BENCHMARKING
-    executionTimes.push_back( getTimeSinceLastCall() );
+      executionTimes.push_back( getTimeSinceLastCall() );
 #endif
+    }
+
+    // Classify candidates, keeping ones with positive classifications
+    if( !Options->IsTrainingMode )
+    {
+      CandidatePtrVector positive;
+      Options->Model->classifyCandidates( imgRGB8u, cdsBatch, positive );
+      interestingCds.insert( interestingCds.end(), positive.begin(), positive.end() );
+    }
+  }
+
+  // Anything left over was skipped by the budget
+  for( unsigned i=processed; i<cdsByPriority.size(); i++ ) {
+    cdsByPriority[i]->isActive = false;
   }
 
+  frameStats.TotalCandidates = cdsByPriority.size();
+  frameStats.ProcessedCandidates = processed;
+  frameStats.SkippedCandidates = cdsByPriority.size() - processed;
+  frameStats.BudgetExhausted = ( frameStats.SkippedCandidates > 0 );
+
 //----------------------Classify ROIs----------------------------
 
-  CandidatePtrVector interestingCds;
   CandidatePtrVector likelyObjects;
   DetectionPtrVector objects;
 
@@ -493,9 +842,6 @@ void *processImage( void *InputArgs ) {
   }
   else
   {
-    // Classify candidates, returning ones with positive classifications
-    Options->Model->classifyCandidates( imgRGB8u, cdsAllUnordered, interestingCds );
-
     // Calculate expensive edges around each interesting candidate point
     if( Options->Model->requiresFeatures() )
     {
@@ -519,37 +865,46 @@ void *processImage( void *InputArgs ) {
 //-----------------------Update Stats----------------------------
 
   // Update Detection variables and mask
-  /*if( !Options->IsTrainingMode )
+  if( Options->EnableColorAdaptation )
   {
-    for( unsigned int i=0; i<objects.size(); i++ ) {
-      Detection *cur = objects[i];
-      if( cur->isBrownScallop ) {
-        detections[SCALLOP_BROWN]++;
-        updateMask( mask, cur->r, cur->c, cur->angle, cur->major, cur->minor, SCALLOP_BROWN );
-      } else if( cur->isWhiteScallop ) {
-        detections[SCALLOP_WHITE]++;
-        updateMask( mask, cur->r, cur->c, cur->angle, cur->major, cur->minor, SCALLOP_WHITE );
-      } else if( cur->isBuriedScallop ) {
-        detections[SCALLOP_BURIED]++;
-        updateMaskRing( mask, cur->r, cur->c, cur->angle,
-          cur->major*0.8, cur->minor*0.8, cur->major, SCALLOP_BROWN );
+    if( !Options->IsTrainingMode )
+    {
+      for( unsigned int i=0; i<objects.size(); i++ ) {
+        Detection *cur = objects[i];
+        if( cur->isBrownScallop ) {
+          detections[SCALLOP_BROWN]++;
+          updateMask( mask, cur->r, cur->c, cur->angle, cur->major, cur->minor, SCALLOP_BROWN );
+        } else if( cur->isWhiteScallop ) {
+          detections[SCALLOP_WHITE]++;
+          updateMask( mask, cur->r, cur->c, cur->angle, cur->major, cur->minor, SCALLOP_WHITE );
+        } else if( cur->isBuriedScallop ) {
+          detections[SCALLOP_BURIED]++;
+          updateMaskRing( mask, cur->r, cur->c, cur->angle,
+            cur->major*0.8, cur->minor*0.8, cur->major, SCALLOP_BROWN );
+        }
       }
     }
-  }
-  else
-  {
-    // Quick hack: If we're not trying to detect scallops, reuse scallop histogram for better ip detections
-    for( unsigned int i=0; i<objects.size(); i++ ) {
-      Detection *cur = objects[i];
-      updateMask( mask, cur->r, cur->c, cur->angle, cur->major, cur->minor, SCALLOP_BROWN );
+    else
+    {
+      // Quick hack: If we're not trying to detect scallops, reuse scallop histogram for better ip detections
+      for( unsigned int i=0; i<objects.size(); i++ ) {
+        Detection *cur = objects[i];
+        updateMask( mask, cur->r, cur->c, cur->angle, cur->major, cur->minor, SCALLOP_BROWN );
+      }
     }
-  }*/
 
-  // Update color classifiers from mask and detections matrix
-  //CC->Update( imgRGB32f, mask, detections );
+    // Update color classifiers from mask and detections matrix
+    //  Deltas are published as a new shared filter generation
+    CC->Update( imgRGB32f, mask, detections );
 
-  // Update statistics
-  //Stats->Update( detections, inputProp.getImgHeightMeters() * inputProp.getImgWidthMeters() );
+    // Update statistics
+    float imageArea = inputProp.getImgHeightMeters() * inputProp.getImgWidthMeters();
+
+    if( imageArea > 0.0f )
+    {
+      Stats->Update( detections, imageArea );
+    }
+  }
 
   // Output results to image files
   if( Options->OutputDetectionImages )
@@ -576,6 +931,7 @@ void *processImage( void *InputArgs ) {
 
   // Copy final detections to class output
   Options->FinalDetections = resizedObjects;
+  frameStats.ElapsedSeconds = secondsSince( frameStart );
 
 //-------------------------Clean Up------------------------------
 
@@ -598,43 +954,910 @@ void *processImage( void *InputArgs ) {
   return NULL;
 }
 
-//--------------File system manager / algorithm caller------------------
+//---------------------Tiled mosaic processing--------------------------
 
-int runCoreDetector( const SystemParameters& settings )
+// Moves a detection and its contour by a whole pixel offset. Both must be
+// in input image pixels, as processImage outputs them
+static void shiftDetection( Detection& obj, int dr, int dc )
 {
-  // Retrieve some contents from input
-  string inputDir = settings.InputDirectory;
-  string inputFile = settings.InputFilename;
-  string outputDir = settings.OutputDirectory;
-  string outputFile = settings.OutputFilename;
+  obj.r += dr;
+  obj.c += dc;
 
-  // Compile a vector of all files to process with related info
-  vector<string> inputFilenames; // filenames (full or relative path)
-  vector<string> inputClassifiers; // corresponding classifier keys
-  vector<float> inputPitch; // input pitches, if used
-  vector<float> inputAltitudes; // input altitudes, if used
-  vector<float> inputRoll; // input rolls, if used
-  vector<string> subdirsToCreate; // subdirs we may be going to create
-  vector<string> outputFilenames; // corresponding output filenames if enabled
+  for( unsigned j = 0; j < obj.cntr.pts.size(); j++ )
+  {
+    obj.cntr.pts[j].r += dr;
+    obj.cntr.pts[j].c += dc;
+  }
+}
 
-  // GT file contents if required
-  string GTfilename = inputDir + inputFile;
-  GTEntryList* GTs = NULL;
+// Appends the final detections of the first AlgorithmArgs to its output list
+static void writeFinalDetections( AlgorithmArgs *inputArgs )
+{
+  // Asynchronously submitted frames can finish at the same time
+  static cv::Mutex listOutputLock;
 
-  // Process directory mode
-  if( settings.IsInputDirectory || settings.IsTrainingMode )
+  if( inputArgs[0].EnableListOutput )
   {
-    // Get a list of all files and sub directories in the input dir
-    listAllFile( inputDir, inputFilenames, subdirsToCreate );
-
-    // Remove files that don't have an image extension (jpg/tif)
-    cullNonImages( inputFilenames );
+    cv::AutoLock guard( listOutputLock );
 
-    // Initialize classifier array
-    inputClassifiers.resize( inputFilenames.size(), settings.ClassifierToUse );
+    if( !appendInfoToFile( inputArgs[0].FinalDetections, inputArgs[0].ListFilename,
+      inputArgs[0].InputFilenameNoDir ) )
+    {
+      cerr << "CRITICAL ERROR: Could not write to output list!" << endl;
+    }
   }
-  // If we're in process list mode
-  else if( !settings.IsTrainingMode )
+}
+
+// Worker pool for tiled processing, each worker owns one AlgorithmArgs and
+// pulls tiles from a shared queue so at most one tile per worker is in memory
+class TileWorkerBody : public cv::ParallelLoopBody
+{
+public:
+
+  TileWorkerBody( AlgorithmArgs *args, TileSource *source,
+    const vector< MosaicTile > *tiles, ImageProperties *scale, int *nextTile,
+    DetectionVector *output, FrameStatistics *stats, cv::Mutex *lock )
+  : args( args ), source( source ), tiles( tiles ), scale( scale ),
+    nextTile( nextTile ), output( output ), stats( stats ), lock( lock )
+  {}
+
+  void operator()( const cv::Range& range ) const
+  {
+    for( int w = range.start; w < range.end; w++ )
+    {
+      AlgorithmArgs& options = args[w];
+
+      while( true )
+      {
+        int index;
+        {
+          cv::AutoLock guard( *lock );
+          if( *nextTile >= (int)tiles->size() )
+            break;
+          index = (*nextTile)++;
+        }
+
+        const MosaicTile& tile = (*tiles)[index];
+        cv::Mat image;
+
+        if( !source->readRegion( tile.region, image ) )
+        {
+          cerr << "ERROR: Could not read mosaic tile at " << tile.region.x
+               << ", " << tile.region.y << endl;
+          continue;
+        }
+
+        if( scale )
+        {
+          scale->getPixelSizeMap( tile.region, options.PixelSizeMap );
+        }
+
+        options.InputImage = image;
+        processImage( &options );
+        options.InputImage = cv::Mat();
+        options.PixelSizeMap = cv::Mat();
+
+        // Keep detections centered in this tile's core, in mosaic coordinates
+        DetectionVector owned;
+
+        for( unsigned i = 0; i < options.FinalDetections.size(); i++ )
+        {
+          Detection obj = options.FinalDetections[i];
+
+          if( !tile.core.contains( cv::Point( (int)obj.c + tile.region.x,
+                                              (int)obj.r + tile.region.y ) ) )
+            continue;
+
+          shiftDetection( obj, tile.region.y, tile.region.x );
+          owned.push_back( obj );
+        }
+
+        cv::AutoLock guard( *lock );
+        output->insert( output->end(), owned.begin(), owned.end() );
+        stats->TotalCandidates += options.FrameStats.TotalCandidates;
+        stats->ProcessedCandidates += options.FrameStats.ProcessedCandidates;
+        stats->SkippedCandidates += options.FrameStats.SkippedCandidates;
+        stats->CappedCandidates += options.FrameStats.CappedCandidates;
+        stats->BudgetExhausted = stats->BudgetExhausted || options.FrameStats.BudgetExhausted;
+      }
+    }
+  }
+
+private:
+
+  AlgorithmArgs *args;
+  TileSource *source;
+  const vector< MosaicTile > *tiles;
+  ImageProperties *scale;
+  int *nextTile;
+  DetectionVector *output;
+  FrameStatistics *stats;
+  cv::Mutex *lock;
+};
+
+// Runs the detector over regions of a tile source, with detections centered
+// in each region's core kept, shifted into source coordinates and merged
+//
+// Regions use the given search radii in pixels, or if the source's per pixel
+// scale is given, the metric radii valid for the pixel sizes within each
+// region. Per region list, image and display outputs are disabled. Merged
+// detections are written to the FinalDetections of the first AlgorithmArgs.
+void processRegions( AlgorithmArgs *inputArgs, int workers, TileSource& source,
+  const vector< MosaicTile >& tiles, float minRadPixels, float maxRadPixels,
+  ImageProperties *scale = NULL )
+{
+#ifdef ENABLE_BENCHMARKING
+  // Benchmarking timers are global
+  workers = 1;
+#endif
+
+  workers = max( min( workers, (int)tiles.size() ), 1 );
+
+  // Per worker arguments, sharing the per thread color filters and stats
+  vector< AlgorithmArgs > tileArgs( workers, inputArgs[0] );
+
+  for( int w = 0; w < workers; w++ )
+  {
+    tileArgs[w].ThreadID = w;
+    tileArgs[w].CC = inputArgs[w].CC;
+    tileArgs[w].Stats = inputArgs[w].Stats;
+    tileArgs[w].InputImage = cv::Mat();
+    tileArgs[w].UseMetadata = ( scale != NULL );
+    tileArgs[w].FramePixelSize = ( scale ? scale->getAvgPixelSizeMeters() : 0.0f );
+    tileArgs[w].MinSearchRadiusPixels = minRadPixels;
+    tileArgs[w].MaxSearchRadiusPixels = maxRadPixels;
+    tileArgs[w].ProcessLeftHalfOnly = false;
+    tileArgs[w].StereoImage = cv::Mat();
+    tileArgs[w].EnableFrameGate = false;
+    tileArgs[w].EnableOutputDisplay = false;
+    tileArgs[w].EnableListOutput = false;
+    tileArgs[w].OutputProposalImages = false;
+    tileArgs[w].OutputDetectionImages = false;
+  }
+
+  DetectionVector tileDetections;
+  FrameStatistics stats;
+  int nextTile = 0;
+  cv::Mutex lock;
+
+  cv::parallel_for_( cv::Range( 0, workers ), TileWorkerBody( &tileArgs[0],
+    &source, &tiles, scale, &nextTile, &tileDetections, &stats, &lock ) );
+
+  // Merge objects found in more than one tile across seams
+  DetectionVector merged;
+  removeInsideDetections( tileDetections, merged );
+
+  inputArgs[0].FinalDetections = merged;
+  inputArgs[0].FrameStats = stats;
+}
+
+// Runs the detector over a mosaic tile by tile, with peak memory set by the
+// tile size and worker count rather than the mosaic size. Tiles use the
+// pixel search radii.
+void processMosaic( AlgorithmArgs *inputArgs, int workers,
+  TileSource& source, int tileSize )
+{
+  const int64 mosaicStart = cv::getTickCount();
+
+  // Tiles are sized from the largest object searched for
+  int margin = (int)ceil( TILE_MARGIN_RADII * inputArgs[0].MaxSearchRadiusPixels );
+  int coreSize = max( tileSize, TILE_MIN_CORE_MARGINS * margin );
+
+  vector< MosaicTile > tiles;
+  computeMosaicTiles( source.size(), coreSize, margin, tiles );
+
+  processRegions( inputArgs, workers, source, tiles,
+    inputArgs[0].MinSearchRadiusPixels, inputArgs[0].MaxSearchRadiusPixels );
+  writeFinalDetections( inputArgs );
+
+  inputArgs[0].FrameStats.ElapsedSeconds = secondsSince( mosaicStart );
+}
+
+// Screens an image for salient color blobs at SCREENING_PIXELS_FOR_MIN_RAD,
+// returning non-overlapping regions around them with the same context
+// margin as mosaic tiles, in image coordinates
+void screenImage( AlgorithmArgs *Options, const cv::Mat& image,
+  float minRadPixels, float maxRadPixels, vector< cv::Rect >& regions )
+{
+  regions.clear();
+
+  float scale = SCREENING_PIXELS_FOR_MIN_RAD / minRadPixels;
+  cv::Mat screenImg;
+
+  if( scale < RESIZE_FACTOR_REQUIRED )
+  {
+    cv::resize( image, screenImg,
+      cv::Size( max( (int)( scale*image.cols ), 1 ),
+                max( (int)( scale*image.rows ), 1 ) ),
+      0, 0, cv::INTER_AREA );
+  }
+  else
+  {
+    screenImg = image;
+    scale = 1.0f;
+  }
+
+  // Color classification is performed on 8u images, as in the full pass
+  cv::Mat screen8u;
+  screenImg.convertTo( screen8u, CV_8U, screenImg.depth() == CV_16U ? 1.0/257.0 : 1.0 );
+
+  IplImage screenIpl = screen8u;
+  hfResults *color = Options->CC->performColorClassification( &screenIpl,
+    minRadPixels * scale, maxRadPixels * scale );
+
+  CandidatePtrVector blobs;
+  detectSalientBlobs( color, blobs );
+  filterCandidates( blobs, minRadPixels * scale, maxRadPixels * scale, true );
+
+  // Pad each blob by the context margin, in full resolution coordinates
+  const int margin = (int)ceil( TILE_MARGIN_RADII * maxRadPixels );
+  const cv::Rect bounds( 0, 0, image.cols, image.rows );
+
+  for( unsigned i = 0; i < blobs.size(); i++ )
+  {
+    int r = (int)( blobs[i]->r / scale );
+    int c = (int)( blobs[i]->c / scale );
+    int extent = (int)ceil( blobs[i]->major / scale ) + margin;
+
+    cv::Rect region = cv::Rect( c - extent, r - extent,
+      2 * extent + 1, 2 * extent + 1 ) & bounds;
+
+    if( region.area() > 0 )
+    {
+      regions.push_back( region );
+    }
+  }
+
+  deallocateCandidates( blobs );
+  hfDeallocResults( color );
+
+  mergeRegions( regions );
+}
+
+// Processes the image in the first AlgorithmArgs whole once it has passed
+// the gate, reusing the scale already found for it rather than reading
+// metadata and matching the stereo pair again
+static void processGatedImage( AlgorithmArgs *inputArgs, const cv::Mat& image,
+  ImageProperties& imageProp )
+{
+  const bool gate = inputArgs[0].EnableFrameGate;
+  inputArgs[0].EnableFrameGate = false;
+
+  if( inputArgs[0].UseMetadata )
+  {
+    imageProp.getPixelSizeMap( cv::Rect( 0, 0, image.cols, image.rows ),
+      inputArgs[0].PixelSizeMap );
+    inputArgs[0].FramePixelSize = imageProp.getAvgPixelSizeMeters();
+  }
+
+  processImage( inputArgs );
+
+  inputArgs[0].EnableFrameGate = gate;
+  inputArgs[0].PixelSizeMap = cv::Mat();
+}
+
+// Screens the image in the first AlgorithmArgs and runs the detector only on
+// views of the regions found, or on the whole image if they cover most of it
+void processScreenedImage( AlgorithmArgs *inputArgs, int workers )
+{
+  const int64 screenStart = cv::getTickCount();
+
+  cv::Mat image = inputArgs[0].InputImage;
+
+  if( inputArgs[0].ProcessLeftHalfOnly )
+  {
+    image = image( cv::Rect( 0, 0, image.cols/2, image.rows ) );
+  }
+
+  inputArgs[0].FrameStats = FrameStatistics();
+  inputArgs[0].FinalDetections.clear();
+
+  if( frameRejected( &inputArgs[0], image ) )
+  {
+    inputArgs[0].FrameStats.ElapsedSeconds = secondsSince( screenStart );
+    return;
+  }
+
+  // Regions take their scale from the frame's image properties
+  ImageProperties imageProp;
+  float minRadPixels, maxRadPixels;
+
+  if( !computeSearchRadii( &inputArgs[0], image, imageProp, minRadPixels, maxRadPixels ) )
+  {
+    inputArgs[0].FrameStats.ProcessedFraction = 0.0f;
+    return;
+  }
+
+  vector< cv::Rect > regions;
+  screenImage( &inputArgs[0], image, minRadPixels, maxRadPixels, regions );
+
+  double coveredArea = 0.0;
+
+  for( unsigned i = 0; i < regions.size(); i++ )
+  {
+    coveredArea += regions[i].area();
+  }
+
+  if( coveredArea > inputArgs[0].ScreeningMaxCoverage * image.cols * image.rows )
+  {
+    processGatedImage( inputArgs, image, imageProp );
+  }
+  else
+  {
+    // Regions never overlap, so each owns everything found within it
+    vector< MosaicTile > tiles( regions.size() );
+
+    for( unsigned i = 0; i < regions.size(); i++ )
+    {
+      tiles[i].region = regions[i];
+      tiles[i].core = regions[i];
+    }
+
+    MatTileSource source( image );
+    processRegions( inputArgs, workers, source, tiles, minRadPixels, maxRadPixels,
+      inputArgs[0].UseMetadata ? &imageProp : NULL );
+    writeFinalDetections( inputArgs );
+  }
+
+  inputArgs[0].FrameStats.ElapsedSeconds = secondsSince( screenStart );
+}
+
+// Processes the image in the first AlgorithmArgs in bands across the
+// direction its scale changes along, each searching only the radii valid
+// for the pixel sizes within it, or whole if its scale is near uniform
+void processScaleBands( AlgorithmArgs *inputArgs, int workers )
+{
+  const int64 bandStart = cv::getTickCount();
+
+  cv::Mat image = inputArgs[0].InputImage;
+
+  if( inputArgs[0].ProcessLeftHalfOnly )
+  {
+    image = image( cv::Rect( 0, 0, image.cols/2, image.rows ) );
+  }
+
+  inputArgs[0].FrameStats = FrameStatistics();
+  inputArgs[0].FinalDetections.clear();
+
+  if( frameRejected( &inputArgs[0], image ) )
+  {
+    inputArgs[0].FrameStats.ElapsedSeconds = secondsSince( bandStart );
+    return;
+  }
+
+  ImageProperties imageProp;
+  float minRadPixels, maxRadPixels;
+
+  if( !computeSearchRadii( &inputArgs[0], image, imageProp, minRadPixels, maxRadPixels ) )
+  {
+    inputArgs[0].FrameStats.ProcessedFraction = 0.0f;
+    return;
+  }
+
+  const int bands = inputArgs[0].ScaleMapBands;
+
+  if( !imageProp.hasPixelSizeMap() || bands < 2 ||
+      imageProp.getMaxPixelSizeMeters() <
+        SCALE_BAND_MIN_RANGE * imageProp.getMinPixelSizeMeters() )
+  {
+    processGatedImage( inputArgs, image, imageProp );
+  }
+  else
+  {
+    // Slice across whichever image axis the scale changes most along
+    const float rows = image.rows, cols = image.cols;
+    const float top = imageProp.getPixelSizeMeters( 0, cols/2 );
+    const float bottom = imageProp.getPixelSizeMeters( rows-1, cols/2 );
+    const float left = imageProp.getPixelSizeMeters( rows/2, 0 );
+    const float right = imageProp.getPixelSizeMeters( rows/2, cols-1 );
+    const bool horizontal = fabs( log( top / bottom ) ) >= fabs( log( left / right ) );
+
+    const int length = ( horizontal ? image.rows : image.cols );
+    const int margin = (int)ceil( TILE_MARGIN_RADII * maxRadPixels );
+    const cv::Rect bounds( 0, 0, image.cols, image.rows );
+
+    vector< MosaicTile > tiles( bands );
+
+    for( int b = 0; b < bands; b++ )
+    {
+      const int start = ( b * length ) / bands;
+      const int end = ( ( b + 1 ) * length ) / bands;
+
+      if( horizontal )
+      {
+        tiles[b].core = cv::Rect( 0, start, image.cols, end - start );
+        tiles[b].region = cv::Rect( 0, start - margin,
+          image.cols, end - start + 2 * margin ) & bounds;
+      }
+      else
+      {
+        tiles[b].core = cv::Rect( start, 0, end - start, image.rows );
+        tiles[b].region = cv::Rect( start - margin, 0,
+          end - start + 2 * margin, image.rows ) & bounds;
+      }
+    }
+
+    MatTileSource source( image );
+    processRegions( inputArgs, workers, source, tiles,
+      minRadPixels, maxRadPixels, &imageProp );
+    writeFinalDetections( inputArgs );
+  }
+
+  inputArgs[0].FrameStats.ElapsedSeconds = secondsSince( bandStart );
+}
+
+// Converts the stereo pair image of the first AlgorithmArgs from format to
+// BGR, so that it keeps matching an input image converted the same way
+static void normalizeStereoFormat( AlgorithmArgs *inputArgs, int format )
+{
+  if( format != PIXEL_FORMAT_BGR && !inputArgs[0].StereoImage.empty() )
+  {
+    cv::Mat converted;
+    convertPixelFormat( inputArgs[0].StereoImage, format,
+      inputArgs[0].StereoImage.size(), converted );
+    inputArgs[0].StereoImage = converted;
+  }
+}
+
+// Converts the input image of the first AlgorithmArgs to BGR up front, for
+// processing modes which read regions of it rather than formatting it whole
+static void normalizeInputFormat( AlgorithmArgs *inputArgs )
+{
+  if( inputArgs[0].InputFormat != PIXEL_FORMAT_BGR )
+  {
+    normalizeStereoFormat( inputArgs, inputArgs[0].InputFormat );
+
+    cv::Mat converted;
+    convertPixelFormat( inputArgs[0].InputImage, inputArgs[0].InputFormat,
+      inputArgs[0].InputImage.size(), converted );
+    inputArgs[0].InputImage = converted;
+    inputArgs[0].InputFormat = PIXEL_FORMAT_BGR;
+  }
+}
+
+// Processes the image in the first AlgorithmArgs, as tiles if it is larger
+// than tileSize on either side, else in scale bands or screened first if
+// enabled, using the first workers AlgorithmArgs for parallel regions
+void processInputImage( AlgorithmArgs *inputArgs, int tileSize, int workers )
+{
+  const cv::Mat& image = inputArgs[0].InputImage;
+
+  if( tileSize > 0 && !inputArgs[0].IsTrainingMode &&
+      ( image.cols > tileSize || image.rows > tileSize ) )
+  {
+    normalizeInputFormat( inputArgs );
+    MatTileSource source( inputArgs[0].InputImage );
+    processMosaic( inputArgs, workers, source, tileSize );
+  }
+  else if( inputArgs[0].EnableScaleMap && inputArgs[0].UseMetadata &&
+           !inputArgs[0].IsTrainingMode )
+  {
+    normalizeInputFormat( inputArgs );
+    processScaleBands( inputArgs, workers );
+  }
+  else if( inputArgs[0].EnableScreeningPass && !inputArgs[0].IsTrainingMode )
+  {
+    normalizeInputFormat( inputArgs );
+    processScreenedImage( inputArgs, workers );
+  }
+  else
+  {
+    processImage( inputArgs );
+  }
+}
+
+// Processes a TIFF mosaic larger than tileSize straight from disk, without
+// ever decoding it whole. Returns false if the file should be loaded instead.
+bool processMosaicFile( AlgorithmArgs *inputArgs, const string& filename, int tileSize )
+{
+#ifdef USE_TIFF
+  const int type = getImageType( filename );
+
+  if( tileSize <= 0 || inputArgs[0].IsTrainingMode ||
+      ( type != RAW_TIF && type != RAW_TIFF ) )
+  {
+    return false;
+  }
+
+  TiffTileSource *source = TiffTileSource::open( filename );
+
+  if( !source )
+  {
+    return false;
+  }
+
+  const cv::Size size = source->size();
+  const bool isMosaic = ( size.width > tileSize || size.height > tileSize );
+
+  if( isMosaic )
+  {
+    inputArgs[0].InputImage = cv::Mat();
+    processMosaic( inputArgs, THREADS, *source, tileSize );
+  }
+
+  delete source;
+  return isMosaic;
+#else
+  return false;
+#endif
+}
+
+//---------------------Footprint overlap skipping-----------------------
+
+// Processes only the parts of the image in the first AlgorithmArgs which are
+// not set in the coverage mask, skipping it entirely if more than
+// maxCoverage of it is covered
+void processUncoveredImage( AlgorithmArgs *inputArgs, const cv::Mat& coverage,
+  float maxCoverage, int tileSize )
+{
+  const int64 frameStart = cv::getTickCount();
+  const double covered = (double)cv::countNonZero( coverage ) / ( coverage.cols * coverage.rows );
+
+  if( covered == 0.0 )
+  {
+    processInputImage( inputArgs, tileSize, THREADS );
+    return;
+  }
+
+  cv::Mat image = inputArgs[0].InputImage;
+
+  if( inputArgs[0].ProcessLeftHalfOnly )
+  {
+    image = image( cv::Rect( 0, 0, image.cols/2, image.rows ) );
+  }
+
+  inputArgs[0].FrameStats = FrameStatistics();
+  inputArgs[0].FinalDetections.clear();
+
+  ImageProperties imageProp;
+  float minRadPixels, maxRadPixels;
+
+  if( covered > maxCoverage || frameRejected( &inputArgs[0], image ) ||
+    !computeSearchRadii( &inputArgs[0], image, imageProp, minRadPixels, maxRadPixels ) )
+  {
+    inputArgs[0].FrameStats.ProcessedFraction = 0.0f;
+  }
+  else
+  {
+    // Bounding boxes of the uncovered parts, in image coordinates
+    cv::Mat uncovered;
+    cv::threshold( coverage, uncovered, 0, 255, CV_THRESH_BINARY_INV );
+
+    vector< vector< cv::Point > > contours;
+    cv::findContours( uncovered, contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE );
+
+    const double scaleX = (double)image.cols / coverage.cols;
+    const double scaleY = (double)image.rows / coverage.rows;
+    const cv::Rect bounds( 0, 0, image.cols, image.rows );
+    vector< cv::Rect > cores;
+
+    for( unsigned i = 0; i < contours.size(); i++ )
+    {
+      cv::Rect box = cv::boundingRect( contours[i] );
+      cores.push_back( cv::Rect( (int)( box.x * scaleX ), (int)( box.y * scaleY ),
+        (int)ceil( box.width * scaleX ), (int)ceil( box.height * scaleY ) ) & bounds );
+    }
+
+    mergeRegions( cores );
+
+    // Cores get the same context margin as mosaic tiles
+    const int margin = (int)ceil( TILE_MARGIN_RADII * maxRadPixels );
+    vector< MosaicTile > tiles;
+    double processedArea = 0.0;
+
+    for( unsigned i = 0; i < cores.size(); i++ )
+    {
+      if( cores[i].area() <= 0 )
+        continue;
+
+      MosaicTile tile;
+      tile.core = cores[i];
+      tile.region = cv::Rect( cores[i].x - margin, cores[i].y - margin,
+        cores[i].width + 2 * margin, cores[i].height + 2 * margin ) & bounds;
+      tiles.push_back( tile );
+      processedArea += cores[i].area();
+    }
+
+    MatTileSource source( image );
+    processRegions( inputArgs, THREADS, source, tiles, minRadPixels, maxRadPixels,
+      inputArgs[0].UseMetadata ? &imageProp : NULL );
+    writeFinalDetections( inputArgs );
+
+    inputArgs[0].FrameStats.ProcessedFraction = processedArea / bounds.area();
+  }
+
+  inputArgs[0].FrameStats.ElapsedSeconds = secondsSince( frameStart );
+}
+
+//---------------------Sequential frame reuse---------------------------
+
+// Last frame seen by a streaming detector, for reuse on the next frame
+struct TemporalState
+{
+  // Processed image and its grey motion thumbnail
+  cv::Mat Image;
+  cv::Mat Thumbnail;
+
+  // Detections on the image
+  DetectionVector Detections;
+
+  // Frames processed incrementally since the last full frame
+  int ReusedFrames;
+
+  TemporalState() : ReusedFrames( 0 ) {}
+};
+
+// Creates the 32f grey thumbnail used for motion estimation, returns its scale
+static float createMotionThumbnail( const cv::Mat& image, cv::Mat& thumbnail )
+{
+  float scale = min( (float)TEMPORAL_THUMBNAIL_WIDTH / image.cols, 1.0f );
+
+  cv::Mat resized, grey;
+  cv::resize( image, resized, cv::Size( max( (int)( scale*image.cols ), 1 ),
+    max( (int)( scale*image.rows ), 1 ) ), 0, 0, cv::INTER_AREA );
+
+  if( resized.channels() == 3 )
+  {
+    cv::cvtColor( resized, grey, CV_RGB2GRAY );
+  }
+  else
+  {
+    grey = resized;
+  }
+
+  grey.convertTo( thumbnail, CV_32F );
+  return scale;
+}
+
+// Estimates how far image content moved from the previous thumbnail to the
+// current one by phase correlation. Fails unless at least minOverlap of the
+// frames overlap and the overlapping parts agree once aligned.
+static bool estimateFrameShift( const cv::Mat& previous, const cv::Mat& current,
+  float minOverlap, cv::Point2d& shift )
+{
+  if( previous.size() != current.size() )
+  {
+    return false;
+  }
+
+  cv::Mat window;
+  cv::createHanningWindow( window, current.size(), CV_32F );
+  shift = cv::phaseCorrelate( previous, current, window );
+
+  // Content at x in the previous thumbnail is at x + shift in the current one
+  const cv::Point offset( cvRound( shift.x ), cvRound( shift.y ) );
+  const cv::Rect bounds( 0, 0, current.cols, current.rows );
+  const cv::Rect currentPart = cv::Rect( offset.x, offset.y, current.cols, current.rows ) & bounds;
+
+  if( currentPart.area() < minOverlap * bounds.area() )
+  {
+    return false;
+  }
+
+  const cv::Rect previousPart = currentPart - offset;
+
+  cv::Mat agreement;
+  cv::matchTemplate( current( currentPart ), previous( previousPart ),
+    agreement, CV_TM_CCOEFF_NORMED );
+
+  return agreement.at<float>( 0, 0 ) >= TEMPORAL_MIN_ALIGNMENT;
+}
+
+// Does the area around a previous detection look the same at its new place?
+static bool verifyCarriedDetection( const cv::Mat& previous, const cv::Mat& current,
+  const Detection& obj, const cv::Point& offset )
+{
+  const int radius = max( (int)ceil( obj.major ), 2 );
+  const cv::Rect fullPatch( (int)obj.c - radius, (int)obj.r - radius,
+    2 * radius + 1, 2 * radius + 1 );
+
+  // Only compare what is inside both images
+  cv::Rect previousPatch = fullPatch & cv::Rect( 0, 0, previous.cols, previous.rows );
+  cv::Rect currentPatch = ( previousPatch + offset ) & cv::Rect( 0, 0, current.cols, current.rows );
+  previousPatch = currentPatch - offset;
+
+  if( 2 * currentPatch.area() < fullPatch.area() )
+  {
+    return false;
+  }
+
+  cv::Mat previous32f, current32f, agreement;
+  previous( previousPatch ).convertTo( previous32f, CV_32F );
+  current( currentPatch ).convertTo( current32f, CV_32F );
+  cv::matchTemplate( current32f, previous32f, agreement, CV_TM_CCOEFF_NORMED );
+
+  return agreement.at<float>( 0, 0 ) >= TEMPORAL_MIN_AGREEMENT;
+}
+
+// Processes the image in the first AlgorithmArgs as the next frame of a
+// sequence. If it overlaps the last frame by at least minOverlap, only the
+// newly exposed strips are processed in full, plus the surroundings of any
+// carried over detection which no longer matches the image. All other
+// detections of the last frame are moved into place and kept.
+void processSequentialFrame( AlgorithmArgs *inputArgs, TemporalState& state,
+  int tileSize, float minOverlap )
+{
+  const int64 frameStart = cv::getTickCount();
+
+  cv::Mat image = inputArgs[0].InputImage;
+
+  if( inputArgs[0].ProcessLeftHalfOnly )
+  {
+    image = image( cv::Rect( 0, 0, image.cols/2, image.rows ) );
+  }
+
+  cv::Mat thumbnail;
+  float thumbnailScale = createMotionThumbnail( image, thumbnail );
+  cv::Point2d shift;
+
+  bool reuse = !state.Image.empty() &&
+    state.Image.size() == image.size() &&
+    state.ReusedFrames < TEMPORAL_REFRESH_INTERVAL &&
+    estimateFrameShift( state.Thumbnail, thumbnail, minOverlap, shift );
+
+  inputArgs[0].FrameStats = FrameStatistics();
+
+  ImageProperties imageProp;
+  float minRadPixels, maxRadPixels;
+
+  if( !reuse )
+  {
+    processInputImage( inputArgs, tileSize, THREADS );
+    state.ReusedFrames = 0;
+  }
+  else if( frameRejected( &inputArgs[0], image ) ||
+    !computeSearchRadii( &inputArgs[0], image, imageProp, minRadPixels, maxRadPixels ) )
+  {
+    inputArgs[0].FinalDetections.clear();
+  }
+  else
+  {
+    const cv::Point offset( cvRound( shift.x / thumbnailScale ),
+      cvRound( shift.y / thumbnailScale ) );
+    const cv::Rect bounds( 0, 0, image.cols, image.rows );
+    const cv::Rect overlap = cv::Rect( offset.x, offset.y, image.cols, image.rows ) & bounds;
+
+    // Newly exposed strips, a full height one on the side the camera moved
+    // towards and one spanning the overlap above or below
+    vector< cv::Rect > cores;
+
+    if( offset.x > 0 )
+      cores.push_back( cv::Rect( 0, 0, overlap.x, image.rows ) );
+    else if( offset.x < 0 )
+      cores.push_back( cv::Rect( overlap.br().x, 0, image.cols - overlap.br().x, image.rows ) );
+
+    if( offset.y > 0 )
+      cores.push_back( cv::Rect( overlap.x, 0, overlap.width, overlap.y ) );
+    else if( offset.y < 0 )
+      cores.push_back( cv::Rect( overlap.x, overlap.br().y, overlap.width, image.rows - overlap.br().y ) );
+
+    // Objects cut off by the previous frame's edge have their centers just
+    // inside the overlap, so strips reach into it by a max search radius
+    const int reach = (int)ceil( maxRadPixels );
+
+    for( unsigned i = 0; i < cores.size(); i++ )
+    {
+      cores[i] = cv::Rect( cores[i].x - reach, cores[i].y - reach,
+        cores[i].width + 2 * reach, cores[i].height + 2 * reach ) & bounds;
+    }
+
+    // Carry over previous detections which still match the image, and
+    // reprocess around the ones which do not
+    DetectionVector carried;
+    vector< cv::Rect > failed;
+
+    for( unsigned i = 0; i < state.Detections.size(); i++ )
+    {
+      Detection obj = state.Detections[i];
+      cv::Point center( (int)obj.c + offset.x, (int)obj.r + offset.y );
+
+      if( !overlap.contains( center ) )
+        continue;
+
+      if( verifyCarriedDetection( state.Image, image, obj, offset ) )
+      {
+        shiftDetection( obj, offset.y, offset.x );
+        carried.push_back( obj );
+      }
+      else
+      {
+        int radius = (int)ceil( obj.major );
+        failed.push_back( cv::Rect( center.x - radius, center.y - radius,
+          2 * radius + 1, 2 * radius + 1 ) & bounds );
+      }
+    }
+
+    mergeRegions( failed );
+    cores.insert( cores.end(), failed.begin(), failed.end() );
+
+    // Cores get the same context margin as mosaic tiles
+    const int margin = (int)ceil( TILE_MARGIN_RADII * maxRadPixels );
+    vector< MosaicTile > tiles;
+
+    for( unsigned i = 0; i < cores.size(); i++ )
+    {
+      if( cores[i].area() <= 0 )
+        continue;
+
+      MosaicTile tile;
+      tile.core = cores[i];
+      tile.region = cv::Rect( cores[i].x - margin, cores[i].y - margin,
+        cores[i].width + 2 * margin, cores[i].height + 2 * margin ) & bounds;
+      tiles.push_back( tile );
+    }
+
+    MatTileSource source( image );
+    processRegions( inputArgs, THREADS, source, tiles, minRadPixels, maxRadPixels,
+      inputArgs[0].UseMetadata ? &imageProp : NULL );
+
+    // Reprocessed surroundings may find a carried over object again
+    DetectionVector combined = carried;
+    combined.insert( combined.end(), inputArgs[0].FinalDetections.begin(),
+      inputArgs[0].FinalDetections.end() );
+
+    inputArgs[0].FinalDetections.clear();
+    removeInsideDetections( combined, inputArgs[0].FinalDetections );
+    inputArgs[0].FrameStats.CarriedDetections = carried.size();
+
+    writeFinalDetections( inputArgs );
+    state.ReusedFrames++;
+  }
+
+  inputArgs[0].FrameStats.ElapsedSeconds = secondsSince( frameStart );
+
+  // Rejected frames are never reused
+  if( inputArgs[0].FrameStats.GateResult == GATE_PASSED )
+  {
+    state.Image = image;
+    state.Thumbnail = thumbnail;
+    state.Detections = inputArgs[0].FinalDetections;
+  }
+  else
+  {
+    state = TemporalState();
+  }
+}
+
+//--------------File system manager / algorithm caller------------------
+
+int runCoreDetector( const SystemParameters& settings )
+{
+  // Retrieve some contents from input
+  string inputDir = settings.InputDirectory;
+  string inputFile = settings.InputFilename;
+  string outputDir = settings.OutputDirectory;
+  string outputFile = settings.OutputFilename;
+
+  // Compile a vector of all files to process with related info
+  vector<string> inputFilenames; // filenames (full or relative path)
+  vector<string> inputClassifiers; // corresponding classifier keys
+  vector<float> inputPitch; // input pitches, if used
+  vector<float> inputAltitudes; // input altitudes, if used
+  vector<float> inputRoll; // input rolls, if used
+  vector<float> inputHeading; // input headings, if footprints are used
+  vector<float> inputX; // input positions, if footprints are used
+  vector<float> inputY;
+  vector<string> subdirsToCreate; // subdirs we may be going to create
+  vector<string> outputFilenames; // corresponding output filenames if enabled
+
+  // GT file contents if required
+  string GTfilename = inputDir + inputFile;
+  GTEntryList* GTs = NULL;
+
+  // Process directory mode
+  if( settings.IsInputDirectory || settings.IsTrainingMode )
+  {
+    // Get a list of all files and sub directories in the input dir
+    listAllFile( inputDir, inputFilenames, subdirsToCreate );
+
+    // Remove files that don't have an image extension (jpg/tif)
+    cullNonImages( inputFilenames );
+
+    // Initialize classifier array
+    inputClassifiers.resize( inputFilenames.size(), settings.ClassifierToUse );
+  }
+  // If we're in process list mode
+  else if( !settings.IsTrainingMode )
   {
     // Read input list
     string list_fn = inputDir + inputFile;
@@ -665,6 +1888,25 @@ int runCoreDetector( const SystemParameters& settings )
           inputClassifiers.push_back( classifierKey );
         }
       }
+      // Metadata and navigation data are in the list
+      else if( settings.EnableFootprintSkipping )
+      {
+        float heading, x, y;
+        input >> inputFile >> alt >> pitch >> roll >> heading >> x >> y >> classifierKey;
+        removeSpaces( inputFile );
+        removeSpaces( classifierKey );
+        if( inputFile.size() > 0 && classifierKey.size() > 0 )
+        {
+          inputFilenames.push_back( inputFile );
+          inputClassifiers.push_back( classifierKey );
+          inputAltitudes.push_back( alt );
+          inputRoll.push_back( roll );
+          inputPitch.push_back( pitch );
+          inputHeading.push_back( heading );
+          inputX.push_back( x );
+          inputY.push_back( y );
+        }
+      }
       // Metadata is in the list
       else
       {
@@ -832,12 +2074,15 @@ int runCoreDetector( const SystemParameters& settings )
   cout << "FINISHED" << endl;
 
   // Load Statistics/Color filters
+  //  Filter banks are mapped once and shared, only adaptive state is per thread
   cout << "Loading Colour Filters... ";
   AlgorithmArgs *inputArgs = new AlgorithmArgs[THREADS];
+  hfSharedModel *colorModel = new hfSharedModel;
 
   for( int i=0; i < THREADS; i++ )
   {
     inputArgs[i].CC = new ColorClassifier;
+    inputArgs[i].CC->setSharedModel( colorModel, i );
     inputArgs[i].Stats = new ThreadStatistics;
     if( !inputArgs[i].CC->loadFilters( settings.RootColorDIR, DEFAULT_COLORBANK_EXT ) ) {
       cerr << "ERROR: Could not load colour filters!" << std::endl;
@@ -850,7 +2095,23 @@ int runCoreDetector( const SystemParameters& settings )
   for( int i=0; i<THREADS; i++ )
   {
     // Set thread output options
+    inputArgs[i].ThreadID = i;
     inputArgs[i].IsTrainingMode = settings.IsTrainingMode;
+    inputArgs[i].EnableColorAdaptation = settings.EnableColorAdaptation;
+    inputArgs[i].UseComponentTreeThresholding = settings.UseComponentTreeThresholding;
+    inputArgs[i].FrameTimeBudget = settings.FrameTimeBudget;
+    inputArgs[i].FrameCandidateBudget = settings.FrameCandidateBudget;
+    inputArgs[i].MaxBlobCandidates = settings.MaxBlobCandidates;
+    inputArgs[i].MaxAdaptiveCandidates = settings.MaxAdaptiveCandidates;
+    inputArgs[i].MaxTemplateCandidates = settings.MaxTemplateCandidates;
+    inputArgs[i].MaxCannyCandidates = settings.MaxCannyCandidates;
+    inputArgs[i].EnableScreeningPass = settings.EnableScreeningPass;
+    inputArgs[i].ScreeningMaxCoverage = settings.ScreeningMaxCoverage;
+    inputArgs[i].EnableFrameGate = settings.EnableFrameGate;
+    inputArgs[i].GateParameters.MaxClippedFraction = settings.GateMaxClippedFraction;
+    inputArgs[i].GateParameters.MinContrast = settings.GateMinContrast;
+    inputArgs[i].GateParameters.MinEntropy = settings.GateMinEntropy;
+    inputArgs[i].GateParameters.MinSalientFraction = settings.GateMinSalientFraction;
     inputArgs[i].UseGTData = settings.UseFileForTraining;
     inputArgs[i].TrainingPercentKeep = settings.TrainingPercentKeep;
     inputArgs[i].ProcessBorderPoints = settings.LookAtBorderPoints;
@@ -869,6 +2130,11 @@ int runCoreDetector( const SystemParameters& settings )
     inputArgs[i].MaxSearchRadiusPixels = settings.MaxSearchRadiusPixels;
     inputArgs[i].UseMetadata = settings.UseMetadata;
     inputArgs[i].ProcessLeftHalfOnly = settings.ProcessLeftHalfOnly;
+    inputArgs[i].InputFormat = PIXEL_FORMAT_BGR;
+    inputArgs[i].StereoBaseline = settings.StereoBaseline;
+    inputArgs[i].StereoMaxDisparity = settings.StereoMaxDisparity;
+    inputArgs[i].EnableScaleMap = settings.EnableScaleMap;
+    inputArgs[i].ScaleMapBands = settings.ScaleMapBands;
   }
 
   // Initiate display window for output
@@ -884,6 +2150,18 @@ int runCoreDetector( const SystemParameters& settings )
     }
   }
 
+  // Seafloor already covered by processed images, if skipping overlaps
+  FootprintIndex footprints;
+  const bool useFootprints = settings.EnableFootprintSkipping &&
+    !inputHeading.empty() && !settings.IsTrainingMode;
+
+  // Frames rejected by the pre-gate, by reason
+  int gateRejections[GATE_RESULTS];
+  for( int i=0; i<GATE_RESULTS; i++ )
+  {
+    gateRejections[i] = 0;
+  }
+
   // Cycle through all input files
   cout << endl << "Processing Files: " << endl << endl;
   cout << "Directory: " << inputDir << endl << endl;
@@ -915,13 +2193,52 @@ int runCoreDetector( const SystemParameters& settings )
       inputArgs[0].Roll = inputRoll[i];
     }
 
-    // Load image from file
-    cv::Mat image;
-    image = imread( inputFilenames[i], CV_LOAD_IMAGE_COLOR );
-    inputArgs[0].InputImage = image;
+    // Large TIFF mosaics are streamed from disk, anything else is loaded
+    if( !processMosaicFile( inputArgs, inputFilenames[i], settings.TileSize ) )
+    {
+      // Load image from file
+      cv::Mat image;
+      image = imread( inputFilenames[i], CV_LOAD_IMAGE_COLOR );
+      inputArgs[0].InputImage = image;
 
-    // Execute processing
-    processImage( inputArgs );
+      // Execute processing
+      if( useFootprints && image.cols > 0 && image.rows > 0 )
+      {
+        int cols = ( settings.ProcessLeftHalfOnly ? image.cols/2 : image.cols );
+
+        Footprint footprint;
+        computeFootprint( inputX[i], inputY[i], inputHeading[i], inputPitch[i],
+          inputRoll[i], inputAltitudes[i], settings.FocalLength, cols, image.rows,
+          footprint );
+
+        cv::Mat coverage;
+        computeCoverageMask( footprints, footprint, cv::Size( cols, image.rows ), coverage );
+
+        processUncoveredImage( inputArgs, coverage, settings.FootprintMaxCoverage,
+          settings.TileSize );
+
+        // Only seafloor which went through the detector counts as covered
+        if( inputArgs[0].FrameStats.ProcessedFraction > 0.0f )
+        {
+          footprints.insert( footprint );
+        }
+
+        cout << "  Processed " << (int)( 100 * inputArgs[0].FrameStats.ProcessedFraction )
+             << "% of image" << endl;
+      }
+      else
+      {
+        processInputImage( inputArgs, settings.TileSize, THREADS );
+      }
+    }
+
+    gateRejections[ inputArgs[0].FrameStats.GateResult ]++;
+
+    if( inputArgs[0].FrameStats.BudgetExhausted )
+    {
+      cout << "  Frame budget exhausted, skipped " << inputArgs[0].FrameStats.SkippedCandidates
+           << " of " << inputArgs[0].FrameStats.TotalCandidates << " candidates" << endl;
+    }
 
 #ifdef ENABLE_BENCHMARKING
     // Output benchmarking results to file
@@ -937,11 +2254,33 @@ int runCoreDetector( const SystemParameters& settings )
     }
   }
 
+  // Report frames skipped by the pre-gate
+  if( settings.EnableFrameGate )
+  {
+    int rejected = 0;
+    for( int i=GATE_PASSED+1; i<GATE_RESULTS; i++ )
+    {
+      rejected += gateRejections[i];
+    }
+
+    cout << endl << "Frames rejected by pre-gate: " << rejected << endl;
+
+    for( int i=GATE_PASSED+1; i<GATE_RESULTS; i++ )
+    {
+      if( gateRejections[i] > 0 )
+      {
+        cout << "  " << gateResultName( i ) << ": " << gateRejections[i] << endl;
+      }
+    }
+  }
+
   // Deallocate algorithm inputs
   for( int i=0; i < THREADS; i++ ) {
     delete inputArgs[i].Stats;
     delete inputArgs[i].CC;
   }
+
+  delete colorModel;
   delete[] inputArgs;
 
   // Deallocate loaded classifier systems
@@ -975,8 +2314,36 @@ int runCoreDetector( const SystemParameters& settings )
     delete GTs;
   }
 
-  return 0;
-}
+  return 0;
+}
+
+// A frame submitted for asynchronous processing, and its result
+class FrameFuture::State
+{
+public:
+
+  State() : done( false ), wasDropped( false ) {}
+
+  // Inputs
+  unsigned id;
+  cv::Mat image;
+  int format;
+  float pitch;
+  float roll;
+  float altitude;
+  FrameCallback callback;
+  void* userData;
+
+  // Outputs, only read once done is set
+  std::vector< Detection > detections;
+  FrameStatistics stats;
+  std::string error;
+  bool done;
+  bool wasDropped;
+
+  // Guards done, and wakes threads waiting for it
+  Monitor monitor;
+};
 
 // Streaming class definition, for use by external libraries
 class CoreDetector::Priv
@@ -988,13 +2355,77 @@ public:
 
   Classifier* classifier;
   AlgorithmArgs *inputArgs;
+  hfSharedModel *colorModel;
   SystemParameters settings;
+  TemporalState temporal;
   unsigned counter;
+
+  // Set of AlgorithmArgs running asynchronously submitted frames one by one
+  struct AsyncSlot
+  {
+    Priv *owner;
+    int first;
+    int count;
+    ThreadHandle thread;
+  };
+
+  // Asynchronous processing state, guarded by asyncMonitor
+  Monitor asyncMonitor;
+  deque< cv::Ptr< FrameFuture::State > > asyncQueue;
+  vector< AsyncSlot > asyncSlots;
+  int asyncRunning;
+  int asyncWindow;
+  int asyncPolicy;
+  bool asyncStopping;
+
+  // Statistics of the last synchronous frame, guarded by asyncMonitor as
+  // slot threads reuse the first AlgorithmArgs
+  FrameStatistics lastStats;
+
+  // Processes a streaming frame of any PIXEL_FORMAT_* synchronously
+  std::vector< Detection > processFrame( const cv::Mat& image, int format,
+    float pitch, float roll, float altitude );
+
+  // Processes a frame with workers AlgorithmArgs from args, leaving the
+  // results in the first
+  void runFrame( AlgorithmArgs *args, int workers, const cv::Mat& image,
+    int format, float pitch, float roll, float altitude, unsigned id );
+
+  // Queues a frame, applying the backpressure policy unless told to always
+  // wait for room
+  cv::Ptr< FrameFuture::State > submitFrame( const cv::Mat& image, int format,
+    float pitch, float roll, float altitude, FrameCallback callback,
+    void* userData, bool neverDrop = false );
+
+  // Waits for all queued and running frames to finish
+  void waitForFrames();
+
+  // Processes queued frames on a slot until stopped
+  void runSlot( AsyncSlot& slot );
+  static void* slotThread( void* slot );
+
+  // Starts the slot threads on first use (asyncMonitor must be held)
+  void startSlots();
+
+  // Records a frame's outcome, wakes its waiters and runs its callback
+  void finishFrame( cv::Ptr< FrameFuture::State > frame, bool dropped );
 };
 
+void*
+CoreDetector::Priv::slotThread( void* slot )
+{
+  AsyncSlot *asyncSlot = (AsyncSlot*)slot;
+  asyncSlot->owner->runSlot( *asyncSlot );
+  return NULL;
+}
+
 CoreDetector::Priv::Priv( const SystemParameters& sets )
 {
   counter = 0;
+  asyncRunning = 0;
+  asyncWindow = max( sets.NumThreads, 1 );
+  asyncPolicy = BACKPRESSURE_BLOCK;
+  asyncStopping = false;
 
   // Retrieve some contents from input
   settings = sets;
@@ -1039,12 +2470,15 @@ CoreDetector::Priv::Priv( const SystemParameters& sets )
   }
 
   // Load Statistics/Color filters
+  //  Filter banks are mapped once and shared, only adaptive state is per thread
   cout << "Loading Colour Filters... ";
   inputArgs = new AlgorithmArgs[THREADS];
+  colorModel = new hfSharedModel;
 
   for( int i=0; i < THREADS; i++ )
   {
     inputArgs[i].CC = new ColorClassifier;
+    inputArgs[i].CC->setSharedModel( colorModel, i );
     inputArgs[i].Stats = new ThreadStatistics;
 
     if( !inputArgs[i].CC->loadFilters( settings.RootColorDIR, DEFAULT_COLORBANK_EXT ) ) {
@@ -1058,7 +2492,23 @@ CoreDetector::Priv::Priv( const SystemParameters& sets )
   for( int i=0; i<THREADS; i++ )
   {
     // Set thread output options
+    inputArgs[i].ThreadID = i;
     inputArgs[i].IsTrainingMode = settings.IsTrainingMode;
+    inputArgs[i].EnableColorAdaptation = settings.EnableColorAdaptation;
+    inputArgs[i].UseComponentTreeThresholding = settings.UseComponentTreeThresholding;
+    inputArgs[i].FrameTimeBudget = settings.FrameTimeBudget;
+    inputArgs[i].FrameCandidateBudget = settings.FrameCandidateBudget;
+    inputArgs[i].MaxBlobCandidates = settings.MaxBlobCandidates;
+    inputArgs[i].MaxAdaptiveCandidates = settings.MaxAdaptiveCandidates;
+    inputArgs[i].MaxTemplateCandidates = settings.MaxTemplateCandidates;
+    inputArgs[i].MaxCannyCandidates = settings.MaxCannyCandidates;
+    inputArgs[i].EnableScreeningPass = settings.EnableScreeningPass;
+    inputArgs[i].ScreeningMaxCoverage = settings.ScreeningMaxCoverage;
+    inputArgs[i].EnableFrameGate = settings.EnableFrameGate;
+    inputArgs[i].GateParameters.MaxClippedFraction = settings.GateMaxClippedFraction;
+    inputArgs[i].GateParameters.MinContrast = settings.GateMinContrast;
+    inputArgs[i].GateParameters.MinEntropy = settings.GateMinEntropy;
+    inputArgs[i].GateParameters.MinSalientFraction = settings.GateMinSalientFraction;
     inputArgs[i].Model = classifier;
     inputArgs[i].UseGTData = settings.UseFileForTraining;
     inputArgs[i].TrainingPercentKeep = settings.TrainingPercentKeep;
@@ -1079,6 +2529,11 @@ CoreDetector::Priv::Priv( const SystemParameters& sets )
     inputArgs[i].MaxSearchRadiusPixels = settings.MaxSearchRadiusPixels;
     inputArgs[i].UseMetadata = settings.UseMetadata;
     inputArgs[i].ProcessLeftHalfOnly = settings.ProcessLeftHalfOnly;
+    inputArgs[i].InputFormat = PIXEL_FORMAT_BGR;
+    inputArgs[i].StereoBaseline = settings.StereoBaseline;
+    inputArgs[i].StereoMaxDisparity = settings.StereoMaxDisparity;
+    inputArgs[i].EnableScaleMap = settings.EnableScaleMap;
+    inputArgs[i].ScaleMapBands = settings.ScaleMapBands;
   }
 
   // Initiate display window for output
@@ -1093,12 +2548,25 @@ CoreDetector::Priv::Priv( const SystemParameters& sets )
 
 CoreDetector::Priv::~Priv()
 {
+  // Finish any queued frames, then stop the slot threads
+  {
+    MonitorLock guard( asyncMonitor );
+    asyncStopping = true;
+    asyncMonitor.notifyAll();
+  }
+
+  for( unsigned i = 0; i < asyncSlots.size(); i++ )
+  {
+    joinThread( asyncSlots[i].thread );
+  }
+
   // Deallocate algorithm inputs
   for( int i=0; i < THREADS; i++ ) {
     delete inputArgs[i].Stats;
     delete inputArgs[i].CC;
   }
 
+  delete colorModel;
   delete[] inputArgs;
 
   // Deallocate loaded classifier systems
@@ -1119,6 +2587,278 @@ CoreDetector::Priv::~Priv()
 #endif
 }
 
+std::vector< Detection >
+CoreDetector::Priv::processFrame( const cv::Mat& image, int format,
+  float pitch, float roll, float altitude )
+{
+  // Synchronous frames use every AlgorithmArgs
+  waitForFrames();
+
+  unsigned id;
+  {
+    MonitorLock guard( asyncMonitor );
+    id = ++counter;
+  }
+
+  runFrame( inputArgs, THREADS, image, format, pitch, roll, altitude, id );
+
+  {
+    MonitorLock guard( asyncMonitor );
+    lastStats = inputArgs[0].FrameStats;
+  }
+
+  return inputArgs[0].FinalDetections;
+}
+
+void
+CoreDetector::Priv::runFrame( AlgorithmArgs *args, int workers,
+  const cv::Mat& image, int format, float pitch, float roll, float altitude,
+  unsigned id )
+{
+  std::string frameID = "streaming_frame_" + INT_2_STR( id );
+
+  cv::Mat input = image;
+
+  // Incremental processing keeps each frame for the next, in BGR
+  if( settings.EnableTemporalReuse && format != PIXEL_FORMAT_BGR )
+  {
+    normalizeStereoFormat( args, format );
+    convertPixelFormat( image, format, image.size(), input );
+    format = PIXEL_FORMAT_BGR;
+  }
+  else if( settings.EnableTemporalReuse )
+  {
+    input = image.clone();
+  }
+
+  args[0].InputImage = input;
+  args[0].InputFormat = format;
+  args[0].InputFilename = frameID;
+  args[0].OutputFilename = frameID;
+  args[0].InputFilenameNoDir = frameID;
+
+  if( pitch != 0.0f || roll != 0.0f || altitude != 0.0f )
+  {
+    args[0].MetadataProvided = true;
+    args[0].Pitch = pitch;
+    args[0].Roll = roll;
+    args[0].Altitude = altitude;
+  }
+  else
+  {
+    args[0].MetadataProvided = false;
+  }
+
+  // Execute processing
+  if( settings.EnableTemporalReuse )
+  {
+    processSequentialFrame( args, temporal,
+      settings.TileSize, settings.TemporalMinOverlap );
+  }
+  else
+  {
+    processInputImage( args, settings.TileSize, workers );
+  }
+
+  // Never hold on to the caller's buffer
+  args[0].InputImage = cv::Mat();
+  args[0].InputFormat = PIXEL_FORMAT_BGR;
+
+#ifdef ENABLE_BENCHMARKING
+  // Output benchmarking results to file
+  for( unsigned int i=0; i<executionTimes.size(); i++ )
+    benchmarkingOutput << executionTimes[i] << " ";
+  benchmarkingOutput << endl;
+#endif
+}
+
+cv::Ptr< FrameFuture::State >
+CoreDetector::Priv::submitFrame( const cv::Mat& image, int format,
+  float pitch, float roll, float altitude, FrameCallback callback,
+  void* userData, bool neverDrop )
+{
+  cv::Ptr< FrameFuture::State > frame = new FrameFuture::State;
+  frame->image = image;
+  frame->format = format;
+  frame->pitch = pitch;
+  frame->roll = roll;
+  frame->altitude = altitude;
+  frame->callback = callback;
+  frame->userData = userData;
+
+  std::vector< cv::Ptr< FrameFuture::State > > dropped;
+  bool rejected = false;
+  {
+    MonitorLock guard( asyncMonitor );
+    startSlots();
+    frame->id = ++counter;
+
+    const int policy = ( neverDrop ? BACKPRESSURE_BLOCK : asyncPolicy );
+
+    while( (int)asyncQueue.size() + asyncRunning >= asyncWindow )
+    {
+      if( policy == BACKPRESSURE_DROP_OLDEST && !asyncQueue.empty() )
+      {
+        dropped.push_back( asyncQueue.front() );
+        asyncQueue.pop_front();
+      }
+      else if( policy != BACKPRESSURE_BLOCK )
+      {
+        rejected = true;
+        break;
+      }
+      else
+      {
+        asyncMonitor.wait();
+      }
+    }
+
+    if( !rejected )
+    {
+      asyncQueue.push_back( frame );
+      asyncMonitor.notifyAll();
+    }
+  }
+
+  // A shrunken window can drop several frames at once
+  for( unsigned i = 0; i < dropped.size(); i++ )
+  {
+    finishFrame( dropped[i], true );
+  }
+
+  if( rejected )
+  {
+    finishFrame( frame, true );
+  }
+
+  return frame;
+}
+
+void
+CoreDetector::Priv::startSlots()
+{
+  if( !asyncSlots.empty() )
+  {
+    return;
+  }
+
+  // Frames of a sequence depend on the last, so run them in order
+  int slots = min( asyncWindow, THREADS );
+
+#ifdef ENABLE_BENCHMARKING
+  // Benchmarking timers are global
+  slots = 1;
+#endif
+
+  if( settings.EnableTemporalReuse )
+  {
+    slots = 1;
+  }
+
+  slots = max( slots, 1 );
+
+  // Divide the per thread AlgorithmArgs between slots, so that concurrent
+  // frames never share color filters or statistics
+  asyncSlots.resize( slots );
+
+  for( int k = 0; k < slots; k++ )
+  {
+    asyncSlots[k].owner = this;
+    asyncSlots[k].first = ( k * THREADS ) / slots;
+    asyncSlots[k].count = ( ( k + 1 ) * THREADS ) / slots - asyncSlots[k].first;
+  }
+
+  for( int k = 0; k < slots; k++ )
+  {
+    if( !startThread( asyncSlots[k].thread, slotThread, &asyncSlots[k] ) )
+    {
+      asyncSlots.resize( k );
+      throw std::runtime_error( "Could not start frame processing thread" );
+    }
+  }
+}
+
+void
+CoreDetector::Priv::runSlot( AsyncSlot& slot )
+{
+  AlgorithmArgs *args = inputArgs + slot.first;
+
+  while( true )
+  {
+    cv::Ptr< FrameFuture::State > frame;
+    {
+      MonitorLock guard( asyncMonitor );
+
+      while( asyncQueue.empty() && !asyncStopping )
+      {
+        asyncMonitor.wait();
+      }
+
+      if( asyncQueue.empty() )
+      {
+        break;
+      }
+
+      frame = asyncQueue.front();
+      asyncQueue.pop_front();
+      asyncRunning++;
+    }
+
+    try
+    {
+      runFrame( args, slot.count, frame->image, frame->format,
+        frame->pitch, frame->roll, frame->altitude, frame->id );
+
+      frame->detections = args[0].FinalDetections;
+      frame->stats = args[0].FrameStats;
+    }
+    catch( const std::exception& e )
+    {
+      frame->error = e.what();
+      args[0].InputImage = cv::Mat();
+    }
+
+    // Only count the frame as finished once its waiters and callback ran
+    finishFrame( frame, false );
+
+    {
+      MonitorLock guard( asyncMonitor );
+      asyncRunning--;
+      asyncMonitor.notifyAll();
+    }
+  }
+}
+
+void
+CoreDetector::Priv::finishFrame( cv::Ptr< FrameFuture::State > frame,
+  bool dropped )
+{
+  frame->image = cv::Mat();
+  frame->wasDropped = dropped;
+
+  {
+    MonitorLock guard( frame->monitor );
+    frame->done = true;
+    frame->monitor.notifyAll();
+  }
+
+  if( frame->callback )
+  {
+    frame->callback( frame->id, dropped, frame->detections, frame->userData );
+  }
+}
+
+void
+CoreDetector::Priv::waitForFrames()
+{
+  MonitorLock guard( asyncMonitor );
+
+  while( !asyncQueue.empty() || asyncRunning > 0 )
+  {
+    asyncMonitor.wait();
+  }
+}
+
 CoreDetector::CoreDetector( const std::string& configFile )
 {
   SystemParameters settings;
@@ -1148,57 +2888,240 @@ std::vector< Detection >
 CoreDetector::processFrame( const cv::Mat& image,
  float pitch, float roll, float altitude )
 {
-  data->counter++;
-  std::string frameID = "streaming_frame_" + INT_2_STR( data->counter );
+  // Streaming frames are RGB, reordered when the image is formatted
+  return data->processFrame( image, PIXEL_FORMAT_RGB, pitch, roll, altitude );
+}
+
+std::vector< Detection >
+CoreDetector::processFrame( const unsigned char* buffer, int width,
+  int height, size_t stride, int format, float pitch, float roll,
+  float altitude )
+{
+  const int channels = pixelFormatChannels( format );
+
+  if( !buffer || width <= 0 || height <= 0 || channels == 0 ||
+      stride < (size_t)( width * channels ) )
+  {
+    throw std::runtime_error( "Invalid frame buffer" );
+  }
 
-  cv::Mat corrected;
-  cv::cvtColor( image, corrected, cv::COLOR_RGB2BGR );
+  // Header only, the buffer is read in place
+  const cv::Mat image( height, width, channels == 3 ? CV_8UC3 : CV_8UC1,
+    (void*)buffer, stride );
 
-  data->inputArgs[0].InputImage = corrected;
-  data->inputArgs[0].InputFilename = frameID;
-  data->inputArgs[0].OutputFilename = frameID;
-  data->inputArgs[0].InputFilenameNoDir = frameID;
+  return data->processFrame( image, format, pitch, roll, altitude );
+}
 
-  if( pitch != 0.0f || roll != 0.0f || altitude != 0.0f )
+void
+CoreDetector::setFrameBudget( float seconds, int candidates )
+{
+  // Submitted frames run in the same AlgorithmArgs
+  data->waitForFrames();
+
+  for( int i=0; i<THREADS; i++ )
   {
-    data->inputArgs[0].MetadataProvided = true;
-    data->inputArgs[0].Pitch = pitch;
-    data->inputArgs[0].Roll = roll;
-    data->inputArgs[0].Altitude = altitude;
+    data->inputArgs[i].FrameTimeBudget = seconds;
+    data->inputArgs[i].FrameCandidateBudget = candidates;
   }
-  else
+}
+
+FrameStatistics
+CoreDetector::lastFrameStatistics() const
+{
+  MonitorLock guard( data->asyncMonitor );
+  return data->lastStats;
+}
+
+void
+CoreDetector::setAsyncPolicy( int maxInFlight, int backpressure )
+{
+  MonitorLock guard( data->asyncMonitor );
+  data->asyncWindow = max( maxInFlight, 1 );
+  data->asyncPolicy = backpressure;
+  data->asyncMonitor.notifyAll();
+}
+
+FrameFuture
+CoreDetector::submitFrame( const cv::Mat& image, float pitch, float roll,
+  float altitude, FrameCallback callback, void* userData )
+{
+  if( image.empty() )
   {
-    data->inputArgs[0].MetadataProvided = false;
+    throw std::runtime_error( "Invalid input image" );
   }
 
-  // Execute processing
-  processImage( data->inputArgs );
+  FrameFuture future;
+  future.state = data->submitFrame( image, PIXEL_FORMAT_RGB, pitch, roll,
+    altitude, callback, userData );
+  return future;
+}
 
-#ifdef ENABLE_BENCHMARKING
-  // Output benchmarking results to file
-  for( unsigned int i=0; i<executionTimes.size(); i++ )
-    benchmarkingOutput << executionTimes[i] << " ";
-  benchmarkingOutput << endl;
-#endif
+void
+CoreDetector::waitForFrames()
+{
+  data->waitForFrames();
+}
+
+std::vector< std::vector< Detection > >
+CoreDetector::processFrames( const std::vector< cv::Mat >& images,
+  const std::vector< float >& pitch, const std::vector< float >& roll,
+  const std::vector< float >& altitude )
+{
+  const unsigned frames = images.size();
+
+  if( ( !pitch.empty() && pitch.size() != frames ) ||
+      ( !roll.empty() && roll.size() != frames ) ||
+      ( !altitude.empty() && altitude.size() != frames ) )
+  {
+    throw std::runtime_error( "Frame metadata does not match frame count" );
+  }
+
+  for( unsigned i = 0; i < frames; i++ )
+  {
+    if( images[i].empty() )
+    {
+      throw std::runtime_error( "Invalid input image" );
+    }
+  }
+
+  // Batch frames are never dropped, the window only bounds memory in use
+  std::vector< cv::Ptr< FrameFuture::State > > states( frames );
+
+  for( unsigned i = 0; i < frames; i++ )
+  {
+    states[i] = data->submitFrame( images[i], PIXEL_FORMAT_RGB,
+      pitch.empty() ? 0.0f : pitch[i], roll.empty() ? 0.0f : roll[i],
+      altitude.empty() ? 0.0f : altitude[i], NULL, NULL, true );
+  }
+
+  data->waitForFrames();
+
+  std::vector< std::vector< Detection > > output( frames );
+
+  for( unsigned i = 0; i < frames; i++ )
+  {
+    FrameFuture future;
+    future.state = states[i];
+    output[i] = future.get();
+  }
 
-   // Get output from input args
-  return data->inputArgs->FinalDetections;
+  return output;
 }
 
 std::vector< Detection >
 CoreDetector::processFrame( const cv::Mat& leftImage,
   const cv::Mat& rightImage, float pitch, float roll, float altitude )
 {
-  cv::Size leftSize = leftImage.size();
-  cv::Size rightSize = rightImage.size();
+  // Process the left image directly, with the right only used for scale.
+  // Both are in the same (RGB) order, and the right is converted to BGR
+  // wherever the left is before scale is measured.
+  data->waitForFrames();
+  data->inputArgs[0].StereoImage = rightImage;
+  data->inputArgs[0].ProcessLeftHalfOnly = false;
+
+  std::vector< Detection > output =
+    processFrame( leftImage, pitch, roll, altitude );
+
+  data->inputArgs[0].StereoImage = cv::Mat();
+  data->inputArgs[0].ProcessLeftHalfOnly = data->settings.ProcessLeftHalfOnly;
+
+  return output;
+}
+
+//------------------------------------------------------------------------------
+//                          Frame Future Definitions
+//------------------------------------------------------------------------------
+
+FrameFuture::FrameFuture()
+{
+}
+
+FrameFuture::FrameFuture( const FrameFuture& other )
+: state( other.state )
+{
+}
+
+FrameFuture&
+FrameFuture::operator=( const FrameFuture& other )
+{
+  state = other.state;
+  return *this;
+}
+
+FrameFuture::~FrameFuture()
+{
+}
+
+bool
+FrameFuture::valid() const
+{
+  return !state.empty();
+}
+
+unsigned
+FrameFuture::frameID() const
+{
+  return ( state.empty() ? 0 : state->id );
+}
+
+bool
+FrameFuture::ready() const
+{
+  if( state.empty() )
+  {
+    return true;
+  }
+
+  MonitorLock guard( state->monitor );
+  return state->done;
+}
+
+void
+FrameFuture::wait() const
+{
+  if( state.empty() )
+  {
+    return;
+  }
+
+  MonitorLock guard( state->monitor );
+
+  while( !state->done )
+  {
+    state->monitor.wait();
+  }
+}
+
+bool
+FrameFuture::dropped() const
+{
+  wait();
+  return ( state.empty() || state->wasDropped );
+}
+
+std::vector< Detection >
+FrameFuture::get() const
+{
+  wait();
 
-  Mat merged( leftSize.height, leftSize.width + rightSize.width, leftImage.depth() );
-  Mat left( merged, cv::Rect( 0, 0, leftSize.width, leftSize.height ) );
-  leftImage.copyTo( left );
-  Mat right( merged, cv::Rect( leftSize.width, 0, rightSize.width, rightSize.height ) );
-  rightImage.copyTo( right );
+  if( state.empty() )
+  {
+    return std::vector< Detection >();
+  }
+
+  if( !state->error.empty() )
+  {
+    throw std::runtime_error( state->error );
+  }
+
+  return state->detections;
+}
 
-  return processFrame( merged, pitch, roll, altitude );
+FrameStatistics
+FrameFuture::statistics() const
+{
+  wait();
+  return ( state.empty() ? FrameStatistics() : state->stats );
 }
 
 std::vector< Detection >
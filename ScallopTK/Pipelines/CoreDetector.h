@@ -25,6 +25,60 @@ namespace ScallopTK
 // also contains the main model training subroutine option.
 int runCoreDetector( const SystemParameters& settings );
 
+// What submitFrame does when its in-flight window is full
+const int BACKPRESSURE_BLOCK       = 0x00; // Wait for a frame to finish
+const int BACKPRESSURE_DROP_OLDEST = 0x01; // Drop the oldest frame not started
+const int BACKPRESSURE_DROP_NEWEST = 0x02; // Drop the frame being submitted
+
+// Called when an asynchronously submitted frame is finished or dropped, on a
+// detector thread for processed frames and on the submitting thread for
+// frames dropped by the backpressure policy. It should return quickly and
+// must not wait for submitted frames.
+typedef void (*FrameCallback)( unsigned frameID, bool dropped,
+  const std::vector< Detection >& detections, void* userData );
+
+// Handle to the result of an asynchronously submitted frame, copies refer
+// to the same frame
+class FrameFuture
+{
+public:
+
+  FrameFuture();
+  FrameFuture( const FrameFuture& other );
+  FrameFuture& operator=( const FrameFuture& other );
+  ~FrameFuture();
+
+  // Does this refer to a submitted frame?
+  bool valid() const;
+
+  // Sequence number of the frame
+  unsigned frameID() const;
+
+  // Has the frame finished or been dropped?
+  bool ready() const;
+
+  // Waits until the frame is finished or dropped
+  void wait() const;
+
+  // Waits for the frame, returning whether it was dropped unprocessed
+  bool dropped() const;
+
+  // Waits for the frame and returns its detections, none if dropped
+  //
+  // Throws runtime_error exception if processing the frame failed
+  std::vector< Detection > get() const;
+
+  // Waits for the frame and returns its work statistics
+  FrameStatistics statistics() const;
+
+  class State;
+
+private:
+
+  friend class CoreDetector;
+  mutable cv::Ptr< State > state;
+};
+
 // Streaming class definition, for use by external programs
 //
 // This function should be called if an external library wants
@@ -61,14 +115,79 @@ public:
   std::vector< Detection > processFrame( std::string filename,
     float pitch = 0.0f, float roll = 0.0f, float altitude = 0.0f  );
 
+  // Process a new frame held in an external 8 bit buffer of the given
+  // PIXEL_FORMAT_*, with rows stride bytes apart, and platform metadata
+  // if it is known (otherwise leave it all values as the defaults)
+  //
+  // The buffer is read in place, converted to BGR while it is resized for
+  // processing, and is no longer referenced once this returns
+  //
+  // Throws runtime_error exception on critical failure
+  std::vector< Detection > processFrame( const unsigned char* buffer,
+    int width, int height, size_t stride, int format, float pitch = 0.0f,
+    float roll = 0.0f, float altitude = 0.0f );
+
   // Process a new stereo frame given an image and platform metadata
   // if it is known (otherwise leave it all values as the defaults)
   //
+  // Detections are found in the left image, the rectified right image is
+  // only used to measure per pixel scale when a stereo baseline is set
+  //
   // Throws runtime_error exception on critical failure
   std::vector< Detection > processFrame( const cv::Mat& leftImage,
     const cv::Mat& rightImage, float pitch = 0.0f, float roll = 0.0f,
     float altitude = 0.0f );
 
+  // Limit the wall clock seconds or number of candidates spent on each
+  // following frame, 0 for no limit. Overrides the system settings.
+  //
+  // Candidates are processed in priority order until either runs out.
+  // Waits for any submitted frames to finish first.
+  void setFrameBudget( float seconds, int candidates = 0 );
+
+  // Work done and skipped on the last synchronously processed frame (see
+  // FrameFuture::statistics for submitted frames)
+  FrameStatistics lastFrameStatistics() const;
+
+  // Set at most how many submitted frames may be queued or in processing
+  // at once, and what happens to frames submitted beyond that (one of the
+  // BACKPRESSURE_* policies). Defaults to the thread count and blocking.
+  //
+  // Up to min( maxInFlight, threads ) frames are processed concurrently,
+  // dividing the detector's worker threads between them. This is fixed by
+  // the first submitFrame call. With temporal reuse frames run in order.
+  void setAsyncPolicy( int maxInFlight, int backpressure );
+
+  // Queue a frame (RGB, as processFrame) for processing on the detector's
+  // worker threads and return immediately, unless the in-flight window is
+  // full and the policy is to block. When DROP_OLDEST finds every frame
+  // already in processing, the submitted frame is dropped instead.
+  //
+  // The image is shared, not copied, so must not be written to until the
+  // frame is finished. The optional callback runs as each frame finishes.
+  FrameFuture submitFrame( const cv::Mat& image, float pitch = 0.0f,
+    float roll = 0.0f, float altitude = 0.0f, FrameCallback callback = NULL,
+    void* userData = NULL );
+
+  // Waits for every submitted frame to finish. Synchronous processFrame
+  // calls do this first, as the two share the detector's threads.
+  void waitForFrames();
+
+  // Process a batch of frames (RGB, as processFrame) and their platform
+  // metadata, if known (else leave the vectors empty), returning the
+  // detections of each frame in order
+  //
+  // Frames run concurrently as with submitFrame, each also processed in
+  // parallel within its share of the detector's threads, but none are
+  // ever dropped. Returns once the whole batch is finished.
+  //
+  // Throws runtime_error exception on critical failure of any frame
+  std::vector< std::vector< Detection > > processFrames(
+    const std::vector< cv::Mat >& images,
+    const std::vector< float >& pitch = std::vector< float >(),
+    const std::vector< float >& roll = std::vector< float >(),
+    const std::vector< float >& altitude = std::vector< float >() );
+
 private:
 
   // Class for storing all cross-frame required data
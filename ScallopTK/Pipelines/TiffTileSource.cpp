@@ -0,0 +1,236 @@
+
+#include "TiffTileSource.h"
+
+namespace ScallopTK
+{
+
+//------------------------------------------------------------------------------
+//                              Construction
+//------------------------------------------------------------------------------
+
+TiffTileSource* TiffTileSource::open( const std::string& filename, size_t cacheBytes ) {
+
+  TIFF* handle = TIFFOpen( filename.c_str(), "r" );
+
+  if( !handle ) {
+    return NULL;
+  }
+
+  unsigned int w = 0, h = 0, bw = 0, bh = 0;
+  unsigned short spp = 1, bps = 8, planar = PLANARCONFIG_CONTIG;
+  unsigned short photometric = PHOTOMETRIC_RGB, compression = COMPRESSION_NONE;
+
+  TIFFGetField( handle, TIFFTAG_IMAGEWIDTH, &w );
+  TIFFGetField( handle, TIFFTAG_IMAGELENGTH, &h );
+  TIFFGetFieldDefaulted( handle, TIFFTAG_SAMPLESPERPIXEL, &spp );
+  TIFFGetFieldDefaulted( handle, TIFFTAG_BITSPERSAMPLE, &bps );
+  TIFFGetFieldDefaulted( handle, TIFFTAG_PLANARCONFIG, &planar );
+  TIFFGetFieldDefaulted( handle, TIFFTAG_COMPRESSION, &compression );
+  TIFFGetField( handle, TIFFTAG_PHOTOMETRIC, &photometric );
+
+  const bool tiled = ( TIFFIsTiled( handle ) != 0 );
+
+  if( tiled ) {
+    TIFFGetField( handle, TIFFTAG_TILEWIDTH, &bw );
+    TIFFGetField( handle, TIFFTAG_TILELENGTH, &bh );
+  } else {
+    bw = w;
+    TIFFGetFieldDefaulted( handle, TIFFTAG_ROWSPERSTRIP, &bh );
+    bh = std::min( bh, h );
+  }
+
+  // Layouts which can not be assembled block by block
+  if( w == 0 || h == 0 || bw == 0 || bh == 0 ||
+      planar != PLANARCONFIG_CONTIG ||
+      ( bps != 8 && bps != 16 ) ||
+      ( spp != 1 && spp != 3 && spp != 4 ) ||
+      photometric == PHOTOMETRIC_PALETTE ) {
+    TIFFClose( handle );
+    return NULL;
+  }
+
+  TiffTileSource* source = new TiffTileSource;
+  source->filename = filename;
+  source->width = w;
+  source->height = h;
+  source->blockWidth = bw;
+  source->blockHeight = bh;
+  source->blocksAcross = ( w + bw - 1 ) / bw;
+  source->samples = spp;
+  source->bits = bps;
+  source->tiled = tiled;
+  source->jpegYCbCr = ( compression == COMPRESSION_JPEG && photometric == PHOTOMETRIC_YCBCR );
+  source->cacheBytes = 0;
+  source->cacheLimit = cacheBytes;
+
+  if( source->jpegYCbCr ) {
+    TIFFSetField( handle, TIFFTAG_JPEGCOLORMODE, JPEGCOLORMODE_RGB );
+  }
+
+  source->releaseHandle( handle );
+  return source;
+}
+
+TiffTileSource::~TiffTileSource() {
+  for( size_t i=0; i<freeHandles.size(); i++ ) {
+    TIFFClose( freeHandles[i] );
+  }
+}
+
+//------------------------------------------------------------------------------
+//                               File Handles
+//------------------------------------------------------------------------------
+
+TIFF* TiffTileSource::acquireHandle() {
+
+  {
+    cv::AutoLock lock( handleLock );
+    if( !freeHandles.empty() ) {
+      TIFF* handle = freeHandles.back();
+      freeHandles.pop_back();
+      return handle;
+    }
+  }
+
+  TIFF* handle = TIFFOpen( filename.c_str(), "r" );
+
+  // Have the codec convert JPEG compressed YCbCr data to RGB
+  if( handle && jpegYCbCr ) {
+    TIFFSetField( handle, TIFFTAG_JPEGCOLORMODE, JPEGCOLORMODE_RGB );
+  }
+  return handle;
+}
+
+void TiffTileSource::releaseHandle( TIFF* handle ) {
+  cv::AutoLock lock( handleLock );
+  freeHandles.push_back( handle );
+}
+
+//------------------------------------------------------------------------------
+//                                 Decoding
+//------------------------------------------------------------------------------
+
+cv::Rect TiffTileSource::blockBounds( int block ) const {
+  const int x = ( block % blocksAcross ) * blockWidth;
+  const int y = ( block / blocksAcross ) * blockHeight;
+  return cv::Rect( x, y, std::min( blockWidth, width - x ), std::min( blockHeight, height - y ) );
+}
+
+bool TiffTileSource::decodeBlock( TIFF* handle, int block, cv::Mat& output ) {
+
+  const cv::Rect bounds = blockBounds( block );
+  const int bytesPerSample = bits / 8;
+  const int stride = blockWidth * samples * bytesPerSample;
+
+  // Tiles decode to their full padded size, strips to their valid rows
+  std::vector< unsigned char > buffer( (size_t)stride * blockHeight );
+  tsize_t decoded = ( tiled ?
+    TIFFReadEncodedTile( handle, block, &buffer[0], buffer.size() ) :
+    TIFFReadEncodedStrip( handle, block / blocksAcross, &buffer[0], buffer.size() ) );
+
+  if( decoded < 0 ) {
+    return false;
+  }
+
+  output.create( bounds.height, bounds.width, CV_8UC3 );
+
+  for( int r=0; r<bounds.height; r++ ) {
+    const unsigned char* src = &buffer[0] + (size_t)stride * r;
+    unsigned char* dst = output.ptr<unsigned char>( r );
+
+    for( int c=0; c<bounds.width; c++, dst += 3 ) {
+      unsigned char value[3];
+      for( int s=0; s<3; s++ ) {
+        const int index = ( samples == 1 ? 0 : s ) + c * samples;
+        value[s] = ( bytesPerSample == 1 ? src[index] :
+          (unsigned char)( ((const unsigned short*)src)[index] >> 8 ) );
+      }
+      dst[0] = value[2];
+      dst[1] = value[1];
+      dst[2] = value[0];
+    }
+  }
+  return true;
+}
+
+bool TiffTileSource::getBlock( int block, cv::Mat& output ) {
+
+  {
+    cv::AutoLock lock( cacheLock );
+    std::map< int, BlockList::iterator >::iterator itr = cacheIndex.find( block );
+    if( itr != cacheIndex.end() ) {
+      cache.splice( cache.begin(), cache, itr->second );
+      output = itr->second->second;
+      return true;
+    }
+  }
+
+  TIFF* handle = acquireHandle();
+
+  if( !handle ) {
+    return false;
+  }
+
+  const bool success = decodeBlock( handle, block, output );
+  releaseHandle( handle );
+
+  if( !success ) {
+    return false;
+  }
+
+  // Another reader may have decoded the same block in the meantime
+  cv::AutoLock lock( cacheLock );
+  if( cacheIndex.find( block ) == cacheIndex.end() ) {
+    cache.push_front( std::make_pair( block, output ) );
+    cacheIndex[block] = cache.begin();
+    cacheBytes += output.total() * output.elemSize();
+
+    while( cacheBytes > cacheLimit && cache.size() > 1 ) {
+      const cv::Mat& oldest = cache.back().second;
+      cacheBytes -= oldest.total() * oldest.elemSize();
+      cacheIndex.erase( cache.back().first );
+      cache.pop_back();
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//                              Region Reading
+//------------------------------------------------------------------------------
+
+bool TiffTileSource::readRegion( const cv::Rect& region, cv::Mat& output ) {
+
+  if( region.x < 0 || region.y < 0 || region.width <= 0 || region.height <= 0 ||
+      region.x + region.width > width || region.y + region.height > height ) {
+    return false;
+  }
+
+  output.create( region.height, region.width, CV_8UC3 );
+
+  const int firstRow = region.y / blockHeight;
+  const int lastRow = ( region.y + region.height - 1 ) / blockHeight;
+  const int firstCol = ( tiled ? region.x / blockWidth : 0 );
+  const int lastCol = ( tiled ? ( region.x + region.width - 1 ) / blockWidth : 0 );
+
+  for( int br=firstRow; br<=lastRow; br++ ) {
+    for( int bc=firstCol; bc<=lastCol; bc++ ) {
+
+      const int block = br * blocksAcross + bc;
+      cv::Mat pixels;
+
+      if( !getBlock( block, pixels ) ) {
+        return false;
+      }
+
+      // Copy the overlap of the block and the region
+      const cv::Rect bounds = blockBounds( block );
+      const cv::Rect overlap = bounds & region;
+      cv::Mat target = output( overlap - region.tl() );
+      pixels( overlap - bounds.tl() ).copyTo( target );
+    }
+  }
+  return true;
+}
+
+}
@@ -0,0 +1,100 @@
+#ifndef SCALLOP_TK_TIFF_TILE_SOURCE_H_
+#define SCALLOP_TK_TIFF_TILE_SOURCE_H_
+
+//------------------------------------------------------------------------------
+//                               Include Files
+//------------------------------------------------------------------------------
+
+//Standard C/C++
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+
+//Opencv
+#include <cv.h>
+#include <cxcore.h>
+
+//LibTIFF
+#include <tiffio.h>
+
+//Scallop Includes
+#include "ScallopTK/Pipelines/TileSource.h"
+
+namespace ScallopTK
+{
+
+//------------------------------------------------------------------------------
+//                                 Constants
+//------------------------------------------------------------------------------
+
+// Default memory allowed for decoded TIFF tiles or strips
+const size_t DEFAULT_TIFF_CACHE_BYTES = 128 * 1024 * 1024;
+
+//------------------------------------------------------------------------------
+//                              Class Definitions
+//------------------------------------------------------------------------------
+
+// Streaming reader for tiled or stripped TIFF and BigTIFF mosaics
+//
+// Regions are assembled from only the TIFF tiles (or strips) they overlap,
+// which are decoded on demand. Every concurrent reader decodes with its own
+// file handle, so the tile workers double as the decoding pool, and recently
+// decoded blocks are kept in a bounded cache for neighbouring regions.
+// Supports 8 or 16 bit, 1, 3 or 4 sample, contiguous images.
+class TiffTileSource : public TileSource
+{
+public:
+
+  ~TiffTileSource();
+
+  // Opens a mosaic, returning NULL if it can not be streamed
+  static TiffTileSource* open( const std::string& filename,
+    size_t cacheBytes = DEFAULT_TIFF_CACHE_BYTES );
+
+  cv::Size size() const { return cv::Size( width, height ); }
+  bool readRegion( const cv::Rect& region, cv::Mat& output );
+
+private:
+
+  TiffTileSource() {}
+
+  // Handles are not thread safe, so each reader borrows its own
+  TIFF* acquireHandle();
+  void releaseHandle( TIFF* handle );
+
+  // Pixel bounds of a block (TIFF tile or strip)
+  cv::Rect blockBounds( int block ) const;
+
+  // Returns a decoded block as 8-bit BGR, from the cache if possible
+  bool getBlock( int block, cv::Mat& output );
+  bool decodeBlock( TIFF* handle, int block, cv::Mat& output );
+
+  // Image layout
+  std::string filename;
+  int width;
+  int height;
+  int blockWidth;
+  int blockHeight;
+  int blocksAcross;
+  int samples;
+  int bits;
+  bool tiled;
+  bool jpegYCbCr;
+
+  // Open file handles not currently in use
+  std::vector< TIFF* > freeHandles;
+  cv::Mutex handleLock;
+
+  // Least recently used cache of decoded blocks, most recent first
+  typedef std::list< std::pair< int, cv::Mat > > BlockList;
+  BlockList cache;
+  std::map< int, BlockList::iterator > cacheIndex;
+  size_t cacheBytes;
+  size_t cacheLimit;
+  cv::Mutex cacheLock;
+};
+
+}
+
+#endif
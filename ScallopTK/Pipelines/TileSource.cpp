@@ -0,0 +1,80 @@
+
+#include "TileSource.h"
+
+namespace ScallopTK
+{
+
+//------------------------------------------------------------------------------
+//                            Function Definitions
+//------------------------------------------------------------------------------
+
+bool MatTileSource::readRegion( const cv::Rect& region, cv::Mat& output ) {
+
+  if( region.x < 0 || region.y < 0 ||
+      region.x + region.width > image.cols ||
+      region.y + region.height > image.rows ) {
+    return false;
+  }
+
+  output = image( region );
+  return true;
+}
+
+// Start of the i-th of count even splits of length
+static int splitStart( int length, int count, int i ) {
+  return (int)( ( (long long)length * i ) / count );
+}
+
+void computeMosaicTiles( cv::Size mosaic, int coreSize, int margin,
+  std::vector< MosaicTile >& tiles ) {
+
+  tiles.clear();
+
+  if( mosaic.width <= 0 || mosaic.height <= 0 || coreSize <= 0 ) {
+    return;
+  }
+
+  const int rows = ( mosaic.height + coreSize - 1 ) / coreSize;
+  const int cols = ( mosaic.width + coreSize - 1 ) / coreSize;
+
+  for( int i=0; i<rows; i++ ) {
+    for( int j=0; j<cols; j++ ) {
+
+      MosaicTile tile;
+      int top = splitStart( mosaic.height, rows, i );
+      int bottom = splitStart( mosaic.height, rows, i+1 );
+      int left = splitStart( mosaic.width, cols, j );
+      int right = splitStart( mosaic.width, cols, j+1 );
+      tile.core = cv::Rect( left, top, right - left, bottom - top );
+
+      top = std::max( top - margin, 0 );
+      bottom = std::min( bottom + margin, mosaic.height );
+      left = std::max( left - margin, 0 );
+      right = std::min( right + margin, mosaic.width );
+      tile.region = cv::Rect( left, top, right - left, bottom - top );
+
+      tiles.push_back( tile );
+    }
+  }
+}
+
+void mergeRegions( std::vector< cv::Rect >& regions ) {
+
+  bool merged = true;
+
+  while( merged ) {
+    merged = false;
+    for( size_t i=0; i<regions.size() && !merged; i++ ) {
+      for( size_t j=i+1; j<regions.size(); j++ ) {
+        if( ( regions[i] & regions[j] ).area() > 0 ) {
+          regions[i] = regions[i] | regions[j];
+          regions.erase( regions.begin() + j );
+          merged = true;
+          break;
+        }
+      }
+    }
+  }
+}
+
+}
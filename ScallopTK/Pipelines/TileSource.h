@@ -0,0 +1,81 @@
+#ifndef SCALLOP_TK_TILE_SOURCE_H_
+#define SCALLOP_TK_TILE_SOURCE_H_
+
+//------------------------------------------------------------------------------
+//                               Include Files
+//------------------------------------------------------------------------------
+
+//Standard C/C++
+#include <vector>
+
+//Opencv
+#include <cv.h>
+#include <cxcore.h>
+
+namespace ScallopTK
+{
+
+//------------------------------------------------------------------------------
+//                              Class Definitions
+//------------------------------------------------------------------------------
+
+// A single tile of a large mosaic
+struct MosaicTile
+{
+  // Pixels read and processed for the tile, core plus margin
+  cv::Rect region;
+
+  // Detections centered in here belong to this tile
+  cv::Rect core;
+};
+
+// Provider of mosaic pixels, read one region at a time so that the whole
+// mosaic never has to be decoded at once
+class TileSource
+{
+public:
+
+  TileSource() {}
+  virtual ~TileSource() {}
+
+  // Full mosaic size in pixels
+  virtual cv::Size size() const = 0;
+
+  // Reads a region of the mosaic as an 8-bit, 3 channel BGR image
+  //
+  // Called concurrently by the tile workers
+  virtual bool readRegion( const cv::Rect& region, cv::Mat& output ) = 0;
+};
+
+// Mosaic which is already fully in memory, regions are views into it
+class MatTileSource : public TileSource
+{
+public:
+
+  explicit MatTileSource( const cv::Mat& image ) : image( image ) {}
+  ~MatTileSource() {}
+
+  cv::Size size() const { return image.size(); }
+  bool readRegion( const cv::Rect& region, cv::Mat& output );
+
+private:
+
+  cv::Mat image;
+};
+
+//------------------------------------------------------------------------------
+//                             Function Prototypes
+//------------------------------------------------------------------------------
+
+// Splits a mosaic into a grid of evenly sized tile cores of at most coreSize
+// pixels, each read with margin extra pixels on every side where possible
+void computeMosaicTiles( cv::Size mosaic, int coreSize, int margin,
+  std::vector< MosaicTile >& tiles );
+
+// Replaces overlapping regions with their bounding boxes, repeatedly, until
+// no two regions overlap
+void mergeRegions( std::vector< cv::Rect >& regions );
+
+}
+
+#endif
@@ -0,0 +1,141 @@
+
+#include "FootprintIndex.h"
+
+#include "ScallopTK/TPL/Homography/ScottCamera.h"
+
+namespace ScallopTK
+{
+
+//------------------------------------------------------------------------------
+//                              Footprint Index
+//------------------------------------------------------------------------------
+
+// Axis aligned bounds of a footprint
+static void footprintBounds( const Footprint& footprint, float& lowX, float& lowY,
+  float& highX, float& highY ) {
+
+  lowX = highX = footprint[0].x;
+  lowY = highY = footprint[0].y;
+
+  for( unsigned i=1; i<footprint.size(); i++ ) {
+    lowX = min( lowX, footprint[i].x );
+    highX = max( highX, footprint[i].x );
+    lowY = min( lowY, footprint[i].y );
+    highY = max( highY, footprint[i].y );
+  }
+}
+
+void FootprintIndex::cellRange( const Footprint& footprint, int& minX, int& minY,
+  int& maxX, int& maxY ) const {
+
+  float lowX, lowY, highX, highY;
+  footprintBounds( footprint, lowX, lowY, highX, highY );
+
+  minX = (int)floor( lowX / cellSize );
+  maxX = (int)floor( highX / cellSize );
+  minY = (int)floor( lowY / cellSize );
+  maxY = (int)floor( highY / cellSize );
+}
+
+void FootprintIndex::insert( const Footprint& footprint ) {
+
+  if( footprint.empty() ) {
+    return;
+  }
+
+  // Cells are sized from the first footprint, about one per image
+  if( cellSize <= 0.0f ) {
+    float lowX, lowY, highX, highY;
+    footprintBounds( footprint, lowX, lowY, highX, highY );
+    cellSize = max( max( highX - lowX, highY - lowY ), 1e-3f );
+  }
+
+  const int id = footprints.size();
+  footprints.push_back( footprint );
+
+  int minX, minY, maxX, maxY;
+  cellRange( footprint, minX, minY, maxX, maxY );
+
+  for( int i=minX; i<=maxX; i++ ) {
+    for( int j=minY; j<=maxY; j++ ) {
+      cells[ make_pair( i, j ) ].push_back( id );
+    }
+  }
+}
+
+void FootprintIndex::query( const Footprint& footprint, vector< int >& ids ) const {
+
+  ids.clear();
+
+  if( footprint.empty() || footprints.empty() ) {
+    return;
+  }
+
+  int minX, minY, maxX, maxY;
+  cellRange( footprint, minX, minY, maxX, maxY );
+
+  for( int i=minX; i<=maxX; i++ ) {
+    for( int j=minY; j<=maxY; j++ ) {
+      map< pair< int, int >, vector< int > >::const_iterator cell =
+        cells.find( make_pair( i, j ) );
+      if( cell != cells.end() ) {
+        ids.insert( ids.end(), cell->second.begin(), cell->second.end() );
+      }
+    }
+  }
+
+  // Footprints spanning several cells are found more than once
+  sort( ids.begin(), ids.end() );
+  ids.erase( unique( ids.begin(), ids.end() ), ids.end() );
+}
+
+//------------------------------------------------------------------------------
+//                            Function Definitions
+//------------------------------------------------------------------------------
+
+void computeFootprint( float x, float y, float heading, float pitch,
+  float roll, float altitude, float focalLength, int cols, int rows,
+  Footprint& footprint ) {
+
+  float corners[4][2];
+  calculateFootprint( heading, pitch, roll, altitude, (float)cols,
+    (float)rows, focalLength, corners );
+
+  footprint.resize( 4 );
+  for( int i=0; i<4; i++ ) {
+    footprint[i] = cv::Point2f( x + corners[i][0], y + corners[i][1] );
+  }
+}
+
+void computeCoverageMask( const FootprintIndex& index, const Footprint& footprint,
+  cv::Size imageSize, cv::Mat& mask ) {
+
+  const int width = min( FOOTPRINT_MASK_WIDTH, imageSize.width );
+  const int height = max( ( width * imageSize.height ) / imageSize.width, 1 );
+  mask = cv::Mat::zeros( height, width, CV_8U );
+
+  vector< int > ids;
+  index.query( footprint, ids );
+
+  if( ids.empty() || footprint.size() != 4 ) {
+    return;
+  }
+
+  // Seafloor to mask homography from the image's own footprint
+  cv::Point2f maskCorners[4] = { cv::Point2f( 0, 0 ), cv::Point2f( width, 0 ),
+    cv::Point2f( width, height ), cv::Point2f( 0, height ) };
+  cv::Mat toMask = cv::getPerspectiveTransform( &footprint[0], maskCorners );
+
+  for( unsigned i=0; i<ids.size(); i++ ) {
+    Footprint projected;
+    cv::perspectiveTransform( index.footprint( ids[i] ), projected, toMask );
+
+    vector< cv::Point > polygon( projected.size() );
+    for( unsigned j=0; j<projected.size(); j++ ) {
+      polygon[j] = cv::Point( cvRound( projected[j].x ), cvRound( projected[j].y ) );
+    }
+    cv::fillConvexPoly( mask, &polygon[0], polygon.size(), cv::Scalar( 255 ) );
+  }
+}
+
+}
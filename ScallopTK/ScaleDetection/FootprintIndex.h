@@ -0,0 +1,90 @@
+#ifndef SCALLOP_TK_FOOTPRINT_INDEX_H_
+#define SCALLOP_TK_FOOTPRINT_INDEX_H_
+
+//------------------------------------------------------------------------------
+//                               Include Files
+//------------------------------------------------------------------------------
+
+//Standard C/C++
+#include <math.h>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+//Opencv
+#include <cv.h>
+#include <cxcore.h>
+
+namespace ScallopTK
+{
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+//                                 Constants
+//------------------------------------------------------------------------------
+
+// Width of the masks image coverage is rasterized into
+const int FOOTPRINT_MASK_WIDTH = 128;
+
+//------------------------------------------------------------------------------
+//                              Class Definitions
+//------------------------------------------------------------------------------
+
+// Seafloor footprint of an image, its corners in pixel order (top left, top
+// right, bottom right, bottom left) in meters in the navigation frame
+typedef vector< cv::Point2f > Footprint;
+
+// Incremental spatial index of the footprints of processed images
+//
+// Footprints are bucketed into a uniform grid whose cells are the size of
+// the first footprint inserted, so lookups only visit nearby footprints.
+class FootprintIndex
+{
+public:
+
+  FootprintIndex() : cellSize( 0.0f ) {}
+  ~FootprintIndex() {}
+
+  // Adds a footprint to the index
+  void insert( const Footprint& footprint );
+
+  // Footprints whose bounding box may intersect the given footprint's
+  void query( const Footprint& footprint, vector< int >& ids ) const;
+
+  // Access a stored footprint
+  const Footprint& footprint( int id ) const { return footprints[id]; }
+
+  // Number of footprints stored
+  unsigned size() const { return footprints.size(); }
+
+private:
+
+  // Grid cell range covered by a footprint's bounding box
+  void cellRange( const Footprint& footprint, int& minX, int& minY,
+    int& maxX, int& maxY ) const;
+
+  float cellSize;
+  map< pair< int, int >, vector< int > > cells;
+  vector< Footprint > footprints;
+};
+
+//------------------------------------------------------------------------------
+//                             Function Prototypes
+//------------------------------------------------------------------------------
+
+// Footprint of a cols by rows image taken at position (x, y) in meters with
+// the given attitude, using the camera model of calculateDimensions
+void computeFootprint( float x, float y, float heading, float pitch,
+  float roll, float altitude, float focalLength, int cols, int rows,
+  Footprint& footprint );
+
+// Rasterizes the parts of an image already covered by indexed footprints
+// into an 8u mask FOOTPRINT_MASK_WIDTH wide (255 where covered), mapping
+// the seafloor into the image through the homography of its footprint
+void computeCoverageMask( const FootprintIndex& index, const Footprint& footprint,
+  cv::Size imageSize, cv::Mat& mask );
+
+}
+
+#endif
@@ -17,6 +17,7 @@ namespace ScallopTK
 void ImageProperties::calculateImageProperties( const std::string& fn,
   const int& cols, const int& rows, const float& focalLength ) {
   filename = fn;
+  pixelSizeMap.release();
   imgRows = rows;
   imgCols = cols;
   imageType = getImageType();
@@ -29,6 +30,7 @@ void ImageProperties::calculateImageProperties( const int& cols,
   const int& rows, const float& metaaltitude, const float& metapitch,
   const float& metaroll, const float& focal, float metaheading )
 {
+  pixelSizeMap.release();
   imgRows = rows;
   imgCols = cols;
   heading = metaheading;
@@ -53,6 +55,7 @@ void ImageProperties::calculateImageProperties( const int& cols,
 void ImageProperties::calculateImageProperties( const int& cols, const int& rows ) {
 
   // Set basic properties
+  pixelSizeMap.release();
   imgRows = rows;
   imgCols = cols;
   isValid = false;
@@ -64,6 +67,111 @@ void ImageProperties::calculateImageProperties( const int& cols, const int& rows
   estArea = avgHeight * avgWidth;
   pixelHeight = avgPixelSize;
   pixelWidth = avgPixelSize;
+  minPixelSize = avgPixelSize;
+  maxPixelSize = avgPixelSize;
+}
+
+// Use measured pixel sizes, summarized by their median and 5-95% range
+bool ImageProperties::setPixelSizeMap( const cv::Mat& sizes ) {
+
+  if( sizes.empty() || sizes.type() != CV_32FC1 )
+    return false;
+
+  vector<float> known;
+  known.reserve( sizes.rows * sizes.cols );
+  for( int r = 0; r < sizes.rows; r++ ) {
+    const float *ptr = sizes.ptr<float>( r );
+    for( int c = 0; c < sizes.cols; c++ ) {
+      if( ptr[c] > 0.0f )
+        known.push_back( ptr[c] );
+    }
+  }
+
+  if( known.size() < MIN_KNOWN_PIXEL_SIZE_FRACTION * sizes.rows * sizes.cols )
+    return false;
+
+  const int n = known.size();
+  nth_element( known.begin(), known.begin() + n/2, known.end() );
+  avgPixelSize = known[n/2];
+  nth_element( known.begin(), known.begin() + n/20, known.end() );
+  minPixelSize = known[n/20];
+  nth_element( known.begin(), known.begin() + (19*n)/20, known.end() );
+  maxPixelSize = known[(19*n)/20];
+
+  pixelHeight = avgPixelSize;
+  pixelWidth = avgPixelSize;
+  avgHeight = avgPixelSize * imgRows;
+  avgWidth = avgPixelSize * imgCols;
+  estArea = avgHeight * avgWidth;
+  pixelSizeMap = sizes;
+  isValid = true;
+  return true;
+}
+
+// Ground sizes of pixels from the homography between the image and its
+// seafloor footprint, the area scale of which at (u,v) is det(H) / w^3
+bool ImageProperties::calculatePixelSizeMap() {
+
+  if( !isValid )
+    return false;
+
+  float corners[4][2];
+  calculateFootprint( 0.0f, pitch, roll, altitude, (float)imgCols,
+    (float)imgRows, focalLength, corners );
+
+  cv::Point2f image[4] = { cv::Point2f( 0, 0 ), cv::Point2f( imgCols, 0 ),
+    cv::Point2f( imgCols, imgRows ), cv::Point2f( 0, imgRows ) };
+  cv::Point2f ground[4];
+  for( int i = 0; i < 4; i++ )
+    ground[i] = cv::Point2f( corners[i][0], corners[i][1] );
+
+  cv::Mat H = cv::getPerspectiveTransform( image, ground );
+  const double det = cv::determinant( H );
+
+  const int mapCols = min( PIXEL_SIZE_MAP_WIDTH, imgCols );
+  const int mapRows = max( ( mapCols * imgRows ) / imgCols, 1 );
+  cv::Mat sizes( mapRows, mapCols, CV_32F );
+
+  for( int r = 0; r < mapRows; r++ ) {
+    float *ptr = sizes.ptr<float>( r );
+    const double v = ( r + 0.5 ) * imgRows / mapRows;
+    for( int c = 0; c < mapCols; c++ ) {
+      const double u = ( c + 0.5 ) * imgCols / mapCols;
+      const double w = H.at<double>( 2, 0 ) * u + H.at<double>( 2, 1 ) * v + H.at<double>( 2, 2 );
+      const double size = sqrt( fabs( det / ( w * w * w ) ) );
+      ptr[c] = ( size > 0.0 && size < FLT_MAX ? (float)size : 0.0f );
+    }
+  }
+
+  return setPixelSizeMap( sizes );
+}
+
+void ImageProperties::getPixelSizeMap( const cv::Rect& region, cv::Mat& sizes ) {
+  int mapRows = 1, mapCols = 1;
+  if( !pixelSizeMap.empty() ) {
+    mapRows = max( ( pixelSizeMap.rows * region.height ) / imgRows, 1 );
+    mapCols = max( ( pixelSizeMap.cols * region.width ) / imgCols, 1 );
+  }
+  sizes.create( mapRows, mapCols, CV_32F );
+  for( int r = 0; r < mapRows; r++ ) {
+    float *ptr = sizes.ptr<float>( r );
+    const float ir = region.y + ( r + 0.5f ) * region.height / mapRows;
+    for( int c = 0; c < mapCols; c++ ) {
+      const float ic = region.x + ( c + 0.5f ) * region.width / mapCols;
+      ptr[c] = getPixelSizeMeters( ir, ic );
+    }
+  }
+}
+
+float ImageProperties::getPixelSizeMeters( const float& r, const float& c ) {
+  if( pixelSizeMap.empty() )
+    return avgPixelSize;
+  int mr = (int)( r * pixelSizeMap.rows / imgRows );
+  int mc = (int)( c * pixelSizeMap.cols / imgCols );
+  mr = min( max( mr, 0 ), pixelSizeMap.rows - 1 );
+  mc = min( max( mc, 0 ), pixelSizeMap.cols - 1 );
+  float size = pixelSizeMap.at<float>( mr, mc );
+  return ( size > 0.0f ? size : avgPixelSize );
 }
 
 //Returns the type of the image (only identified via extension, not contents)
@@ -94,6 +202,8 @@ void ImageProperties::calculateProperties() {
   pixelHeight = avgHeight / (float)imgRows;
   pixelWidth = avgWidth / (float)imgCols;
   avgPixelSize = ( pixelHeight + pixelWidth ) / 2;
+  minPixelSize = avgPixelSize;
+  maxPixelSize = avgPixelSize;
 }
 
 // Load metadata from the specified file
@@ -7,10 +7,18 @@
 //------------------------------------------------------------------------------
 
 //Standard C/C++
+#include <math.h>
+#include <float.h>
 #include <iostream>
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <vector>
+#include <algorithm>
+
+//Opencv
+#include <cv.h>
+#include <cxcore.h>
 
 //Scallop Includes
 #include "ScallopTK/Utilities/Definitions.h"
@@ -42,6 +50,15 @@ public:
   // Generate fake metadata, assuming 1 meter per pixel scale
   void calculateImageProperties( const int& cols, const int& rows );
 
+  // Replaces the scale with measured per pixel sizes (i.e. from stereo), a
+  // 32f map of meters per image pixel covering the whole image at any
+  // resolution, 0 where unknown. Fails if too little of the map is known.
+  bool setPixelSizeMap( const cv::Mat& sizes );
+
+  // Replaces the scale with per pixel sizes derived from the camera model,
+  // which vary across pitched or rolled images. Requires metadata.
+  bool calculatePixelSizeMap();
+
   // Destructor
   ~ImageProperties() {}
 
@@ -50,6 +67,17 @@ public:
   float getImgHeightMeters() { return avgHeight; }
   float getImgWidthMeters() { return avgWidth; }
   float getAvgPixelSizeMeters() { return avgPixelSize; }
+  float getMinPixelSizeMeters() { return minPixelSize; }
+  float getMaxPixelSizeMeters() { return maxPixelSize; }
+
+  // Pixel size at image location (r,c), the average where not measured
+  float getPixelSizeMeters( const float& r, const float& c );
+
+  // Pixel sizes over a region of the image, at the measured resolution
+  void getPixelSizeMap( const cv::Rect& region, cv::Mat& sizes );
+
+  // Is the scale measured per pixel?
+  bool hasPixelSizeMap() { return !pixelSizeMap.empty(); }
 
 private:
 
@@ -82,6 +110,11 @@ private:
   float pixelHeight;
   float pixelWidth;
   float avgPixelSize;
+  float minPixelSize;
+  float maxPixelSize;
+
+  // Measured per pixel sizes, if any
+  cv::Mat pixelSizeMap;
 };
 
 }
@@ -8,13 +8,216 @@ using namespace std;
 namespace ScallopTK
 {
 
+//------------------------------------------------------------------------------
+//                              Block Matching
+//------------------------------------------------------------------------------
+
+// Matches bands of rows independently, each with enough rows of context
+// above and below for the matching block
+class BlockMatchBody : public cv::ParallelLoopBody
+{
+public:
+
+  BlockMatchBody( const cv::Mat& left, const cv::Mat& right, int disparities,
+    int bands, cv::Mat& output )
+  : left( left ), right( right ), disparities( disparities ),
+    bands( bands ), output( output )
+  {}
+
+  void operator()( const cv::Range& range ) const
+  {
+    const int rows = left.rows;
+    const int cols = left.cols;
+    const int half = STEREO_BLOCK_SIZE / 2;
+    const cv::Size block( STEREO_BLOCK_SIZE, STEREO_BLOCK_SIZE );
+
+    for( int b = range.start; b < range.end; b++ )
+    {
+      const int r0 = ( b * rows ) / bands;
+      const int r1 = ( ( b + 1 ) * rows ) / bands;
+      const int p0 = max( r0 - half, 0 );
+      const int p1 = min( r1 + half, rows );
+      const int offset = r0 - p0;
+      const int pixels = ( r1 - r0 ) * cols;
+
+      cv::Mat L = left.rowRange( p0, p1 );
+      cv::Mat R = right.rowRange( p0, p1 );
+
+      // Blocks without horizontal texture cannot be matched reliably
+      cv::Mat gradient, texture;
+      cv::Sobel( L, gradient, CV_32F, 1, 0 );
+      gradient = cv::abs( gradient );
+      cv::boxFilter( gradient, texture, CV_32F, block );
+
+      // Winner takes all over the aggregated costs, keeping the costs
+      // either side of the best disparity for sub-pixel refinement
+      vector< float > bestCost( pixels, FLT_MAX );
+      vector< float > lastCost( pixels, FLT_MAX );
+      vector< float > belowBest( pixels, FLT_MAX );
+      vector< float > aboveBest( pixels, FLT_MAX );
+      vector< int > bestDisparity( pixels, 0 );
+
+      cv::Mat difference( L.size(), CV_32F ), cost;
+
+      for( int d = 0; d < disparities; d++ )
+      {
+        cv::Mat unmatched = difference.colRange( 0, d );
+        unmatched.setTo( cv::Scalar( STEREO_NO_MATCH_COST ) );
+        cv::Mat matched = difference.colRange( d, cols );
+        cv::absdiff( L.colRange( d, cols ), R.colRange( 0, cols - d ), matched );
+        cv::boxFilter( difference, cost, CV_32F, block );
+
+        for( int i = 0; i < r1 - r0; i++ )
+        {
+          const float *costRow = cost.ptr<float>( i + offset );
+
+          for( int j = 0, k = i * cols; j < cols; j++, k++ )
+          {
+            const float c = costRow[j];
+
+            if( c < bestCost[k] )
+            {
+              belowBest[k] = lastCost[k];
+              aboveBest[k] = FLT_MAX;
+              bestCost[k] = c;
+              bestDisparity[k] = d;
+            }
+            else if( bestDisparity[k] == d - 1 )
+            {
+              aboveBest[k] = c;
+            }
+
+            lastCost[k] = c;
+          }
+        }
+      }
+
+      for( int i = 0; i < r1 - r0; i++ )
+      {
+        const float *textureRow = texture.ptr<float>( i + offset );
+        float *outputRow = output.ptr<float>( r0 + i );
+
+        for( int j = 0, k = i * cols; j < cols; j++, k++ )
+        {
+          const int d = bestDisparity[k];
+
+          if( d == 0 || d >= j || textureRow[j] < STEREO_MIN_TEXTURE )
+          {
+            outputRow[j] = 0.0f;
+            continue;
+          }
+
+          // Parabola through the costs around the best disparity
+          float refined = d;
+          if( d < disparities - 1 && aboveBest[k] != FLT_MAX )
+          {
+            const float denom = belowBest[k] - 2.0f * bestCost[k] + aboveBest[k];
+            if( denom > 0.0f )
+            {
+              refined += ( belowBest[k] - aboveBest[k] ) / ( 2.0f * denom );
+            }
+          }
+          outputRow[j] = refined;
+        }
+      }
+    }
+  }
+
+private:
+
+  const cv::Mat& left;
+  const cv::Mat& right;
+  int disparities;
+  int bands;
+  cv::Mat& output;
+};
+
+// Grey 32f copy of an image at the given scale
+static void prepareStereoImage( const cv::Mat& input, float scale, cv::Mat& output )
+{
+  cv::Mat resized, grey;
+
+  if( scale < 1.0f )
+  {
+    cv::resize( input, resized, cv::Size( max( (int)( scale * input.cols ), 1 ),
+      max( (int)( scale * input.rows ), 1 ) ), 0, 0, cv::INTER_AREA );
+  }
+  else
+  {
+    resized = input;
+  }
+
+  if( resized.channels() == 3 )
+  {
+    cv::cvtColor( resized, grey, CV_BGR2GRAY );
+  }
+  else
+  {
+    grey = resized;
+  }
+
+  grey.convertTo( output, CV_32F, grey.depth() == CV_16U ? 1.0/257.0 : 1.0 );
+}
+
 //------------------------------------------------------------------------------
 //                            Function Definitions
 //------------------------------------------------------------------------------
 
-void computeDepthMap( cv::Mat& leftImg, cv::Mat& rightImg, cv::Mat& depthMap )
+void computeDisparityMap( const cv::Mat& leftImg, const cv::Mat& rightImg,
+  float scale, int maxDisparity, cv::Mat& disparity )
+{
+  scale = min( max( scale, 1e-3f ), 1.0f );
+
+  cv::Mat left, right;
+  prepareStereoImage( leftImg, scale, left );
+  prepareStereoImage( rightImg, scale, right );
+
+  disparity = cv::Mat::zeros( left.size(), CV_32F );
+
+  int disparities = min( (int)ceil( maxDisparity * scale ) + 1, left.cols );
+
+  if( disparities < 2 || left.size() != right.size() )
+  {
+    return;
+  }
+
+  const int bands = max( left.rows / STEREO_BAND_ROWS, 1 );
+
+  cv::parallel_for_( cv::Range( 0, bands ),
+    BlockMatchBody( left, right, disparities, bands, disparity ) );
+
+  // Remove isolated mismatches
+  cv::medianBlur( disparity, disparity, 5 );
+}
+
+void computePixelSizeMap( const cv::Mat& disparity, float scale,
+  float baseline, cv::Mat& pixelSize )
+{
+  pixelSize.create( disparity.size(), CV_32F );
+
+  // A full resolution pixel spans baseline / full resolution disparity meters
+  for( int r = 0; r < disparity.rows; r++ )
+  {
+    const float *input = disparity.ptr<float>( r );
+    float *output = pixelSize.ptr<float>( r );
+
+    for( int c = 0; c < disparity.cols; c++ )
+    {
+      output[c] = ( input[c] > 0.0f ? baseline * scale / input[c] : 0.0f );
+    }
+  }
+}
+
+void computeDepthMap( const cv::Mat& leftImg, const cv::Mat& rightImg,
+  float baseline, float focalPixels, float scale, int maxDisparity,
+  cv::Mat& depthMap )
 {
+  cv::Mat disparity;
+  computeDisparityMap( leftImg, rightImg, scale, maxDisparity, disparity );
 
+  // Depth is focal length times the size of a pixel there
+  computePixelSizeMap( disparity, scale, baseline, depthMap );
+  depthMap *= focalPixels;
 }
 
 }
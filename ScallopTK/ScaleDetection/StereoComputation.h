@@ -1,4 +1,3 @@
-
 #ifndef SCALLOP_TK_STEREO_COMPUTATION_H_
 #define SCALLOP_TK_STEREO_COMPUTATION_H_
 
@@ -6,17 +5,66 @@
 //                               Include Files
 //------------------------------------------------------------------------------
 
+//Standard C/C++
+#include <float.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+//Opencv
+#include <cv.h>
+#include <cxcore.h>
+
 //Scallop Includes
 #include "ScallopTK/Utilities/Definitions.h"
 
 //------------------------------------------------------------------------------
-//                            Function Declarations
+//                                 Constants
 //------------------------------------------------------------------------------
 
 namespace ScallopTK
 {
 
-void computeDepthMap( cv::Mat& leftImg, cv::Mat& rightImg, cv::Mat& depthMap );
+// Image width stereo pairs are matched at when no scale is known beforehand
+const int STEREO_MATCH_WIDTH = 640;
+
+// Side of the square block matched between the left and right images
+const int STEREO_BLOCK_SIZE = 9;
+
+// Rows of the disparity map matched per parallel job
+const int STEREO_BAND_ROWS = 32;
+
+// Min mean absolute horizontal gradient in a block for a reliable match
+const float STEREO_MIN_TEXTURE = 4.0f;
+
+// Cost of matching a pixel against the outside of the right image
+const float STEREO_NO_MATCH_COST = 255.0f;
+
+//------------------------------------------------------------------------------
+//                            Function Declarations
+//------------------------------------------------------------------------------
+
+// Disparities of a rectified stereo pair, matched in parallel bands by
+// sum of absolute differences block matching with sub-pixel refinement
+//
+// Images are matched at scale (0 to 1] of their size, searching up to
+// maxDisparity full resolution pixels. The output 32f map is at the
+// matching resolution, in its pixels, and 0 wherever no reliable match
+// was found.
+void computeDisparityMap( const cv::Mat& leftImg, const cv::Mat& rightImg,
+  float scale, int maxDisparity, cv::Mat& disparity );
+
+// Meters per full resolution pixel at every pixel of a disparity map
+// matched at scale, for a camera pair baseline meters apart (0 if unknown)
+void computePixelSizeMap( const cv::Mat& disparity, float scale,
+  float baseline, cv::Mat& pixelSize );
+
+// Depth in meters at every pixel of the left image, at matching resolution,
+// for a baseline in meters and focal length in full resolution pixels
+// (0 if unknown)
+void computeDepthMap( const cv::Mat& leftImg, const cv::Mat& rightImg,
+  float baseline, float focalPixels, float scale, int maxDisparity,
+  cv::Mat& depthMap );
 
 }
 
@@ -70,6 +70,30 @@ double CBoostedCommittee::Predict(double * in_Sample)
 
 
 
+int CBoostedCommittee::MaxDimension()
+
+{
+
+  int max_dim = -1;
+
+  for (int i = 0; i < m_vHypotheses.size(); i++)
+
+  {
+
+    int dim = m_vHypotheses[i].MaxDimension();
+
+    if(dim > max_dim)
+
+      max_dim = dim;
+
+  }
+
+  return max_dim;
+
+}
+
+
+
 bool CBoostedCommittee::LoadFromFile(FILE* in_File)
 
 {
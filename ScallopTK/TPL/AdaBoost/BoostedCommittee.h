@@ -52,6 +52,10 @@ public:
 
 
 
+  int MaxDimension();
+
+
+
 protected:
 
   std::vector <CSPHypothesis> m_vHypotheses;
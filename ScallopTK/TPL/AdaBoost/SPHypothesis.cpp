@@ -74,6 +74,30 @@ double CSPHypothesis::Predict(double * in_Sample)
 
 
 
+int CSPHypothesis::MaxDimension()
+
+{
+
+  int max_dim = -1;
+
+  for (int i = 0; i < m_vDims.size(); i++)
+
+  {
+
+    if(m_vDims[i] > max_dim)
+
+      max_dim = m_vDims[i];
+
+  }
+
+  return max_dim;
+
+}
+
+
+
+
+
 void CSPHypothesis::PredictVector(double **in_vSamples, int in_iTotalSamples, double *out_vPredictions)
 
 {
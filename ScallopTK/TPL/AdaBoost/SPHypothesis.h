@@ -58,6 +58,10 @@ public:
 
 
 
+  int    MaxDimension();
+
+
+
 protected:
 
 
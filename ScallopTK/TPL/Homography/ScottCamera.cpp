@@ -333,41 +333,24 @@ float sgTriArea( sgVec3 p0, sgVec3 p1, sgVec3 p2 )
 }
 
 
-int calculateDimensions(float heading,
+// Projects the sensor corners through the principal point onto the ground
+// plane, P1-P4 are the upper left, lower left, upper right and lower right
+// sensor corners (width and height are the sensor size)
+static void projectSensorCorners(float heading,
 	float pitch,
 	float roll,
 	float altitude,
 	float width,
 	float height,
 	float focalLength,
-	float &area,
-	float &rHeight,
-	float &rWidth)
+	sgVec3 P1,
+	sgVec3 P2,
+	sgVec3 P3,
+	sgVec3 P4)
 {
-	//sgVec3 hpr;
 	sgVec4 plane;
 	sgMat4 trans;
 
-#define inch2meters 0.0254
-
-	float chip_size = (2.0/3.0)*float(inch2meters);
-
-	height = chip_size * height / width;
-	width = chip_size;
-
-#ifdef DISPLAY_CAMINFO
-	fprintf(stdout,"\n     %8.4f heading\n",heading);
-	fprintf(stdout,"     %8.4f pitch\n",pitch);
-	fprintf(stdout,"     %8.4f roll\n",roll);
-	fprintf(stdout,"     %8.4f altitude\n",altitude);
-	fprintf(stdout,"     %8.4f width\n",width);
-	fprintf(stdout,"     %8.4f height\n",height);
-	fprintf(stdout,"     %8.4f focalLength\n",focalLength);
-#endif
-
-	//float pixel_size = chip_size/width;
-
-
 	///  Principal Point and ImagePlane;
 	sgVec3 PP,UL,LL,UR,LR;
 
@@ -388,8 +371,6 @@ int calculateDimensions(float heading,
 
 #define myXformPnt3 sgXformPnt3
 
-	//sgVec3 P0,P1,P2,P3,P4;
-	sgVec3 P1,P2,P3,P4;
 	myXformPnt3 ( PP, PP, trans );
 
 #ifdef DISPLAY_CAMINFO
@@ -405,6 +386,44 @@ int calculateDimensions(float heading,
 	myIsectLinesegPlane (  P2, LL, PP,  plane );
 	myIsectLinesegPlane (  P3, UR, PP,  plane );
 	myIsectLinesegPlane (  P4, LR, PP,  plane );
+}
+
+int calculateDimensions(float heading,
+	float pitch,
+	float roll,
+	float altitude,
+	float width,
+	float height,
+	float focalLength,
+	float &area,
+	float &rHeight,
+	float &rWidth)
+{
+	//sgVec3 hpr;
+
+#define inch2meters 0.0254
+
+	float chip_size = (2.0/3.0)*float(inch2meters);
+
+	height = chip_size * height / width;
+	width = chip_size;
+
+#ifdef DISPLAY_CAMINFO
+	fprintf(stdout,"\n     %8.4f heading\n",heading);
+	fprintf(stdout,"     %8.4f pitch\n",pitch);
+	fprintf(stdout,"     %8.4f roll\n",roll);
+	fprintf(stdout,"     %8.4f altitude\n",altitude);
+	fprintf(stdout,"     %8.4f width\n",width);
+	fprintf(stdout,"     %8.4f height\n",height);
+	fprintf(stdout,"     %8.4f focalLength\n",focalLength);
+#endif
+
+	//float pixel_size = chip_size/width;
+
+
+	sgVec3 P1,P2,P3,P4;
+	projectSensorCorners(heading,pitch,roll,altitude,width,height,
+		focalLength,P1,P2,P3,P4);
 
 	area = sgTriArea(P1,P2,P3) + sgTriArea(P2,P3,P4);
 
@@ -425,3 +444,33 @@ int calculateDimensions(float heading,
 	return 0;
 }
 
+int calculateFootprint(float heading,
+	float pitch,
+	float roll,
+	float altitude,
+	float width,
+	float height,
+	float focalLength,
+	float corners[4][2])
+{
+	float chip_size = (2.0/3.0)*float(inch2meters);
+
+	height = chip_size * height / width;
+	width = chip_size;
+
+	sgVec3 P1,P2,P3,P4;
+	projectSensorCorners(heading,pitch,roll,altitude,width,height,
+		focalLength,P1,P2,P3,P4);
+
+	// The sensor image is inverted, so each image corner is seen by the
+	// opposite sensor corner
+	SGfloat *ordered[4] = { P4, P2, P1, P3 };
+
+	for( int i=0; i<4; i++ )
+	{
+		corners[i][0] = ordered[i][0];
+		corners[i][1] = ordered[i][1];
+	}
+
+	return 0;
+}
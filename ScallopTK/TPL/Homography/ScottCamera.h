@@ -84,4 +84,10 @@ int calculateDimensions(float heading, float pitch, float roll, float altitude,
   float width, float height, float focalLength, float &area, float &rHeight,
   float &rWidth);
 
+// Ground plane positions of the image corners, in pixel order (top left,
+// top right, bottom right, bottom left), in meters from the point below
+// the camera
+int calculateFootprint(float heading, float pitch, float roll, float altitude,
+  float width, float height, float focalLength, float corners[4][2]);
+
 #endif
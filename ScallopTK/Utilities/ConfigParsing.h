@@ -259,6 +259,31 @@ inline bool parseSystemConfig( SystemParameters& params, std::string location =
     params.OutputProposalImages = !strcmp( rdr.GetValue( "options", "output_proposal_images", NULL ), "true" );
     params.OutputDetectionImages = !strcmp( rdr.GetValue( "options", "output_detection_images", NULL ), "true" );
     params.NumThreads = atoi( rdr.GetValue( "options", "num_threads", "1" ) );
+    params.EnableColorAdaptation = !strcmp( rdr.GetValue( "options", "enable_color_adaptation", "false" ), "true" );
+    params.UseComponentTreeThresholding = !strcmp( rdr.GetValue( "options", "use_component_tree_thresholding", "false" ), "true" );
+    params.FrameTimeBudget = atof( rdr.GetValue( "options", "frame_time_budget", "0" ) );
+    params.FrameCandidateBudget = atoi( rdr.GetValue( "options", "frame_candidate_budget", "0" ) );
+    params.MaxBlobCandidates = atoi( rdr.GetValue( "options", "max_blob_candidates", "0" ) );
+    params.MaxAdaptiveCandidates = atoi( rdr.GetValue( "options", "max_adaptive_candidates", "0" ) );
+    params.MaxTemplateCandidates = atoi( rdr.GetValue( "options", "max_template_candidates", "0" ) );
+    params.MaxCannyCandidates = atoi( rdr.GetValue( "options", "max_canny_candidates", "0" ) );
+    params.TileSize = atoi( rdr.GetValue( "options", "tile_size", "0" ) );
+    params.EnableScreeningPass = !strcmp( rdr.GetValue( "options", "enable_screening_pass", "false" ), "true" );
+    params.ScreeningMaxCoverage = atof( rdr.GetValue( "options", "screening_max_coverage", "0.5" ) );
+    params.EnableFrameGate = !strcmp( rdr.GetValue( "options", "enable_frame_gate", "false" ), "true" );
+    params.GateMaxClippedFraction = atof( rdr.GetValue( "options", "gate_max_clipped_fraction", "0.95" ) );
+    params.GateMinContrast = atof( rdr.GetValue( "options", "gate_min_contrast", "0.02" ) );
+    params.GateMinEntropy = atof( rdr.GetValue( "options", "gate_min_entropy", "1.0" ) );
+    params.GateMinSalientFraction = atof( rdr.GetValue( "options", "gate_min_salient_fraction", "0.0001" ) );
+    params.EnableTemporalReuse = !strcmp( rdr.GetValue( "options", "enable_temporal_reuse", "false" ), "true" );
+    params.TemporalMinOverlap = atof( rdr.GetValue( "options", "temporal_min_overlap", "0.3" ) );
+    params.EnableFootprintSkipping = !strcmp( rdr.GetValue( "options", "enable_footprint_skipping", "false" ), "true" );
+    params.FootprintMaxCoverage = atof( rdr.GetValue( "options", "footprint_max_coverage", "0.95" ) );
+    params.StereoBaseline = atof( rdr.GetValue( "options", "stereo_baseline", "0" ) );
+    params.StereoMaxDisparity = atoi( rdr.GetValue( "options", "stereo_max_disparity", "256" ) );
+    params.EnableScaleMap = !strcmp( rdr.GetValue( "options", "enable_scale_map", "false" ), "true" );
+    params.ScaleMapBands = atoi( rdr.GetValue( "options", "scale_map_bands", "4" ) );
+    params.CNNBatchTimeout = atof( rdr.GetValue( "options", "cnn_batch_timeout", "0" ) );
     params.FocalLength = atof( rdr.GetValue( "options", "focal_length", NULL ) );
     params.RootConfigDIR = configDir;
     params.RootClassifierDIR = rdr.GetValue( "options", "root_classifier_dir", NULL );
@@ -320,6 +345,18 @@ inline bool parseClassifierConfig( string key, const SystemParameters& settings,
     params.EnableSDSS = !strcmp( rdr.GetValue("classifiers", "ENABLE_SAND_DOLLAR_SUPPRESSION_SYS", NULL), "true" );
     params.InitialThreshold = atof( rdr.GetValue("classifiers", "INITIAL_THRESHOLD", "0.0") );
     params.SecondThreshold = atof( rdr.GetValue("classifiers", "SECOND_THRESHOLD", "0.0") );
+    params.CascadeFiles = convertCSVLine( rdr.GetValue("classifiers", "CASCADE_FILES", ""), true );
+    params.CascadeTrainingData = removeSpaces( rdr.GetValue("classifiers", "CASCADE_TRAINING_DATA", "") );
+    params.CascadeNegativeLabels = convertCSVLine( rdr.GetValue("classifiers", "CASCADE_NEGATIVE_LABELS", "0"), true );
+    params.CascadeRecall = atof( rdr.GetValue("classifiers", "CASCADE_RECALL", "0.99") );
+
+    vector< string > cascadeThresholds =
+      convertCSVLine( rdr.GetValue("classifiers", "CASCADE_THRESHOLDS", ""), true );
+    params.CascadeThresholds.clear();
+    for( unsigned i = 0; i < cascadeThresholds.size(); i++ )
+    {
+      params.CascadeThresholds.push_back( atof( cascadeThresholds[i].c_str() ) );
+    }
 
     // Check vector sizes
     if( !params.UseCNNClassifier )
@@ -333,6 +370,14 @@ inline bool parseClassifierConfig( string key, const SystemParameters& settings,
         cout << "CRITICAL ERROR: Classifier lists in config file " << key << " are not the same length!" << endl;
         return false;
       }
+
+      if( !params.CascadeFiles.empty() && params.CascadeTrainingData.empty() &&
+        params.CascadeThresholds.size() != params.CascadeFiles.size() )
+      {
+        cout << "CRITICAL ERROR: Cascade stages in config file " << key << " need either "
+             << "CASCADE_THRESHOLDS for every stage or CASCADE_TRAINING_DATA!" << endl;
+        return false;
+      }
     }
   }
   catch(...)
@@ -344,6 +389,7 @@ inline bool parseClassifierConfig( string key, const SystemParameters& settings,
   // Append paths to files
   vector< string >& L1Files = params.L1Files;
   vector< string >& L2Files = params.L2Files;
+  vector< string >& CascadeFiles = params.CascadeFiles;
   for( unsigned i = 0; i < L1Files.size(); i++ )
   {
     if( params.ClassifierSubdir != "." && params.ClassifierSubdir != "" && params.ClassifierSubdir != " " )
@@ -358,6 +404,20 @@ inline bool parseClassifierConfig( string key, const SystemParameters& settings,
     else
       L2Files[i] = settings.RootClassifierDIR + L2Files[i];
   }
+  for( unsigned i = 0; i < CascadeFiles.size(); i++ )
+  {
+    if( params.ClassifierSubdir != "." && params.ClassifierSubdir != "" && params.ClassifierSubdir != " " )
+      CascadeFiles[i] = settings.RootClassifierDIR + params.ClassifierSubdir + CascadeFiles[i];
+    else
+      CascadeFiles[i] = settings.RootClassifierDIR + CascadeFiles[i];
+  }
+  if( !params.CascadeTrainingData.empty() )
+  {
+    if( params.ClassifierSubdir != "." && params.ClassifierSubdir != "" && params.ClassifierSubdir != " " )
+      params.CascadeTrainingData = settings.RootClassifierDIR + params.ClassifierSubdir + params.CascadeTrainingData;
+    else
+      params.CascadeTrainingData = settings.RootClassifierDIR + params.CascadeTrainingData;
+  }
 
   return true;
 }
@@ -449,6 +509,31 @@ inline void initializeDefault( SystemParameters& settings )
   settings.OutputDuplicateClass = true;
   settings.OutputDetectionImages = false;
   settings.NumThreads = 1;
+  settings.EnableColorAdaptation = false;
+  settings.UseComponentTreeThresholding = false;
+  settings.FrameTimeBudget = 0.0f;
+  settings.FrameCandidateBudget = 0;
+  settings.MaxBlobCandidates = 0;
+  settings.MaxAdaptiveCandidates = 0;
+  settings.MaxTemplateCandidates = 0;
+  settings.MaxCannyCandidates = 0;
+  settings.TileSize = 0;
+  settings.EnableScreeningPass = false;
+  settings.ScreeningMaxCoverage = 0.5f;
+  settings.EnableFrameGate = false;
+  settings.GateMaxClippedFraction = 0.95f;
+  settings.GateMinContrast = 0.02f;
+  settings.GateMinEntropy = 1.0f;
+  settings.GateMinSalientFraction = 0.0001f;
+  settings.EnableTemporalReuse = false;
+  settings.TemporalMinOverlap = 0.3f;
+  settings.EnableFootprintSkipping = false;
+  settings.FootprintMaxCoverage = 0.95f;
+  settings.StereoBaseline = 0.0f;
+  settings.StereoMaxDisparity = 256;
+  settings.EnableScaleMap = false;
+  settings.ScaleMapBands = 4;
+  settings.CNNBatchTimeout = 0.0f;
 }
 
 }
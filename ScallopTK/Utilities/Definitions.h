@@ -41,6 +41,12 @@ const std::string DEFAULT_COLORBANK_EXT = "_32f_rgb_v1.cfilt";
 // Max search depth for reading metadata contained within JPEG files
 const int MAX_META_SEARCH_DEPTH = 10000;
 
+// Min fraction of a measured (stereo) pixel size map which must be known
+const float MIN_KNOWN_PIXEL_SIZE_FRACTION = 0.10f;
+
+// Width of pixel size maps derived from the camera model
+const int PIXEL_SIZE_MAP_WIDTH = 64;
+
 // Input image type definitions
 const int UNKNOWN  = 0x00;   //.???
 const int JPEG     = 0x01;   //.jpg || .JPG
@@ -49,6 +55,16 @@ const int RAW_TIFF = 0x03;   //.tiff
 const int BMP      = 0x04;   //.bmp
 const int PNG      = 0x05;   //.png
 
+// Pixel formats of 8 bit external frame buffers, Bayer mosaics are named
+// as in OpenCV's Bayer conversion codes
+const int PIXEL_FORMAT_BGR      = 0x00;
+const int PIXEL_FORMAT_RGB      = 0x01;
+const int PIXEL_FORMAT_GRAY     = 0x02;
+const int PIXEL_FORMAT_BAYER_BG = 0x03;
+const int PIXEL_FORMAT_BAYER_GB = 0x04;
+const int PIXEL_FORMAT_BAYER_RG = 0x05;
+const int PIXEL_FORMAT_BAYER_GR = 0x06;
+
 // Scallop Display Window Name
 const std::string DISPLAY_WINDOW_NAME = "ScallopDisplayWindow";
 
@@ -92,6 +108,8 @@ const int DEFAULT_ENVI_SKIP     = 5;
 const int DEFAULT_OBJ_SKIP      = 2;
 // -Default merge ratio for syncing old w/ new histogram
 const float DEFAULT_MERGE_RATIO = 0.08f;
+// -Merge ratio contributed by each detection for object histograms
+const float DETECTION_MERGE_RATIO = 0.004f;
 
 // Special type definitions for input classification files
 const std::string BACKGROUND     = "BACKGROUND";
@@ -247,6 +265,72 @@ struct SystemParameters
 
   // Number of worker threads to allocate for processing images
   int NumThreads;
+
+  // Adapt color filters online from the detections in each frame?
+  bool EnableColorAdaptation;
+
+  // Use a single component tree for all adaptive thresholding levels?
+  bool UseComponentTreeThresholding;
+
+  // Wall clock seconds allowed per frame, 0 for no limit
+  float FrameTimeBudget;
+
+  // Max candidates to extract features for per frame, 0 for no limit
+  int FrameCandidateBudget;
+
+  // Max proposals kept from each proposal detector, 0 for no limit
+  int MaxBlobCandidates;
+  int MaxAdaptiveCandidates;
+  int MaxTemplateCandidates;
+  int MaxCannyCandidates;
+
+  // Process images larger than this many pixels on a side as overlapping
+  // tiles of about this size, 0 to always process whole images
+  int TileSize;
+
+  // Screen each image at a coarse scale first and only run the full
+  // pipeline inside the regions where salient blobs were found?
+  bool EnableScreeningPass;
+
+  // Process the whole image if screened regions cover more than this
+  // fraction of it
+  float ScreeningMaxCoverage;
+
+  // Reject frames which cannot contain targets from a thumbnail first?
+  bool EnableFrameGate;
+
+  // Frame gate thresholds, see FrameGate.h
+  float GateMaxClippedFraction;
+  float GateMinContrast;
+  float GateMinEntropy;
+  float GateMinSalientFraction;
+
+  // Streaming only, reuse the previous frame's detections where frames
+  // overlap by at least TemporalMinOverlap and process the rest
+  bool EnableTemporalReuse;
+  float TemporalMinOverlap;
+
+  // List mode only, skip parts of images whose seafloor footprint was
+  // already covered by earlier images, and whole images more than
+  // FootprintMaxCoverage covered
+  bool EnableFootprintSkipping;
+  float FootprintMaxCoverage;
+
+  // Measure per pixel scale from stereo pairs (side by side inputs or the
+  // stereo streaming interface), for cameras StereoBaseline meters apart
+  // (0 to disable) with disparities up to StereoMaxDisparity pixels
+  float StereoBaseline;
+  int StereoMaxDisparity;
+
+  // Derive per pixel scale from the camera model (pitch and roll), and
+  // process images in ScaleMapBands bands along the direction of scale
+  // change, each searching only the radii valid within it
+  bool EnableScaleMap;
+  int ScaleMapBands;
+
+  // CNN classifiers only, seconds a partly filled batch waits for chips
+  // from other concurrently processed frames before it is run
+  float CNNBatchTimeout;
 };
 
 
@@ -281,6 +365,13 @@ struct ClassifierParameters
 
   // Classifier threshold
   double SecondThreshold;
+
+  // Optional early rejection cascade, run on size and color features only
+  std::vector< std::string > CascadeFiles;
+  std::vector< double > CascadeThresholds;
+  std::string CascadeTrainingData;
+  std::vector< std::string > CascadeNegativeLabels;
+  double CascadeRecall;
 };
 
 
@@ -380,12 +471,12 @@ struct Candidate
   // Edge Based Features
   bool hasEdgeFeatures;
   double edgeFeatures[EDGE_FEATURES];
-
   // Expensive edge search results
+  // Expensive edge search results, contours are shared with detections
   float innerColorAvg[3];
   float outerColorAvg[3];
-  Contour *bestContour;
-  Contour *fullContour;
+  cv::Ptr<Contour> bestContour;
+  cv::Ptr<Contour> fullContour;
 
   // User entered designation, Candidate filename if in training mode
   int designation;
@@ -398,9 +489,7 @@ struct Candidate
   // Default constructor
   Candidate()
   : summaryImage( NULL ),
-    colorQuadrants( NULL ),
-    bestContour( NULL ),
-    fullContour( NULL )
+    colorQuadrants( NULL )
   {
     for( unsigned i = 0; i < NUM_HOG; i++ )
     {
@@ -442,6 +531,59 @@ struct Detection
   bool isSandDollar;
 };
 
+// Frame pre-gate results, why a frame was rejected before processing
+const int GATE_PASSED        = 0x00;
+const int GATE_UNDEREXPOSED  = 0x01;
+const int GATE_OVEREXPOSED   = 0x02;
+const int GATE_LOW_CONTRAST  = 0x03;
+const int GATE_LOW_ENTROPY   = 0x04;
+const int GATE_LOW_SALIENCY  = 0x05;
+const int GATE_RESULTS       = 0x06;
+
+// Work done on the last processed frame, and how much was left undone
+// because of per-detector caps or the per-frame budget
+struct FrameStatistics
+{
+  // Pre-gate result, GATE_PASSED unless the frame was rejected outright
+  int GateResult;
+
+  // Candidates remaining after consolidation
+  unsigned TotalCandidates;
+
+  // Candidates which went through feature extraction and classification
+  unsigned ProcessedCandidates;
+
+  // Candidates never looked at because the frame budget ran out
+  unsigned SkippedCandidates;
+
+  // Proposals dropped by the per-detector caps before consolidation
+  unsigned CappedCandidates;
+
+  // Detections carried over from the previous frame of a sequence
+  unsigned CarriedDetections;
+
+  // Fraction of the frame which went through the detector
+  float ProcessedFraction;
+
+  // Did the frame stop early because of its time or candidate budget?
+  bool BudgetExhausted;
+
+  // Wall clock seconds spent on the frame
+  double ElapsedSeconds;
+
+  FrameStatistics()
+  : GateResult( GATE_PASSED ),
+    TotalCandidates( 0 ),
+    ProcessedCandidates( 0 ),
+    SkippedCandidates( 0 ),
+    CappedCandidates( 0 ),
+    CarriedDetections( 0 ),
+    ProcessedFraction( 1.0f ),
+    BudgetExhausted( false ),
+    ElapsedSeconds( 0.0 )
+  {}
+};
+
 typedef std::vector<Candidate*> CandidatePtrVector;
 typedef std::vector<Detection*> DetectionPtrVector;
 
@@ -0,0 +1,148 @@
+
+#include "FastStatistics.h"
+
+namespace ScallopTK
+{
+
+//------------------------------------------------------------------------------
+//                            Function Definitions
+//------------------------------------------------------------------------------
+
+int fsSampleStride( int pixels, int maxSamples, int minStride ) {
+  int stride = ( maxSamples > 0 ? pixels / maxSamples : 1 );
+  return max( stride, max( minStride, 1 ) );
+}
+
+void fsSampleImage( IplImage *img, int stride, fsSamples& samples ) {
+
+  assert( img->depth == IPL_DEPTH_32F && img->nChannels == 1 );
+
+  const int width = img->width;
+  const int pixels = img->width * img->height;
+  samples.values.clear();
+  samples.values.reserve( pixels / stride + 1 );
+  samples.minVal = FLT_MAX;
+  samples.maxVal = -FLT_MAX;
+
+  for( int i = 0; i < pixels; i += stride ) {
+    float value = ((float*)(img->imageData + img->widthStep*(i/width)))[i%width];
+    samples.values.push_back( value );
+    samples.minVal = min( samples.minVal, value );
+    samples.maxVal = max( samples.maxVal, value );
+  }
+}
+
+int fsCountAtOrBelow( const fsSamples& samples, float value ) {
+  int count = 0;
+  for( size_t i = 0; i < samples.values.size(); i++ ) {
+    if( samples.values[i] <= value ) {
+      count++;
+    }
+  }
+  return count;
+}
+
+// Rank selection on the whole array, ranks visited in increasing order so
+// that each nth_element only partitions what is left above the last rank
+static void fsSelectRanksUnbounded( vector<float>& values, const int *ranks,
+  int count, float *output ) {
+
+  vector< pair<int,int> > order( count );
+  for( int i = 0; i < count; i++ ) {
+    order[i] = make_pair( ranks[i], i );
+  }
+  sort( order.begin(), order.end() );
+
+  int lo = 0;
+  for( int i = 0; i < count; i++ ) {
+    int rank = order[i].first;
+    nth_element( values.begin() + lo, values.begin() + rank, values.end() );
+    output[ order[i].second ] = values[rank];
+    lo = rank;
+  }
+}
+
+void fsSelectRanks( fsSamples& samples, const int *ranks, int count, float *output ) {
+
+  vector<float>& values = samples.values;
+  const int entries = values.size();
+  if( entries == 0 ) {
+    for( int i = 0; i < count; i++ ) {
+      output[i] = 0.0f;
+    }
+    return;
+  }
+
+  // Clamp requested ranks
+  vector<int> clamped( count );
+  for( int i = 0; i < count; i++ ) {
+    clamped[i] = min( max( ranks[i], 0 ), entries-1 );
+  }
+
+  // Empty or unbounded (inf/nan) range, no histogram possible
+  const double range = (double)samples.maxVal - (double)samples.minVal;
+  if( !( range > 0.0 && range < FLT_MAX ) ) {
+    fsSelectRanksUnbounded( values, &clamped[0], count, output );
+    return;
+  }
+
+  // Single histogram pass over the samples
+  const double scale = FS_HISTOGRAM_BINS / range;
+  const float minVal = samples.minVal;
+  vector<int> bins( entries );
+  vector<int> hist( FS_HISTOGRAM_BINS+1, 0 );
+  for( int i = 0; i < entries; i++ ) {
+    int bin = (int)( ( values[i] - minVal ) * scale );
+    bin = min( max( bin, 0 ), FS_HISTOGRAM_BINS-1 );
+    bins[i] = bin;
+    hist[bin+1]++;
+  }
+  for( int b = 1; b <= FS_HISTOGRAM_BINS; b++ ) {
+    hist[b] += hist[b-1];
+  }
+
+  // Locate the bin holding each rank, hist[b] is the rank of bin b's first entry
+  vector<int> rankBin( count );
+  vector<int> slot( FS_HISTOGRAM_BINS, -1 );
+  int slots = 0;
+  for( int i = 0; i < count; i++ ) {
+    int bin = upper_bound( hist.begin(), hist.end(), clamped[i] ) - hist.begin() - 1;
+    rankBin[i] = bin;
+    if( slot[bin] == -1 ) {
+      slot[bin] = slots++;
+    }
+  }
+
+  // Gather only the contents of needed bins, then select within them
+  vector< vector<float> > contents( slots );
+  for( int i = 0; i < entries; i++ ) {
+    if( slot[bins[i]] != -1 ) {
+      contents[ slot[bins[i]] ].push_back( values[i] );
+    }
+  }
+  for( int i = 0; i < count; i++ ) {
+    vector<float>& binValues = contents[ slot[rankBin[i]] ];
+    int local = clamped[i] - hist[rankBin[i]];
+    nth_element( binValues.begin(), binValues.begin() + local, binValues.end() );
+    output[i] = binValues[local];
+  }
+}
+
+void fsQuantiles( IplImage *img, int stride, const float *q, int count, float *output ) {
+  fsSamples samples;
+  fsSampleImage( img, stride, samples );
+  vector<int> ranks( count );
+  for( int i = 0; i < count; i++ ) {
+    ranks[i] = (int)( q[i] * samples.values.size() );
+  }
+  fsSelectRanks( samples, &ranks[0], count, output );
+}
+
+float fsMedian( IplImage *img, int stride ) {
+  const float half = 0.5f;
+  float median;
+  fsQuantiles( img, stride, &half, 1, &median );
+  return median;
+}
+
+}
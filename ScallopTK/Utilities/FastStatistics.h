@@ -0,0 +1,66 @@
+#ifndef SCALLOP_TK_FAST_STATISTICS_H_
+#define SCALLOP_TK_FAST_STATISTICS_H_
+
+//------------------------------------------------------------------------------
+//                               Include Files
+//------------------------------------------------------------------------------
+
+//Standard C/C++
+#include <float.h>
+#include <assert.h>
+#include <vector>
+#include <algorithm>
+
+//Opencv
+#include <cv.h>
+#include <cxcore.h>
+
+namespace ScallopTK
+{
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+//                                 Constants
+//------------------------------------------------------------------------------
+
+// Histogram resolution used to locate quantiles within the sample range
+const int FS_HISTOGRAM_BINS = 256;
+
+//------------------------------------------------------------------------------
+//                                Prototypes
+//------------------------------------------------------------------------------
+
+// Strided samples of a single channel 32f image and their value range
+struct fsSamples {
+  vector<float> values;
+  float minVal;
+  float maxVal;
+};
+
+// Stride giving roughly maxSamples samples, but never less than minStride
+int fsSampleStride( int pixels, int maxSamples, int minStride = 1 );
+
+// Collects every stride-th pixel in raster order, and the sample range
+void fsSampleImage( IplImage *img, int stride, fsSamples& samples );
+
+// Number of samples less than or equal to value
+int fsCountAtOrBelow( const fsSamples& samples, float value );
+
+// Finds the samples at the given sorted-order ranks (0 to N-1) exactly
+//
+// A single histogram pass over the sample range locates the bin of every
+// rank, then each is resolved with nth_element within its bin only. If
+// the range is empty or unbounded, nth_element is used on all samples.
+// Sample order is not preserved.
+void fsSelectRanks( fsSamples& samples, const int *ranks, int count, float *output );
+
+// Quantiles q (0 to 1) of every stride-th pixel of img
+void fsQuantiles( IplImage *img, int stride, const float *q, int count, float *output );
+
+// Median of every stride-th pixel of img
+float fsMedian( IplImage *img, int stride );
+
+}
+
+#endif
@@ -575,21 +575,8 @@ void saveCandidates( IplImage *img, CandidatePtrVector& cds, const string& fn )
 }
 
 float quickMedian( IplImage* img, int max_to_sample ) {
-  float *ptr = (float*) img->imageData;
-  int sze = img->width * img->height;
-  float *endptr = ptr + sze;
-  int skippage = 20;
-  if( sze / max_to_sample > 20 )
-    skippage = sze / max_to_sample;
-  vector<float> val_list(sze/skippage+1,0.0f);
-  int counter = 0;
-  while( ptr < endptr ) {
-    val_list[counter] = *ptr;
-    counter++;
-    ptr = ptr + skippage;
-  }
-  sort( val_list.begin(), val_list.end() );
-  return val_list[0.5f*sze/skippage];
+  int stride = fsSampleStride( img->width * img->height, max_to_sample, 20 );
+  return fsMedian( img, stride );
 }
 
 void showIPNW( IplImage* img, IplImage *img2, Candidate *ip ) {
@@ -742,6 +729,12 @@ void resizeDetections( DetectionVector& d, float f )
     d[i].c = d[i].c * f;
     d[i].major = d[i].major * f;
     d[i].minor = d[i].minor * f;
+
+    for( unsigned j = 0; j < d[i].cntr.pts.size(); j++ )
+    {
+      d[i].cntr.pts[j].r = (int)( d[i].cntr.pts[j].r * f + 0.5f );
+      d[i].cntr.pts[j].c = (int)( d[i].cntr.pts[j].c * f + 0.5f );
+    }
   }
 }
 
@@ -22,6 +22,7 @@
 
 // Scallop Includes
 #include "ScallopTK/Utilities/Definitions.h"
+#include "ScallopTK/Utilities/FastStatistics.h"
 
 // Namespaces
 using namespace std;
@@ -0,0 +1,169 @@
+#ifndef SCALLOP_TK_MEMORY_MAPPING_H_
+#define SCALLOP_TK_MEMORY_MAPPING_H_
+
+// C/C++ Includes
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <stdio.h>
+
+// For Windows
+#ifdef WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+namespace ScallopTK
+{
+
+using namespace std;
+
+// Read-only view of an entire file on disk
+//
+// The file is memory mapped when the OS allows it, so that identical
+// files opened by many objects are backed by the same physical pages.
+// If mapping fails the contents are read into a heap buffer instead.
+class MappedFile
+{
+public:
+
+  MappedFile() : ptr( NULL ), length( 0 ), isMapped( false ) {
+#ifdef WIN32
+    fileHandle = INVALID_HANDLE_VALUE;
+    mapHandle = NULL;
+#endif
+  }
+
+  ~MappedFile() { close(); }
+
+  // Opens the given file, returns false on failure
+  bool open( const string& filename );
+
+  // Unmaps or frees any open file
+  void close();
+
+  // Accessors for file contents
+  const char* data() const { return ptr; }
+  size_t size() const { return length; }
+  bool isValid() const { return ptr != NULL; }
+
+private:
+
+  // Fallback if the file can't be mapped
+  bool readToBuffer( const string& filename );
+
+  // Pointer to file contents and length in bytes
+  char *ptr;
+  size_t length;
+
+  // Is ptr a mapped view (true) or heap buffer (false)
+  bool isMapped;
+
+#ifdef WIN32
+  HANDLE fileHandle;
+  HANDLE mapHandle;
+#endif
+
+  // Not copyable
+  MappedFile( const MappedFile& );
+  MappedFile& operator=( const MappedFile& );
+};
+
+inline bool MappedFile::readToBuffer( const string& filename ) {
+  ifstream fin( filename.c_str(), ios::in | ios::binary );
+  if( !fin.is_open() )
+    return false;
+  fin.seekg( 0, ios::end );
+  length = (size_t)fin.tellg();
+  fin.seekg( 0, ios::beg );
+  ptr = new char[ length > 0 ? length : 1 ];
+  fin.read( ptr, length );
+  isMapped = false;
+  return true;
+}
+
+#ifdef WIN32
+
+inline bool MappedFile::open( const string& filename ) {
+  close();
+  fileHandle = CreateFileA( filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+    NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+  if( fileHandle == INVALID_HANDLE_VALUE )
+    return false;
+  LARGE_INTEGER fileSize;
+  if( GetFileSizeEx( fileHandle, &fileSize ) && fileSize.QuadPart > 0 ) {
+    mapHandle = CreateFileMapping( fileHandle, NULL, PAGE_READONLY, 0, 0, NULL );
+    if( mapHandle != NULL ) {
+      ptr = (char*)MapViewOfFile( mapHandle, FILE_MAP_READ, 0, 0, 0 );
+      if( ptr != NULL ) {
+        length = (size_t)fileSize.QuadPart;
+        isMapped = true;
+        return true;
+      }
+      CloseHandle( mapHandle );
+      mapHandle = NULL;
+    }
+  }
+  CloseHandle( fileHandle );
+  fileHandle = INVALID_HANDLE_VALUE;
+  return readToBuffer( filename );
+}
+
+inline void MappedFile::close() {
+  if( ptr != NULL && isMapped )
+    UnmapViewOfFile( ptr );
+  else if( ptr != NULL )
+    delete[] ptr;
+  if( mapHandle != NULL )
+    CloseHandle( mapHandle );
+  if( fileHandle != INVALID_HANDLE_VALUE )
+    CloseHandle( fileHandle );
+  mapHandle = NULL;
+  fileHandle = INVALID_HANDLE_VALUE;
+  ptr = NULL;
+  length = 0;
+  isMapped = false;
+}
+
+// For Unix
+#else
+
+inline bool MappedFile::open( const string& filename ) {
+  close();
+  int fd = ::open( filename.c_str(), O_RDONLY );
+  if( fd < 0 )
+    return false;
+  struct stat fileprop;
+  if( fstat( fd, &fileprop ) == 0 && fileprop.st_size > 0 ) {
+    void *view = mmap( NULL, fileprop.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+    if( view != MAP_FAILED ) {
+      ::close( fd );
+      ptr = (char*)view;
+      length = (size_t)fileprop.st_size;
+      isMapped = true;
+      return true;
+    }
+  }
+  ::close( fd );
+  return readToBuffer( filename );
+}
+
+inline void MappedFile::close() {
+  if( ptr != NULL && isMapped )
+    munmap( ptr, length );
+  else if( ptr != NULL )
+    delete[] ptr;
+  ptr = NULL;
+  length = 0;
+  isMapped = false;
+}
+
+#endif
+
+}
+
+#endif
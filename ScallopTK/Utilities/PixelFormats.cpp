@@ -0,0 +1,115 @@
+
+#include "PixelFormats.h"
+
+namespace ScallopTK
+{
+
+//------------------------------------------------------------------------------
+//                                 Helpers
+//------------------------------------------------------------------------------
+
+// Resizes only if needed, using the same interpolation as the detector
+static void resizeIfNeeded( const cv::Mat& input, cv::Size size, cv::Mat& output ) {
+  if( input.size() == size ) {
+    output = input;
+  } else {
+    cv::resize( input, output, size );
+  }
+}
+
+// Row and column of the red sample in each 2x2 Bayer quad, blue is opposite
+static void bayerRedOffset( int format, int& row, int& col ) {
+  row = ( format == PIXEL_FORMAT_BAYER_RG || format == PIXEL_FORMAT_BAYER_GR );
+  col = ( format == PIXEL_FORMAT_BAYER_GB || format == PIXEL_FORMAT_BAYER_RG );
+}
+
+// Demosaics by collapsing every 2x2 quad into one BGR pixel, greens averaged
+static void demosaicHalfSize( const cv::Mat& input, int format, cv::Mat& output ) {
+
+  int redRow, redCol;
+  bayerRedOffset( format, redRow, redCol );
+
+  output.create( input.rows / 2, input.cols / 2, CV_8UC3 );
+
+  for( int r = 0; r < output.rows; r++ ) {
+    const unsigned char *red = input.ptr<unsigned char>( 2*r + redRow ) + redCol;
+    const unsigned char *blue = input.ptr<unsigned char>( 2*r + 1 - redRow ) + 1 - redCol;
+    const unsigned char *green1 = input.ptr<unsigned char>( 2*r + redRow ) + 1 - redCol;
+    const unsigned char *green2 = input.ptr<unsigned char>( 2*r + 1 - redRow ) + redCol;
+    unsigned char *out = output.ptr<unsigned char>( r );
+
+    for( int c = 0; c < output.cols; c++, out += 3 ) {
+      out[0] = blue[2*c];
+      out[1] = (unsigned char)( ( green1[2*c] + green2[2*c] + 1 ) >> 1 );
+      out[2] = red[2*c];
+    }
+  }
+}
+
+static int bayerConversionCode( int format ) {
+  switch( format ) {
+    case PIXEL_FORMAT_BAYER_BG: return CV_BayerBG2BGR;
+    case PIXEL_FORMAT_BAYER_GB: return CV_BayerGB2BGR;
+    case PIXEL_FORMAT_BAYER_RG: return CV_BayerRG2BGR;
+    default: return CV_BayerGR2BGR;
+  }
+}
+
+//------------------------------------------------------------------------------
+//                            Function Definitions
+//------------------------------------------------------------------------------
+
+int pixelFormatChannels( int format ) {
+  switch( format ) {
+    case PIXEL_FORMAT_BGR:
+    case PIXEL_FORMAT_RGB:
+      return 3;
+    case PIXEL_FORMAT_GRAY:
+    case PIXEL_FORMAT_BAYER_BG:
+    case PIXEL_FORMAT_BAYER_GB:
+    case PIXEL_FORMAT_BAYER_RG:
+    case PIXEL_FORMAT_BAYER_GR:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+void convertPixelFormat( const cv::Mat& input, int format, cv::Size size,
+  cv::Mat& output ) {
+
+  cv::Mat resized;
+
+  switch( format ) {
+
+    case PIXEL_FORMAT_BGR:
+      resizeIfNeeded( input, size, output );
+      break;
+
+    // Channel order and grey expansion are per pixel, so resize first
+    case PIXEL_FORMAT_RGB:
+      resizeIfNeeded( input, size, resized );
+      cv::cvtColor( resized, output, CV_RGB2BGR );
+      break;
+
+    case PIXEL_FORMAT_GRAY:
+      resizeIfNeeded( input, size, resized );
+      cv::cvtColor( resized, output, CV_GRAY2BGR );
+      break;
+
+    // Mosaics must be demosaiced first, at half size when that is enough
+    default:
+      if( 2 * size.width <= input.cols && 2 * size.height <= input.rows ) {
+        cv::Mat half;
+        demosaicHalfSize( input, format, half );
+        resizeIfNeeded( half, size, output );
+      } else {
+        cv::Mat full;
+        cv::cvtColor( input, full, bayerConversionCode( format ) );
+        resizeIfNeeded( full, size, output );
+      }
+      break;
+  }
+}
+
+}
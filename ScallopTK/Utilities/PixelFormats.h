@@ -0,0 +1,36 @@
+#ifndef SCALLOP_TK_PIXEL_FORMATS_H_
+#define SCALLOP_TK_PIXEL_FORMATS_H_
+
+//------------------------------------------------------------------------------
+//                               Include Files
+//------------------------------------------------------------------------------
+
+//Opencv
+#include <cv.h>
+#include <cxcore.h>
+
+//Scallop Includes
+#include "ScallopTK/Utilities/Definitions.h"
+
+namespace ScallopTK
+{
+
+//------------------------------------------------------------------------------
+//                                Prototypes
+//------------------------------------------------------------------------------
+
+// Channels in a frame buffer of the given PIXEL_FORMAT_*, 0 if unknown
+int pixelFormatChannels( int format );
+
+// Converts a frame of any PIXEL_FORMAT_* to the 3 channel BGR layout the
+// detector works in, resized to size in the same step
+//
+// Work is ordered so that pixels are converted at the smaller size where
+// possible, and Bayer mosaics downscaled by 2 or more are demosaiced at half
+// resolution directly. Full size BGR input is returned without a copy.
+void convertPixelFormat( const cv::Mat& input, int format, cv::Size size,
+  cv::Mat& output );
+
+}
+
+#endif
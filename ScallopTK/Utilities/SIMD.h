@@ -0,0 +1,35 @@
+#ifndef SCALLOP_TK_SIMD_H_
+#define SCALLOP_TK_SIMD_H_
+
+// Enables SSE2 code paths when the compiler targets SSE2 (always the case
+// on x86-64). Every SSE2 block must have an equivalent scalar fallback, and
+// SCALLOP_TK_DISABLE_SIMD can be defined to force the scalar paths.
+#if !defined( SCALLOP_TK_DISABLE_SIMD ) && \
+    ( defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) )
+  #define SCALLOP_TK_SSE2 1
+  #include <emmintrin.h>
+#else
+  #define SCALLOP_TK_SSE2 0
+#endif
+
+namespace ScallopTK
+{
+
+#if SCALLOP_TK_SSE2
+
+// Per-lane select, returns a where mask is set else b
+inline __m128 selectPS( __m128 mask, __m128 a, __m128 b ) {
+  return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+}
+
+// Per-lane absolute value
+inline __m128 absPS( __m128 a ) {
+  return _mm_and_ps( a, _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) ) );
+}
+
+#endif
+
+}
+
+#endif
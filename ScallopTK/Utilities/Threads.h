@@ -19,6 +19,14 @@
 // Scallop Includes
 #include "Definitions.h"
 
+// Platform Includes
+#ifdef WIN32
+  #include <windows.h>
+#else
+  #include <pthread.h>
+  #include <time.h>
+#endif
+
 namespace ScallopTK
 {
 
@@ -29,6 +37,196 @@ namespace ScallopTK
 const int MAX_THREADS = 64;
 extern int THREADS;
 
+//------------------------------------------------------------------------------
+//                              Atomic Operations
+//------------------------------------------------------------------------------
+
+// Full memory barrier
+inline void memoryBarrier() {
+#ifdef WIN32
+  MemoryBarrier();
+#else
+  __sync_synchronize();
+#endif
+}
+
+// Reads a pointer written by other threads, later reads can't move before it
+inline void* atomicLoadPointer( void* volatile* target ) {
+  void* value = *target;
+  memoryBarrier();
+  return value;
+}
+
+// Writes a pointer read by other threads, earlier writes can't move after it
+inline void atomicStorePointer( void* volatile* target, void* value ) {
+  memoryBarrier();
+  *target = value;
+  memoryBarrier();
+}
+
+// Atomically replaces a pointer, returning the prior value (full barrier)
+inline void* atomicExchangePointer( void* volatile* target, void* value ) {
+#ifdef WIN32
+  return InterlockedExchangePointer( (PVOID volatile*)target, value );
+#else
+  void* prior;
+  do {
+    prior = *target;
+  } while( !__sync_bool_compare_and_swap( target, prior, value ) );
+  return prior;
+#endif
+}
+
+//------------------------------------------------------------------------------
+//                              Thread Primitives
+//------------------------------------------------------------------------------
+
+// Mutex paired with a condition variable, for hand offs between threads
+class Monitor {
+public:
+
+  Monitor() {
+#ifdef WIN32
+    InitializeCriticalSection( &section );
+    InitializeConditionVariable( &condition );
+#else
+    pthread_mutex_init( &mutex, NULL );
+    pthread_cond_init( &condition, NULL );
+#endif
+  }
+
+  ~Monitor() {
+#ifdef WIN32
+    DeleteCriticalSection( &section );
+#else
+    pthread_cond_destroy( &condition );
+    pthread_mutex_destroy( &mutex );
+#endif
+  }
+
+  void lock() {
+#ifdef WIN32
+    EnterCriticalSection( &section );
+#else
+    pthread_mutex_lock( &mutex );
+#endif
+  }
+
+  void unlock() {
+#ifdef WIN32
+    LeaveCriticalSection( &section );
+#else
+    pthread_mutex_unlock( &mutex );
+#endif
+  }
+
+  // Unlocks, waits to be notified, then relocks (must hold the lock)
+  void wait() {
+#ifdef WIN32
+    SleepConditionVariableCS( &condition, &section, INFINITE );
+#else
+    pthread_cond_wait( &condition, &mutex );
+#endif
+  }
+
+  // As wait, but returns after at most seconds even if not notified
+  void wait( double seconds ) {
+#ifdef WIN32
+    SleepConditionVariableCS( &condition, &section, (DWORD)( seconds * 1000.0 ) );
+#else
+    timespec deadline;
+    clock_gettime( CLOCK_REALTIME, &deadline );
+    long long nsec = deadline.tv_nsec + (long long)( seconds * 1e9 );
+    deadline.tv_sec += (time_t)( nsec / 1000000000LL );
+    deadline.tv_nsec = (long)( nsec % 1000000000LL );
+    pthread_cond_timedwait( &condition, &mutex, &deadline );
+#endif
+  }
+
+  // Wakes all waiting threads
+  void notifyAll() {
+#ifdef WIN32
+    WakeAllConditionVariable( &condition );
+#else
+    pthread_cond_broadcast( &condition );
+#endif
+  }
+
+private:
+
+  // Not copyable
+  Monitor( const Monitor& );
+  Monitor& operator=( const Monitor& );
+
+#ifdef WIN32
+  CRITICAL_SECTION section;
+  CONDITION_VARIABLE condition;
+#else
+  pthread_mutex_t mutex;
+  pthread_cond_t condition;
+#endif
+};
+
+// Holds a Monitor locked for its lifetime
+class MonitorLock {
+public:
+  explicit MonitorLock( Monitor& monitor ) : monitor( monitor ) { monitor.lock(); }
+  ~MonitorLock() { monitor.unlock(); }
+private:
+  Monitor& monitor;
+};
+
+// Native handle of a thread started by startThread
+#ifdef WIN32
+typedef HANDLE ThreadHandle;
+#else
+typedef pthread_t ThreadHandle;
+#endif
+
+// Routine run by a thread, as with pthreads
+typedef void* (*ThreadRoutine)( void* );
+
+#ifdef WIN32
+struct ThreadLaunch {
+  ThreadRoutine routine;
+  void* arg;
+};
+
+inline DWORD WINAPI threadTrampoline( LPVOID param ) {
+  ThreadLaunch launch = *(ThreadLaunch*)param;
+  delete (ThreadLaunch*)param;
+  launch.routine( launch.arg );
+  return 0;
+}
+#endif
+
+// Runs routine( arg ) on a new thread, returns false on failure
+inline bool startThread( ThreadHandle& handle, ThreadRoutine routine, void* arg ) {
+#ifdef WIN32
+  ThreadLaunch* launch = new ThreadLaunch;
+  launch->routine = routine;
+  launch->arg = arg;
+  handle = CreateThread( NULL, 0, threadTrampoline, launch, 0, NULL );
+  if( handle == NULL ) {
+    delete launch;
+    return false;
+  }
+  return true;
+#else
+  return pthread_create( &handle, NULL, routine, arg ) == 0;
+#endif
+}
+
+// Waits for a thread started by startThread to return
+inline void joinThread( ThreadHandle& handle ) {
+#ifdef WIN32
+  WaitForSingleObject( handle, INFINITE );
+  CloseHandle( handle );
+#else
+  pthread_join( handle, NULL );
+#endif
+}
+
 //------------------------------------------------------------------------------
 //                                  PThreads
 //------------------------------------------------------------------------------